@@ -0,0 +1 @@
+#include "../source/molecule/atommask.h"
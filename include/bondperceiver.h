@@ -0,0 +1 @@
+#include "../source/molecule/bondperceiver.h"
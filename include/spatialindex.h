@@ -0,0 +1 @@
+#include "../source/system/spatialindex.h"
@@ -0,0 +1 @@
+#include "../source/system/systemsnapshot.h"
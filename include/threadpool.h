@@ -0,0 +1 @@
+#include "../source/system/threadpool.h"
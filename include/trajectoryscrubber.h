@@ -0,0 +1 @@
+#include "../source/gui/trajectoryscrubber.h"
@@ -0,0 +1,397 @@
+/*
+ * Copyright 2014 - 2019 Jan von Cosel & Sebastian Lenz
+ *
+ * This file is part of molconv.
+ *
+ * molconv is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * molconv is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have recieved a copy of the GNU General Public License
+ * along with molconv. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include <fstream>
+#include <iomanip>
+#include <stdexcept>
+#include <QString>
+#ifndef Q_MOC_RUN
+    #include<chemkit/moleculefile.h>
+#endif
+#include "molecule.h"
+#include "system.h"
+#include "molconvfile.h"
+#include "xyztrajectory.h"
+#include "moleculeexporter.h"
+#include "batchjob.h"
+
+
+namespace molconv
+{
+    ///
+    /// \brief BatchJob::BatchJob
+    ///
+    /// by default, the molecules get the same origin and basis as in the import dialog
+    ///
+    BatchJob::BatchJob()
+        : m_originCode(kCenterOfGeometry)
+        , m_originFactor(0.5)
+        , m_basisCode(kCovarianceVectors)
+    {
+        m_originAtoms.fill(0);
+        m_basisAtoms.fill(0);
+    }
+
+    ///
+    /// \brief BatchJob::setOrigin
+    /// \param code
+    /// \param atoms
+    /// \param factor
+    ///
+    /// set the origin that is given to all molecules imported afterwards
+    ///
+    void BatchJob::setOrigin(const OriginCode code, const std::array<size_t,2> &atoms, const double factor)
+    {
+        m_originCode = code;
+        m_originAtoms = atoms;
+        m_originFactor = factor;
+    }
+
+    ///
+    /// \brief BatchJob::setBasis
+    /// \param code
+    /// \param atoms
+    ///
+    /// set the basis that is given to all molecules imported afterwards
+    ///
+    void BatchJob::setBasis(const BasisCode code, const std::array<size_t,3> &atoms)
+    {
+        m_basisCode = code;
+        m_basisAtoms = atoms;
+    }
+
+    ///
+    /// \brief BatchJob::import
+    /// \param fileName
+    /// \return
+    ///
+    /// add all molecules from the file \p fileName to the system. Molconv session files
+    /// keep their stored origin and basis, all other files get the current settings.
+    ///
+    bool BatchJob::import(const std::string &fileName)
+    {
+        QString qFileName = QString::fromStdString(fileName);
+
+        if (MolconvFile::isMolconvFile(qFileName))
+        {
+            MolconvFile file;
+            if (!file.read(qFileName))
+            {
+                m_errorString = "could not read molconv file " + fileName;
+                return false;
+            }
+
+            for (auto const& molecule : file.molecules())
+                addMolecule(molecule);
+
+            return true;
+        }
+
+        chemkit::MoleculeFile molFile(fileName);
+        if (!molFile.read())
+        {
+            m_errorString = "could not read molecule file " + fileName + ": " + molFile.errorString();
+            return false;
+        }
+
+        if (molFile.moleculeCount() == 0)
+        {
+            m_errorString = "no molecule found in file " + fileName;
+            return false;
+        }
+
+        std::string baseName = qFileName.split("/").last().split(".").first().toStdString();
+
+        for (size_t i = 0; i < molFile.moleculeCount(); i++)
+        {
+            moleculePtr newMolecule(new Molecule(molFile.molecule(i)));
+
+            if (!checkAtoms(*newMolecule, fileName))
+                return false;
+
+            AtomMask atomList(newMolecule->size(), true);
+            try
+            {
+                newMolecule->setOrigin(m_originCode, atomList, m_originAtoms[0], m_originAtoms[1], m_originFactor);
+                newMolecule->setBasis(m_basisCode, atomList, m_basisAtoms[0], m_basisAtoms[1], m_basisAtoms[2]);
+            }
+            catch (const std::invalid_argument &)
+            {
+                m_errorString = "could not set up the origin and basis of molecule " + std::to_string(i + 1) + " in " + fileName;
+                return false;
+            }
+
+            if (molFile.moleculeCount() > 1)
+                newMolecule->setName(baseName + "_" + std::to_string(i + 1));
+            else
+                newMolecule->setName(baseName);
+
+            addMolecule(newMolecule);
+        }
+
+        return true;
+    }
+
+    ///
+    /// \brief BatchJob::align
+    /// \param reference
+    /// \return
+    ///
+    /// align all molecules to the one with the index \p reference (in the order of import)
+    ///
+    bool BatchJob::align(const size_t reference)
+    {
+        if (reference >= m_molIDs.size())
+        {
+            m_errorString = "the reference molecule " + std::to_string(reference) + " does not exist";
+            return false;
+        }
+
+        std::vector<unsigned long> others;
+        for (size_t i = 0; i < m_molIDs.size(); i++)
+        {
+            if (i != reference)
+                others.push_back(m_molIDs[i]);
+        }
+
+        std::vector<double> rmsds = System::get().alignMoleculesTo(m_molIDs[reference], others);
+
+        for (auto rmsd : rmsds)
+        {
+            if (rmsd < 0.0)
+            {
+                m_errorString = "only molecules with equal number of atoms can be aligned";
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    ///
+    /// \brief BatchJob::rmsdMatrix
+    /// \return
+    ///
+    /// the RMSD after optimal superposition between all pairs of imported molecules
+    ///
+    Eigen::MatrixXd BatchJob::rmsdMatrix() const
+    {
+        return System::get().rmsdMatrix(m_molIDs);
+    }
+
+    ///
+    /// \brief BatchJob::exportTo
+    /// \param fileName
+    /// \return
+    ///
+    /// write all molecules to the file \p fileName. The format is chosen from its
+    /// extension, molconv session files (e.g. ".mcv") contain the whole system.
+    ///
+    bool BatchJob::exportTo(const std::string &fileName)
+    {
+        QString qFileName = QString::fromStdString(fileName);
+
+        if (MolconvFile::isMolconvFile(qFileName))
+        {
+            MolconvFile file;
+            if (!file.write(qFileName))
+            {
+                m_errorString = "could not write molconv file " + fileName;
+                return false;
+            }
+
+            return true;
+        }
+
+        if (MoleculeExporter::canExport(qFileName))
+        {
+            MoleculeExporter exporter;
+            for (auto const& id : m_molIDs)
+                exporter.addMolecule(System::get().getMolecule(id));
+
+            if (!exporter.write(qFileName))
+            {
+                m_errorString = "could not write molecule file " + fileName + ": " + exporter.errorString().toStdString();
+                return false;
+            }
+
+            return true;
+        }
+
+        // xyz files have no connectivity, all other formats need the bonds:
+        const bool needsBonds = ! qFileName.endsWith(".xyz", Qt::CaseInsensitive);
+
+        chemkit::MoleculeFile molFile(fileName);
+        for (auto const& id : m_molIDs)
+        {
+            moleculePtr molecule = System::get().getMolecule(id);
+            molecule->syncAtoms();
+            if (needsBonds)
+                molecule->perceiveBonds();
+            molFile.addMolecule(molecule);
+        }
+
+        if (!molFile.write())
+        {
+            m_errorString = "could not write molecule file " + fileName + ": " + molFile.errorString();
+            return false;
+        }
+
+        return true;
+    }
+
+    ///
+    /// \brief BatchJob::streamTrajectory
+    /// \param fileName
+    /// \param rmsdStream
+    /// \param outputName
+    /// \return
+    ///
+    /// align every frame of the xyz trajectory \p fileName to its first frame and
+    /// write the frame number and RMSD to \p rmsdStream. If \p outputName is given,
+    /// the aligned frames are written there as a multi-frame xyz file. The frames
+    /// are loaded one after the other into the same molecule, so arbitrarily long
+    /// trajectories can be processed.
+    ///
+    bool BatchJob::streamTrajectory(const std::string &fileName, std::ostream &rmsdStream, const std::string &outputName)
+    {
+        XyzTrajectory trajectory(1);
+        if (!trajectory.open(QString::fromStdString(fileName)))
+        {
+            m_errorString = "could not read trajectory " + fileName + ": " + trajectory.errorString().toStdString();
+            return false;
+        }
+
+        std::ofstream output;
+        if (!outputName.empty())
+        {
+            output.open(outputName);
+            if (!output)
+            {
+                m_errorString = "could not write trajectory " + outputName;
+                return false;
+            }
+            output << std::fixed << std::setprecision(6);
+        }
+
+        moleculePtr reference;
+        moleculePtr current;
+        try
+        {
+            reference = trajectory.createMolecule(0);
+            current = trajectory.molecule();
+        }
+        catch (const std::exception &error)
+        {
+            m_errorString = "could not read trajectory " + fileName + ": " + error.what();
+            return false;
+        }
+
+        System::get().addMolecule(reference);
+        System::get().addMolecule(current);
+
+        std::vector<std::string> symbols(current->size());
+        for (size_t i = 0; i < current->size(); i++)
+            symbols[i] = current->atom(i)->symbol();
+
+        bool success = true;
+        rmsdStream << std::fixed << std::setprecision(6);
+
+        try
+        {
+            for (size_t frame = 0; frame < trajectory.frameCount(); frame++)
+            {
+                trajectory.setFrame(frame);
+                double rmsd = System::get().alignMoleculesTo(reference->molId(), std::vector<unsigned long>(1, current->molId())).front();
+                rmsdStream << std::setw(8) << frame + 1 << std::setw(14) << rmsd << std::endl;
+
+                if (output.is_open())
+                {
+                    const Eigen::Matrix3Xd &positions = current->positions();
+                    output << positions.cols() << "\n" << trajectory.comment(frame) << "\n";
+                    for (int i = 0; i < positions.cols(); i++)
+                        output << std::setw(3) << symbols[i] << std::setw(14) << positions(0,i)
+                               << std::setw(14) << positions(1,i) << std::setw(14) << positions(2,i) << "\n";
+                }
+            }
+        }
+        catch (const std::exception &error)
+        {
+            m_errorString = "error in trajectory " + fileName + ": " + error.what();
+            success = false;
+        }
+
+        System::get().removeMolecule(current->molId());
+        System::get().removeMolecule(reference->molId());
+
+        return success;
+    }
+
+    const std::vector<unsigned long> &BatchJob::molIDs() const
+    {
+        return m_molIDs;
+    }
+
+    std::string BatchJob::errorString() const
+    {
+        return m_errorString;
+    }
+
+    ///
+    /// \brief BatchJob::checkAtoms
+    /// \param molecule
+    /// \param fileName
+    /// \return
+    ///
+    /// whether all atoms that the origin and basis settings refer to exist in
+    /// \p molecule. Otherwise the error string names the offending index.
+    ///
+    bool BatchJob::checkAtoms(const Molecule &molecule, const std::string &fileName)
+    {
+        std::vector<size_t> used;
+        if (m_originCode == kCenterOnAtom)
+            used.push_back(m_originAtoms[0]);
+        else if (m_originCode == kCenterBetweenAtoms)
+            used.insert(used.end(), m_originAtoms.begin(), m_originAtoms.end());
+
+        if (m_basisCode == kVectorsFromAtoms)
+            used.insert(used.end(), m_basisAtoms.begin(), m_basisAtoms.end());
+
+        for (auto const& atom : used)
+        {
+            if (atom >= molecule.size())
+            {
+                m_errorString = "atom index " + std::to_string(atom) + " is out of range for the "
+                        + std::to_string(molecule.size()) + " atoms of the molecule in " + fileName;
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    void BatchJob::addMolecule(const moleculePtr &newMolecule)
+    {
+        System::get().addMolecule(newMolecule);
+        m_molIDs.push_back(newMolecule->molId());
+    }
+
+} // namespace molconv
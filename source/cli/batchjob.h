@@ -0,0 +1,75 @@
+/*
+ * Copyright 2014 - 2019 Jan von Cosel & Sebastian Lenz
+ *
+ * This file is part of molconv.
+ *
+ * molconv is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * molconv is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have recieved a copy of the GNU General Public License
+ * along with molconv. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#ifndef BATCHJOB_H
+#define BATCHJOB_H
+
+#include <array>
+#include <ostream>
+#include <string>
+#include <vector>
+#include <Eigen/Core>
+#include "types.h"
+
+namespace molconv
+{
+    ///
+    /// \brief The BatchJob class
+    ///
+    /// the work of a single invocation of molconv-cli: import molecules from
+    /// files, give them an internal origin and basis, align them to a reference,
+    /// compare them and export them again. It only uses the molecule, system and
+    /// io libraries, so no display is needed.
+    ///
+    class BatchJob
+    {
+    public:
+        BatchJob();
+
+        void setOrigin(const OriginCode code, const std::array<size_t,2> &atoms, const double factor);
+        void setBasis(const BasisCode code, const std::array<size_t,3> &atoms);
+
+        bool import(const std::string &fileName);
+        bool align(const size_t reference);
+        Eigen::MatrixXd rmsdMatrix() const;
+        bool exportTo(const std::string &fileName);
+        bool streamTrajectory(const std::string &fileName, std::ostream &rmsdStream, const std::string &outputName = std::string());
+
+        const std::vector<unsigned long> &molIDs() const;
+        std::string errorString() const;
+
+    private:
+        bool checkAtoms(const Molecule &molecule, const std::string &fileName);
+        void addMolecule(const moleculePtr &newMolecule);
+
+        OriginCode m_originCode;
+        std::array<size_t,2> m_originAtoms;
+        double m_originFactor;
+        BasisCode m_basisCode;
+        std::array<size_t,3> m_basisAtoms;
+
+        std::vector<unsigned long> m_molIDs;
+        std::string m_errorString;
+    };
+
+} // namespace molconv
+
+#endif // BATCHJOB_H
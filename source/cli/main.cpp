@@ -0,0 +1,219 @@
+/*
+ * Copyright 2014 - 2019 Jan von Cosel & Sebastian Lenz
+ *
+ * This file is part of molconv.
+ *
+ * molconv is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * molconv is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have recieved a copy of the GNU General Public License
+ * along with molconv. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include <algorithm>
+#include <array>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <boost/program_options.hpp>
+#include "batchjob.h"
+
+namespace po = boost::program_options;
+
+namespace
+{
+    bool parseOrigin(const std::string &name, molconv::OriginCode &code)
+    {
+        if (name == "mass")
+            code = molconv::kCenterOfMass;
+        else if (name == "geometry")
+            code = molconv::kCenterOfGeometry;
+        else if (name == "atom")
+            code = molconv::kCenterOnAtom;
+        else if (name == "between")
+            code = molconv::kCenterBetweenAtoms;
+        else
+            return false;
+
+        return true;
+    }
+
+    ///
+    /// \brief parseAtoms
+    /// \param list
+    /// \param atoms
+    /// \return
+    ///
+    /// parse a comma-separated list of atom indices, such as "0,4,7"
+    ///
+    bool parseAtoms(const std::string &list, std::vector<size_t> &atoms)
+    {
+        atoms.clear();
+        std::istringstream stream(list);
+        std::string item;
+
+        while (std::getline(stream, item, ','))
+        {
+            if (item.empty() || item.size() > 9 || item.find_first_not_of("0123456789") != std::string::npos)
+                return false;
+
+            atoms.push_back(std::stoul(item));
+        }
+
+        return !atoms.empty() && list.back() != ',';
+    }
+
+    bool parseBasis(const std::string &name, molconv::BasisCode &code)
+    {
+        if (name == "covariance")
+            code = molconv::kCovarianceVectors;
+        else if (name == "inertia")
+            code = molconv::kInertiaVectors;
+        else if (name == "atoms")
+            code = molconv::kVectorsFromAtoms;
+        else
+            return false;
+
+        return true;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    po::options_description options("molconv-cli options");
+    options.add_options()
+        ("help,h", "print this help message")
+        ("input,i", po::value<std::vector<std::string>>(), "molecule or molconv file to import (may be given several times)")
+        ("origin", po::value<std::string>()->default_value("geometry"), "internal origin: mass, geometry, atom or between")
+        ("origin-atoms", po::value<std::string>(), "the atom of --origin atom or the two comma-separated atoms of --origin between, e.g. 0,3")
+        ("origin-factor", po::value<double>()->default_value(0.5), "position of the origin between the two atoms")
+        ("basis", po::value<std::string>()->default_value("covariance"), "internal basis: covariance, inertia or atoms")
+        ("basis-atoms", po::value<std::string>(), "the three comma-separated atoms of --basis atoms, e.g. 0,1,2")
+        ("align", po::value<size_t>(), "align all molecules to the molecule with this index")
+        ("rmsd", "print the RMSD matrix of all molecules after superposition")
+        ("trajectory", po::value<std::string>(), "align all frames of this xyz trajectory to its first frame and print their RMSD")
+        ("output,o", po::value<std::string>(), "write all molecules to this file, the format is taken from the extension");
+
+    po::positional_options_description positional;
+    positional.add("input", -1);
+
+    po::variables_map vm;
+    try
+    {
+        po::store(po::command_line_parser(argc, argv).options(options).positional(positional).run(), vm);
+        po::notify(vm);
+    }
+    catch (const po::error &error)
+    {
+        std::cerr << "molconv-cli: " << error.what() << std::endl;
+        return 1;
+    }
+
+    if (vm.count("help") || (!vm.count("input") && !vm.count("trajectory")))
+    {
+        std::cout << "usage: molconv-cli [options] file..." << std::endl << options << std::endl;
+        return vm.count("help") ? 0 : 1;
+    }
+
+    molconv::OriginCode originCode;
+    molconv::BasisCode basisCode;
+    if (!parseOrigin(vm["origin"].as<std::string>(), originCode))
+    {
+        std::cerr << "molconv-cli: unknown origin " << vm["origin"].as<std::string>() << std::endl;
+        return 1;
+    }
+    if (!parseBasis(vm["basis"].as<std::string>(), basisCode))
+    {
+        std::cerr << "molconv-cli: unknown basis " << vm["basis"].as<std::string>() << std::endl;
+        return 1;
+    }
+
+    std::array<size_t,2> originAtoms = {{0, 0}};
+    std::array<size_t,3> basisAtoms = {{0, 0, 0}};
+    std::vector<size_t> atoms;
+
+    // the origins and bases on atoms have no default atoms to fall back to:
+    const size_t nOriginAtoms = originCode == molconv::kCenterOnAtom ? 1 : (originCode == molconv::kCenterBetweenAtoms ? 2 : 0);
+    if (nOriginAtoms > 0)
+    {
+        if (!vm.count("origin-atoms") || !parseAtoms(vm["origin-atoms"].as<std::string>(), atoms) || atoms.size() != nOriginAtoms)
+        {
+            std::cerr << "molconv-cli: --origin " << vm["origin"].as<std::string>() << " needs "
+                      << (nOriginAtoms == 1 ? "one atom index" : "two comma-separated atom indices") << " in --origin-atoms" << std::endl;
+            return 1;
+        }
+        std::copy(atoms.begin(), atoms.end(), originAtoms.begin());
+    }
+    if (basisCode == molconv::kVectorsFromAtoms)
+    {
+        if (!vm.count("basis-atoms") || !parseAtoms(vm["basis-atoms"].as<std::string>(), atoms) || atoms.size() != basisAtoms.size())
+        {
+            std::cerr << "molconv-cli: --basis atoms needs three comma-separated atom indices in --basis-atoms" << std::endl;
+            return 1;
+        }
+        std::copy(atoms.begin(), atoms.end(), basisAtoms.begin());
+    }
+
+    molconv::BatchJob job;
+    job.setOrigin(originCode, originAtoms, vm["origin-factor"].as<double>());
+    job.setBasis(basisCode, basisAtoms);
+
+    if (vm.count("trajectory"))
+    {
+        // the trajectory is streamed frame by frame, the output gets the aligned frames:
+        std::string outputName = vm.count("output") ? vm["output"].as<std::string>() : std::string();
+        if (!job.streamTrajectory(vm["trajectory"].as<std::string>(), std::cout, outputName))
+        {
+            std::cerr << "molconv-cli: " << job.errorString() << std::endl;
+            return 1;
+        }
+
+        return 0;
+    }
+
+    for (auto const& fileName : vm["input"].as<std::vector<std::string>>())
+    {
+        if (!job.import(fileName))
+        {
+            std::cerr << "molconv-cli: " << job.errorString() << std::endl;
+            return 1;
+        }
+    }
+
+    if (vm.count("align") && !job.align(vm["align"].as<size_t>()))
+    {
+        std::cerr << "molconv-cli: " << job.errorString() << std::endl;
+        return 1;
+    }
+
+    if (vm.count("rmsd"))
+    {
+        Eigen::MatrixXd rmsd = job.rmsdMatrix();
+        std::cout << std::fixed << std::setprecision(6);
+        for (int i = 0; i < rmsd.rows(); i++)
+        {
+            for (int j = 0; j < rmsd.cols(); j++)
+                std::cout << std::setw(14) << rmsd(i,j);
+            std::cout << std::endl;
+        }
+    }
+
+    if (vm.count("output") && !job.exportTo(vm["output"].as<std::string>()))
+    {
+        std::cerr << "molconv-cli: " << job.errorString() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
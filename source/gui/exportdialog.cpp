@@ -18,6 +18,7 @@
  *
  */
 
+#include "moleculeexporter.h"
 #include "exportdialog.h"
 #include "ui_exportdialog.h"
 
@@ -53,18 +54,12 @@ void ExportDialog::createMoleculeList(const std::vector<unsigned long> &ids)
 
 void ExportDialog::on_buttonBox_accepted()
 {
-    // create a dummy molecule containing the atoms of all selected molecules:
-    std::vector<unsigned long> mols = theWindow->getMolIDs();
-    molconv::moleculePtr dummyMol(new molconv::Molecule);
+    const std::vector<unsigned long> &mols = theWindow->getMolIDs();
+    std::vector<molconv::moleculePtr> selectedMols;
     for (int i = 0; i < ui->molExportList->count(); i++)
     {
         if (ui->molExportList->item(i)->isSelected())
-        {
-            for (int j = 0; j < int(theWindow->getMol(mols[i])->size()); j++)
-            {
-                dummyMol->addAtomCopy(theWindow->getMol(mols[i])->atom(j));
-            }
-        }
+            selectedMols.push_back(theWindow->getMol(mols[i]));
     }
 
     QStringList formats;
@@ -74,6 +69,7 @@ void ExportDialog::on_buttonBox_accepted()
     formats << "MDL Molfile (*.mol)";
     formats << "Structure-Data-File (*.sdf)";
     formats << "MOL2 Format (*.mol2)";
+    formats << "Protein Data Bank (*.pdb)";
     formats << "TXYZ Format (*.txyz)";
 
     QStringList suffixes;
@@ -83,6 +79,7 @@ void ExportDialog::on_buttonBox_accepted()
     suffixes << ".mol";
     suffixes << ".sdf";
     suffixes << ".mol2";
+    suffixes << ".pdb";
     suffixes << ".txyz";
 
     QString formatString = formats.at(ui->formatSelector->currentIndex());
@@ -100,6 +97,29 @@ void ExportDialog::on_buttonBox_accepted()
             if (QMessageBox::question(this, tr("Warning: File exists!"), QString("The file %1 exists. Overwrite?").arg(filename)) != QMessageBox::Yes)
                 return;
 
+        // the selected molecules are written as a single structure:
+        if (MoleculeExporter::canExport(filename))
+        {
+            MoleculeExporter exporter;
+            for (auto const& molecule : selectedMols)
+                exporter.addMolecule(molecule);
+            exporter.setMerged(true);
+
+            if (!exporter.write(filename))
+                QMessageBox::critical(this, tr("Error"), QString("Error writing file %1: %2").arg(filename, exporter.errorString()));
+
+            return;
+        }
+
+        // all other formats are written by chemkit from a molecule containing the atoms of all selected molecules:
+        molconv::moleculePtr dummyMol(new molconv::Molecule);
+        for (auto const& molecule : selectedMols)
+        {
+            molecule->syncAtoms();
+            for (size_t j = 0; j < molecule->size(); j++)
+                dummyMol->addAtomCopy(molecule->atom(j));
+        }
+
         boost::shared_ptr<chemkit::MoleculeFile> theMolFile(new chemkit::MoleculeFile(filename.toStdString()));
         theMolFile->addMolecule(dummyMol);
         theMolFile->write();
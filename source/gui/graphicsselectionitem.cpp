@@ -58,6 +58,18 @@ void GraphicsSelectionItem::clear()
     d->m_positions.clear();
 }
 
+///
+/// \brief GraphicsSelectionItem::setColor
+/// \param color
+///
+/// the color of the spheres, the opacity of the item is kept
+///
+void GraphicsSelectionItem::setColor(const QColor &color)
+{
+    d->m_color = color;
+    d->m_color.setAlpha(int(255 * d->m_opacity));
+}
+
 void GraphicsSelectionItem::paint(chemkit::GraphicsPainter *painter)
 {
     painter->setColor(d->m_color);
@@ -25,6 +25,7 @@
     #include <chemkit/graphicsitem.h>
 #endif
 
+#include <QColor>
 #include "types.h"
 
 class GraphicsSelectionItemPrivate;
@@ -37,6 +38,7 @@ public:
 
     void addPosition(const Eigen::Vector3d &newPosition);
     void clear();
+    void setColor(const QColor &color);
 
     void paint(chemkit::GraphicsPainter *painter);
 
@@ -25,6 +25,7 @@
 #endif
 #include "importdialog.h"
 #include "ui_importdialog.h"
+#include "moleculefileprobe.h"
 
 
 class ImportDialogPrivate
@@ -70,6 +71,23 @@ ImportDialog::~ImportDialog()
 
 void ImportDialog::openFile()
 {
+    // only the header of the first molecule is needed for the atom counts:
+    if (MoleculeFileProbe::canProbe(d->m_fileName))
+    {
+        MoleculeFileProbe probe = MoleculeFileProbe::probeFile(d->m_fileName, 1);
+
+        if (! probe.isValid() || probe.moleculeCount() == 0)
+        {
+            QString error = probe.isValid() ? QString("No molecule found in file") : probe.errorString();
+            QMessageBox::critical(this, "Error", QString("Error opening file: %1").arg(error));
+            ui->settings->setEnabled(false);
+            return;
+        }
+
+        setAtomCount(int(probe.atomCount(0)));
+        return;
+    }
+
     chemkit::MoleculeFile *the_molfile;
 
     the_molfile = new chemkit::MoleculeFile(d->m_fileName.toStdString());
@@ -84,20 +102,22 @@ void ImportDialog::openFile()
 
     if (the_molfile->moleculeCount() > 0)
     {
-        chemkit::Molecule temp_mol;
-        temp_mol = *the_molfile->molecule();
-
-        ui->an->setMaximum(temp_mol.atomCount());
-        ui->atom1->setMaximum(temp_mol.atomCount());
-        ui->atom2->setMaximum(temp_mol.atomCount());
-        ui->atom3->setMaximum(temp_mol.atomCount());
-        ui->origin->setEnabled(true);
-        ui->basis->setEnabled(true);
-        ui->buttonBox->button(QDialogButtonBox::Ok)->setEnabled(true);
+        setAtomCount(int(the_molfile->molecule()->atomCount()));
     }
     delete the_molfile;
 }
 
+void ImportDialog::setAtomCount(const int atomCount)
+{
+    ui->an->setMaximum(atomCount);
+    ui->atom1->setMaximum(atomCount);
+    ui->atom2->setMaximum(atomCount);
+    ui->atom3->setMaximum(atomCount);
+    ui->origin->setEnabled(true);
+    ui->basis->setEnabled(true);
+    ui->buttonBox->button(QDialogButtonBox::Ok)->setEnabled(true);
+}
+
 void ImportDialog::on_filedialog_clicked()
 {
     QStringList filters;
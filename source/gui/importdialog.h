@@ -66,6 +66,8 @@ private slots:
     void on_an_valueChanged(int arg1);
 
 private:
+    void setAtomCount(const int atomCount);
+
     ImportDialogPrivate *d;
     Ui::ImportDialog *ui;
 };
@@ -86,13 +86,15 @@ void MoleculeInfo::update()
     atomicPositions.append(QString::number(tmpMol->size()));
     atomicPositions.append("\n\n");
 
+    const Eigen::Matrix3Xd &positions = tmpMol->positions();
+
     for (int i = 0; i < int(tmpMol->size()); i++)
     {
         atomicPositions.append(QString::fromStdString(tmpMol->atom(i)->symbol()));
         atomicPositions.append(QString("%1").arg(i + 1, -5));
-        atomicPositions.append(QString("%1").arg(tmpMol->atom(i)->position()(0), m_aP_prec + 4, 'f', m_aP_prec));
-        atomicPositions.append(QString("%1").arg(tmpMol->atom(i)->position()(1), m_aP_prec + 7, 'f', m_aP_prec));
-        atomicPositions.append(QString("%1").arg(tmpMol->atom(i)->position()(2), m_aP_prec + 7, 'f', m_aP_prec));
+        atomicPositions.append(QString("%1").arg(positions(0, i), m_aP_prec + 4, 'f', m_aP_prec));
+        atomicPositions.append(QString("%1").arg(positions(1, i), m_aP_prec + 7, 'f', m_aP_prec));
+        atomicPositions.append(QString("%1").arg(positions(2, i), m_aP_prec + 7, 'f', m_aP_prec));
         atomicPositions.append("\n");
     }
 
@@ -52,6 +52,23 @@ void MultiMolDialog::createMoleculeList(chemkit::MoleculeFile *file)
     }
 }
 
+void MultiMolDialog::createMoleculeList(const std::vector<std::string> &names)
+{
+    ui->molList->clear();
+    ui->selectAllBox->setCheckState(Qt::Unchecked);
+
+    for (int i = 0; i < int(names.size()); i++)
+    {
+        QString name = QString::number(i + 1).rightJustified(4, ' ');
+        if (!names[i].empty())
+            name += "  " + QString::fromStdString(names[i]);
+
+        QListWidgetItem *molItem = new QListWidgetItem(name, ui->molList);
+        molItem->setFlags(Qt::ItemIsEnabled | Qt::ItemIsSelectable);
+        ui->molList->addItem(molItem);
+    }
+}
+
 std::vector<bool> MultiMolDialog::molecules() const
 {
     std::vector<bool> isChosen;
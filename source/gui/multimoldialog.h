@@ -39,6 +39,7 @@ public:
     ~MultiMolDialog();
 
     void createMoleculeList(chemkit::MoleculeFile *file);
+    void createMoleculeList(const std::vector<std::string> &names);
     std::vector<bool> molecules() const;
 
 private slots:
@@ -60,7 +60,7 @@ void SetBasisDialog::prepare(unsigned long molID)
         std::string currentName = molecule->atom(i)->symbol() + std::to_string(i + 1);
 
         QListWidgetItem *originItem = new QListWidgetItem(QString::fromStdString(currentName), ui->originAtomList);
-        if (molecule->originList().size() > 0 && molecule->originList().at(i))
+        if (i < int(molecule->originList().size()) && molecule->originList().test(i))
         {
             originItem->setCheckState(Qt::Checked);
         }
@@ -71,7 +71,7 @@ void SetBasisDialog::prepare(unsigned long molID)
         ui->originAtomList->addItem(originItem);
 
         QListWidgetItem *basisItem = new QListWidgetItem(QString::fromStdString(currentName), ui->basisAtomList);
-        if (molecule->basisList().size() > 0 && molecule->basisList().at(i))
+        if (i < int(molecule->basisList().size()) && molecule->basisList().test(i))
         {
             basisItem->setCheckState(Qt::Checked);
         }
@@ -0,0 +1,74 @@
+/*
+ * Copyright 2014 - 2019 Jan von Cosel & Sebastian Lenz
+ *
+ * This file is part of molconv.
+ *
+ * molconv is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * molconv is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have recieved a copy of the GNU General Public License
+ * along with molconv. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include "trajectoryscrubber.h"
+#include "ui_trajectoryscrubber.h"
+
+TrajectoryScrubber::TrajectoryScrubber(QWidget *parent) :
+    QDockWidget(parent),
+    ui(new Ui::TrajectoryScrubber)
+{
+    ui->setupUi(this);
+    setFeatures(QDockWidget::DockWidgetMovable | QDockWidget::DockWidgetFloatable);
+
+    setFrameCount(1);
+}
+
+TrajectoryScrubber::~TrajectoryScrubber()
+{
+    delete ui;
+}
+
+void TrajectoryScrubber::setFrameCount(const int frameCount)
+{
+    const bool blocked = blockSignals(true);
+
+    ui->frameSlider->setRange(0, frameCount - 1);
+    ui->frameSlider->setValue(0);
+    ui->frameNumber->setRange(1, frameCount);
+    ui->frameNumber->setValue(1);
+    ui->frameCount->setText("/ " + QString::number(frameCount));
+
+    blockSignals(blocked);
+}
+
+int TrajectoryScrubber::frame() const
+{
+    return ui->frameSlider->value();
+}
+
+void TrajectoryScrubber::setFrame(const int frame)
+{
+    ui->frameSlider->setValue(frame);
+}
+
+void TrajectoryScrubber::on_frameSlider_valueChanged(int value)
+{
+    if (ui->frameNumber->value() != value + 1)
+        ui->frameNumber->setValue(value + 1);
+
+    emit frameChanged(value);
+}
+
+void TrajectoryScrubber::on_frameNumber_valueChanged(int value)
+{
+    ui->frameSlider->setValue(value - 1);
+}
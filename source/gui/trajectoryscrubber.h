@@ -0,0 +1,62 @@
+/*
+ * Copyright 2014 - 2019 Jan von Cosel & Sebastian Lenz
+ *
+ * This file is part of molconv.
+ *
+ * molconv is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * molconv is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have recieved a copy of the GNU General Public License
+ * along with molconv. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#ifndef TRAJECTORYSCRUBBER_H
+#define TRAJECTORYSCRUBBER_H
+
+#include <QDockWidget>
+
+namespace Ui {
+class TrajectoryScrubber;
+}
+
+///
+/// \brief The TrajectoryScrubber class
+///
+/// a slider to step through the frames of a trajectory. The frames are
+/// counted from zero, but shown to the user counted from one.
+///
+class TrajectoryScrubber : public QDockWidget
+{
+    Q_OBJECT
+
+public:
+    explicit TrajectoryScrubber(QWidget *parent = 0);
+    ~TrajectoryScrubber();
+
+    void setFrameCount(const int frameCount);
+    int frame() const;
+
+public slots:
+    void setFrame(const int frame);
+
+signals:
+    void frameChanged(int frame);
+
+private slots:
+    void on_frameSlider_valueChanged(int value);
+    void on_frameNumber_valueChanged(int value);
+
+private:
+    Ui::TrajectoryScrubber *ui;
+};
+
+#endif // TRAJECTORYSCRUBBER_H
@@ -0,0 +1,261 @@
+/*
+ * Copyright 2014 - 2019 Jan von Cosel & Sebastian Lenz
+ *
+ * This file is part of molconv.
+ *
+ * molconv is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * molconv is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have recieved a copy of the GNU General Public License
+ * along with molconv. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include <exception>
+#include <ios>
+#include <boost/iostreams/concepts.hpp>
+#include <boost/iostreams/filter/gzip.hpp>
+#ifdef MOLCONV_HAVE_ZSTD
+    #include <boost/iostreams/filter/zstd.hpp>
+#endif
+
+#include "compresseddevice.h"
+
+namespace
+{
+    // Boost.Iostreams source and sink that forward to a QIODevice:
+    class DeviceSource : public boost::iostreams::source
+    {
+    public:
+        DeviceSource(QIODevice *device)
+            : m_device(device)
+        {
+        }
+
+        std::streamsize read(char *data, std::streamsize n)
+        {
+            qint64 result = m_device->read(data, qint64(n));
+            return result > 0 ? std::streamsize(result) : -1;
+        }
+
+    private:
+        QIODevice *m_device;
+    };
+
+    class DeviceSink : public boost::iostreams::sink
+    {
+    public:
+        DeviceSink(QIODevice *device, bool *failed)
+            : m_device(device)
+            , m_failed(failed)
+        {
+        }
+
+        // Boost.Iostreams swallows exceptions thrown while the chain is closed,
+        // so a failed write is also recorded for CompressedDevice::finish():
+        std::streamsize write(const char *data, std::streamsize n)
+        {
+            if (m_device->write(data, qint64(n)) != qint64(n))
+            {
+                *m_failed = true;
+                throw std::ios_base::failure(m_device->errorString().toStdString());
+            }
+
+            return n;
+        }
+
+    private:
+        QIODevice *m_device;
+        bool *m_failed;
+    };
+}
+
+CompressedDevice::CompressedDevice(QIODevice *target, const Compression compression)
+    : m_target(target)
+    , m_compression(compression)
+    , m_writeFailed(false)
+{
+}
+
+CompressedDevice::~CompressedDevice()
+{
+    close();
+}
+
+///
+/// \brief CompressedDevice::compressionOf
+/// \param fileName
+/// \return
+///
+/// determine the compression from the extension of \p fileName
+///
+CompressedDevice::Compression CompressedDevice::compressionOf(const QString &fileName)
+{
+    if (fileName.endsWith(".gz"))
+        return kGzip;
+    else if (fileName.endsWith(".zst"))
+        return kZstd;
+    else
+        return kNoCompression;
+}
+
+///
+/// \brief CompressedDevice::isSupported
+/// \param compression
+/// \return
+///
+/// zstd compression is only available if Boost.Iostreams was built with it
+///
+bool CompressedDevice::isSupported(const Compression compression)
+{
+#ifdef MOLCONV_HAVE_ZSTD
+    Q_UNUSED(compression);
+    return true;
+#else
+    return compression != kZstd;
+#endif
+}
+
+bool CompressedDevice::open(OpenMode mode)
+{
+    if (!isSupported(m_compression) || (mode & ReadWrite) == ReadWrite || !m_target->isOpen())
+    {
+        return false;
+    }
+
+    if (mode & ReadOnly)
+    {
+        m_input.reset(new boost::iostreams::filtering_istream);
+        if (m_compression == kGzip)
+            m_input->push(boost::iostreams::gzip_decompressor());
+#ifdef MOLCONV_HAVE_ZSTD
+        else if (m_compression == kZstd)
+            m_input->push(boost::iostreams::zstd_decompressor());
+#endif
+        m_input->push(DeviceSource(m_target));
+    }
+    else
+    {
+        m_output.reset(new boost::iostreams::filtering_ostream);
+        if (m_compression == kGzip)
+            m_output->push(boost::iostreams::gzip_compressor());
+#ifdef MOLCONV_HAVE_ZSTD
+        else if (m_compression == kZstd)
+            m_output->push(boost::iostreams::zstd_compressor());
+#endif
+        m_writeFailed = false;
+        m_output->push(DeviceSink(m_target, &m_writeFailed));
+    }
+
+    return QIODevice::open(mode);
+}
+
+void CompressedDevice::close()
+{
+    finish();
+}
+
+///
+/// \brief CompressedDevice::finish
+/// \return
+///
+/// write out the remaining compressed data and close the device. Unlike
+/// close(), this reports whether everything reached the target device;
+/// if not, errorString() tells why and the written data is incomplete.
+///
+bool CompressedDevice::finish()
+{
+    if (!isOpen())
+    {
+        return false;
+    }
+
+    bool success = true;
+
+    // popping the filters writes out the remaining compressed data:
+    try
+    {
+        if (m_output)
+        {
+            m_output->flush();
+            m_output->reset();
+        }
+    }
+    catch (const std::exception &error)
+    {
+        setErrorString(error.what());
+        success = false;
+    }
+
+    if (m_writeFailed)
+    {
+        setErrorString(m_target->errorString());
+        success = false;
+    }
+
+    m_input.reset();
+    m_output.reset();
+
+    QIODevice::close();
+
+    return success;
+}
+
+bool CompressedDevice::isSequential() const
+{
+    return true;
+}
+
+qint64 CompressedDevice::readData(char *data, qint64 maxSize)
+{
+    if (!m_input)
+    {
+        return -1;
+    }
+
+    try
+    {
+        m_input->read(data, std::streamsize(maxSize));
+    }
+    catch (const std::exception &error)
+    {
+        setErrorString(error.what());
+        return -1;
+    }
+
+    qint64 nRead = qint64(m_input->gcount());
+    if (nRead == 0 && !m_input->good())
+    {
+        return -1;
+    }
+
+    return nRead;
+}
+
+qint64 CompressedDevice::writeData(const char *data, qint64 maxSize)
+{
+    if (!m_output)
+    {
+        return -1;
+    }
+
+    try
+    {
+        m_output->write(data, std::streamsize(maxSize));
+    }
+    catch (const std::exception &error)
+    {
+        setErrorString(error.what());
+        return -1;
+    }
+
+    return m_output->good() ? maxSize : -1;
+}
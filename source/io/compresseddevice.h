@@ -0,0 +1,71 @@
+/*
+ * Copyright 2014 - 2019 Jan von Cosel & Sebastian Lenz
+ *
+ * This file is part of molconv.
+ *
+ * molconv is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * molconv is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have recieved a copy of the GNU General Public License
+ * along with molconv. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#ifndef COMPRESSEDDEVICE_H
+#define COMPRESSEDDEVICE_H
+
+
+#include <QIODevice>
+#include <QString>
+#include <boost/scoped_ptr.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
+
+///
+/// \brief The CompressedDevice class
+///
+/// a sequential QIODevice that compresses everything written to it, or
+/// decompresses everything read from it, on the fly through a Boost.Iostreams
+/// filter chain on top of another device. This lets the XML stream reader and
+/// writer work on compressed files without an uncompressed copy.
+///
+class CompressedDevice : public QIODevice
+{
+public:
+    enum Compression {
+        kNoCompression = 0,
+        kGzip = 1,
+        kZstd = 2
+    };
+
+    CompressedDevice(QIODevice *target, const Compression compression);
+    ~CompressedDevice();
+
+    static Compression compressionOf(const QString &fileName);
+    static bool isSupported(const Compression compression);
+
+    bool open(OpenMode mode) override;
+    void close() override;
+    bool finish();
+    bool isSequential() const override;
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override;
+    qint64 writeData(const char *data, qint64 maxSize) override;
+
+private:
+    QIODevice *m_target;
+    Compression m_compression;
+    bool m_writeFailed;
+    boost::scoped_ptr<boost::iostreams::filtering_istream> m_input;
+    boost::scoped_ptr<boost::iostreams::filtering_ostream> m_output;
+};
+
+#endif // COMPRESSEDDEVICE_H
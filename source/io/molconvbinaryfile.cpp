@@ -0,0 +1,378 @@
+/*
+ * Copyright 2014 - 2019 Jan von Cosel & Sebastian Lenz
+ *
+ * This file is part of molconv.
+ *
+ * molconv is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * molconv is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have recieved a copy of the GNU General Public License
+ * along with molconv. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#ifndef Q_MOC_RUN
+    #include<chemkit/atom.h>
+    #include<chemkit/element.h>
+#endif
+
+#include "molecule.h"
+#include "moleculeorigin.h"
+#include "moleculebasis.h"
+#include "molconvbinaryfile.h"
+
+namespace
+{
+    const char kMagic[8] = {'M', 'O', 'L', 'C', 'O', 'N', 'V', 'B'};
+    const uint32_t kByteOrderMark = 0x01020304;
+
+    struct FileHeader
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t byteOrder;
+        uint64_t nMolecules;
+    };
+
+    //
+    // the fixed part of a molecule record. It is followed by the name, the
+    // atomic numbers, the origin mask, the basis mask and the coordinates,
+    // each of them padded to a multiple of 8 bytes.
+    //
+    struct RecordHeader
+    {
+        uint64_t recordSize;
+        uint64_t nAtoms;
+        uint32_t nameLength;
+        int32_t originCode;
+        int32_t originAtoms[2];
+        int32_t basisCode;
+        int32_t basisAtoms[3];
+        double originFactor;
+        double originPosition[3];
+        double orientation[4];
+    };
+
+    static_assert(sizeof(FileHeader) == 24, "unexpected padding in the binary file header");
+    static_assert(sizeof(RecordHeader) == 112, "unexpected padding in the binary record header");
+
+    uint64_t padded(const uint64_t size)
+    {
+        return (size + 7) & ~uint64_t(7);
+    }
+
+    uint64_t maskWords(const uint64_t nAtoms)
+    {
+        return (nAtoms + 63) / 64;
+    }
+
+    // origins and bases defined on atoms carry an empty mask, which is
+    // stored as a mask of inactive atoms to keep the record layout fixed:
+    molconv::AtomMask fullMask(molconv::AtomMask mask, const size_t nAtoms)
+    {
+        mask.resize(nAtoms);
+        return mask;
+    }
+
+    // a molecule can only be built from a record if all elements are known
+    // and the origin and basis are implemented and refer to existing atoms:
+    bool isValidRecord(const MolconvBinaryFile::Record &record)
+    {
+        for (size_t i = 0; i < record.nAtoms; i++)
+        {
+            if (!chemkit::Element(record.atomicNumbers[i]).isValid())
+                return false;
+        }
+
+        return molconv::Molecule::isValidOrigin(record.originCode, record.nAtoms, record.originList(),
+                                                size_t(record.originAtoms[0]), size_t(record.originAtoms[1]))
+                && molconv::Molecule::isValidBasis(record.basisCode, record.nAtoms, record.basisList(),
+                                                   size_t(record.basisAtoms[0]), size_t(record.basisAtoms[1]), size_t(record.basisAtoms[2]));
+    }
+
+    bool writePadded(QFile &file, const void *data, const uint64_t size)
+    {
+        static const char zeros[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+
+        if (size > 0 && file.write(static_cast<const char *>(data), qint64(size)) != qint64(size))
+            return false;
+
+        const uint64_t padding = padded(size) - size;
+        return padding == 0 || file.write(zeros, qint64(padding)) == qint64(padding);
+    }
+}
+
+MolconvBinaryFile::Record::Record()
+    : nAtoms(0)
+    , originCode(molconv::kCenterOfGeometry)
+    , originFactor(0.0)
+    , originPosition(Eigen::Vector3d::Zero())
+    , basisCode(molconv::kCovarianceVectors)
+    , orientation(Eigen::Quaterniond::Identity())
+    , atomicNumbers(0)
+    , originMask(0)
+    , basisMask(0)
+    , positions(0)
+{
+    originAtoms[0] = originAtoms[1] = 0;
+    basisAtoms[0] = basisAtoms[1] = basisAtoms[2] = 0;
+}
+
+Eigen::Map<const Eigen::Matrix3Xd> MolconvBinaryFile::Record::internalPositions() const
+{
+    return Eigen::Map<const Eigen::Matrix3Xd>(positions, 3, Eigen::Index(nAtoms));
+}
+
+molconv::AtomMask MolconvBinaryFile::Record::originList() const
+{
+    return molconv::AtomMask::fromWords(originMask, nAtoms);
+}
+
+molconv::AtomMask MolconvBinaryFile::Record::basisList() const
+{
+    return molconv::AtomMask::fromWords(basisMask, nAtoms);
+}
+
+MolconvBinaryFile::MolconvBinaryFile()
+    : m_data(0)
+    , m_size(0)
+{
+}
+
+MolconvBinaryFile::~MolconvBinaryFile()
+{
+    close();
+}
+
+///
+/// \brief MolconvBinaryFile::open
+/// \param fileName
+/// \return
+///
+/// map the file \p fileName into memory and check the header and the sizes of
+/// all records. Returns false if the file can't be mapped, has a different
+/// version or byte order, is truncated, or holds a record with an unknown
+/// element or an origin or basis that can't be set up for its atoms.
+///
+bool MolconvBinaryFile::open(const QString &fileName)
+{
+    close();
+
+    m_file.setFileName(fileName);
+    if (!m_file.open(QIODevice::ReadOnly))
+    {
+        return false;
+    }
+
+    m_size = m_file.size();
+    if (m_size < qint64(sizeof(FileHeader)))
+    {
+        close();
+        return false;
+    }
+
+    m_data = m_file.map(0, m_size);
+    if (!m_data)
+    {
+        close();
+        return false;
+    }
+
+    FileHeader header;
+    std::memcpy(&header, m_data, sizeof(FileHeader));
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.version != kVersion || header.byteOrder != kByteOrderMark)
+    {
+        close();
+        return false;
+    }
+
+    qint64 offset = sizeof(FileHeader);
+    m_offsets.reserve(size_t(std::min(header.nMolecules, uint64_t(m_size) / sizeof(RecordHeader))));
+    for (uint64_t i = 0; i < header.nMolecules; i++)
+    {
+        if (m_size - offset < qint64(sizeof(RecordHeader)))
+        {
+            close();
+            return false;
+        }
+
+        const RecordHeader *recordHeader = reinterpret_cast<const RecordHeader *>(m_data + offset);
+        const uint64_t nAtoms = recordHeader->nAtoms;
+
+        // every atom needs at least its three coordinates, so larger counts can't
+        // fit. Checking this first keeps the sizes below from overflowing:
+        if (nAtoms > (uint64_t(m_size - offset) - sizeof(RecordHeader)) / 24)
+        {
+            close();
+            return false;
+        }
+
+        const uint64_t expectedSize = sizeof(RecordHeader) + padded(recordHeader->nameLength) + padded(nAtoms)
+                + 2 * 8 * maskWords(nAtoms) + 3 * 8 * nAtoms;
+
+        if (recordHeader->recordSize != expectedSize || uint64_t(m_size - offset) < expectedSize)
+        {
+            close();
+            return false;
+        }
+
+        m_offsets.push_back(offset);
+        offset += qint64(expectedSize);
+
+        if (!isValidRecord(record(m_offsets.size() - 1)))
+        {
+            close();
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void MolconvBinaryFile::close()
+{
+    if (m_data)
+    {
+        m_file.unmap(const_cast<uchar *>(m_data));
+        m_data = 0;
+    }
+
+    m_file.close();
+    m_size = 0;
+    m_offsets.clear();
+}
+
+size_t MolconvBinaryFile::moleculeCount() const
+{
+    return m_offsets.size();
+}
+
+///
+/// \brief MolconvBinaryFile::record
+/// \param index
+/// \return
+///
+/// return a view of the molecule number \p index. The atomic numbers, the masks
+/// and the internal positions point directly into the mapped file.
+///
+MolconvBinaryFile::Record MolconvBinaryFile::record(const size_t index) const
+{
+    const uchar *data = m_data + m_offsets.at(index);
+    const RecordHeader *header = reinterpret_cast<const RecordHeader *>(data);
+
+    Record result;
+    result.nAtoms = size_t(header->nAtoms);
+    result.originCode = static_cast<molconv::OriginCode>(header->originCode);
+    result.originAtoms[0] = header->originAtoms[0];
+    result.originAtoms[1] = header->originAtoms[1];
+    result.originFactor = header->originFactor;
+    result.originPosition = Eigen::Vector3d(header->originPosition[0], header->originPosition[1], header->originPosition[2]);
+    result.basisCode = static_cast<molconv::BasisCode>(header->basisCode);
+    result.basisAtoms[0] = header->basisAtoms[0];
+    result.basisAtoms[1] = header->basisAtoms[1];
+    result.basisAtoms[2] = header->basisAtoms[2];
+    result.orientation = Eigen::Quaterniond(header->orientation[0], header->orientation[1], header->orientation[2], header->orientation[3]);
+
+    data += sizeof(RecordHeader);
+    result.name = std::string(reinterpret_cast<const char *>(data), header->nameLength);
+    data += padded(header->nameLength);
+
+    result.atomicNumbers = data;
+    data += padded(header->nAtoms);
+
+    result.originMask = reinterpret_cast<const uint64_t *>(data);
+    data += 8 * maskWords(header->nAtoms);
+    result.basisMask = reinterpret_cast<const uint64_t *>(data);
+    data += 8 * maskWords(header->nAtoms);
+
+    result.positions = reinterpret_cast<const double *>(data);
+
+    return result;
+}
+
+///
+/// \brief MolconvBinaryFile::write
+/// \param fileName
+/// \param molecules
+/// \return
+///
+/// write the \p molecules to the binary file \p fileName
+///
+bool MolconvBinaryFile::write(const QString &fileName, const std::vector<molconv::moleculePtr> &molecules)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        return false;
+    }
+
+    FileHeader fileHeader;
+    std::memcpy(fileHeader.magic, kMagic, sizeof(kMagic));
+    fileHeader.version = kVersion;
+    fileHeader.byteOrder = kByteOrderMark;
+    fileHeader.nMolecules = molecules.size();
+
+    bool success = writePadded(file, &fileHeader, sizeof(FileHeader));
+
+    for (auto const& molecule : molecules)
+    {
+        if (!success)
+            break;
+
+        const uint64_t nAtoms = molecule->size();
+        const std::string name = molecule->name();
+        const std::array<int,2> originAtoms = molecule->originAtoms();
+        const std::array<int,3> basisAtoms = molecule->basisAtoms();
+        const Eigen::Vector3d originPosition = molecule->originPosition();
+        const Eigen::Quaterniond orientation = molecule->orientation();
+
+        RecordHeader header;
+        std::memset(&header, 0, sizeof(RecordHeader));
+        header.recordSize = sizeof(RecordHeader) + padded(name.size()) + padded(nAtoms) + 2 * 8 * maskWords(nAtoms) + 3 * 8 * nAtoms;
+        header.nAtoms = nAtoms;
+        header.nameLength = uint32_t(name.size());
+        header.originCode = molecule->origin()->code();
+        header.originAtoms[0] = originAtoms[0];
+        header.originAtoms[1] = originAtoms[1];
+        header.basisCode = molecule->basis()->code();
+        header.basisAtoms[0] = basisAtoms[0];
+        header.basisAtoms[1] = basisAtoms[1];
+        header.basisAtoms[2] = basisAtoms[2];
+        header.originFactor = molecule->originFactor();
+        for (int i = 0; i < 3; i++)
+            header.originPosition[i] = originPosition(i);
+        header.orientation[0] = orientation.w();
+        header.orientation[1] = orientation.x();
+        header.orientation[2] = orientation.y();
+        header.orientation[3] = orientation.z();
+
+        std::vector<uint8_t> atomicNumbers(nAtoms);
+        for (uint64_t i = 0; i < nAtoms; i++)
+            atomicNumbers[i] = uint8_t(molecule->atom(i)->atomicNumber());
+
+        const molconv::AtomMask originMask = fullMask(molecule->originList(), nAtoms);
+        const molconv::AtomMask basisMask = fullMask(molecule->basisList(), nAtoms);
+
+        success = writePadded(file, &header, sizeof(RecordHeader))
+                && writePadded(file, name.data(), name.size())
+                && writePadded(file, atomicNumbers.data(), nAtoms)
+                && writePadded(file, originMask.words().data(), 8 * originMask.words().size())
+                && writePadded(file, basisMask.words().data(), 8 * basisMask.words().size())
+                && writePadded(file, molecule->internalPositions().data(), 3 * 8 * nAtoms);
+    }
+
+    file.close();
+
+    return success;
+}
@@ -0,0 +1,101 @@
+/*
+ * Copyright 2014 - 2019 Jan von Cosel & Sebastian Lenz
+ *
+ * This file is part of molconv.
+ *
+ * molconv is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * molconv is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have recieved a copy of the GNU General Public License
+ * along with molconv. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#ifndef MOLCONVBINARYFILE_H
+#define MOLCONVBINARYFILE_H
+
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <QFile>
+#include <QString>
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+#include "types.h"
+#include "atommask.h"
+
+///
+/// \brief The MolconvBinaryFile class
+///
+/// a versioned binary container for molconv sessions. The file starts with a
+/// header, followed by one record per molecule that holds the origin and basis
+/// parameters, the atomic numbers, the origin and basis atom lists as packed
+/// bit masks and the internal coordinates as one contiguous 3xN block. All
+/// blocks are aligned to 8 bytes, so that the file can be mapped into memory
+/// and the coordinates used in place without parsing or copying.
+///
+class MolconvBinaryFile
+{
+public:
+    ///
+    /// \brief The Record struct
+    ///
+    /// a view of one molecule in the mapped file. It is only valid as long
+    /// as the file stays open.
+    ///
+    struct Record
+    {
+        Record();
+
+        std::string name;
+        size_t nAtoms;
+        molconv::OriginCode originCode;
+        int originAtoms[2];
+        double originFactor;
+        Eigen::Vector3d originPosition;
+        molconv::BasisCode basisCode;
+        int basisAtoms[3];
+        Eigen::Quaternion<double,Eigen::DontAlign> orientation;
+        const uint8_t *atomicNumbers;
+        const uint64_t *originMask;
+        const uint64_t *basisMask;
+        const double *positions;
+
+        Eigen::Map<const Eigen::Matrix3Xd> internalPositions() const;
+        molconv::AtomMask originList() const;
+        molconv::AtomMask basisList() const;
+    };
+
+    static const uint32_t kVersion = 1;
+
+    MolconvBinaryFile();
+    ~MolconvBinaryFile();
+
+    bool open(const QString &fileName);
+    void close();
+
+    size_t moleculeCount() const;
+    Record record(const size_t index) const;
+
+    static bool write(const QString &fileName, const std::vector<molconv::moleculePtr> &molecules);
+
+private:
+    MolconvBinaryFile(const MolconvBinaryFile &);
+    MolconvBinaryFile &operator=(const MolconvBinaryFile &);
+
+    QFile m_file;
+    const uchar *m_data;
+    qint64 m_size;
+    std::vector<qint64> m_offsets;
+};
+
+#endif // MOLCONVBINARYFILE_H
@@ -19,219 +19,276 @@
  */
 
 
+#include <stdexcept>
 #include <QFile>
-#include <QDomDocument>
-#include <QTextStream>
+#include <QXmlStreamReader>
+#include <QXmlStreamWriter>
 #include <Eigen/Core>
-#ifndef Q_MOC_RUN
-    #include<chemkit/bondpredictor.h>
-#endif
 
 #include "molecule.h"
 #include "moleculeorigin.h"
 #include "moleculebasis.h"
 #include "moleculegroup.h"
 #include "system.h"
+#include "compresseddevice.h"
+#include "molconvbinaryfile.h"
 #include "molconvfile.h"
 
 MolconvFile::MolconvFile()
 {
 }
 
+/*
+ * Check if the file name has one of the endings of a molconv
+ * session file: ".mcv", ".mcv.gz", ".mcv.zst" or ".mcb"
+ */
+bool MolconvFile::isMolconvFile(const QString &fileName)
+{
+    return fileName.endsWith(".mcv") || fileName.endsWith(".mcv.gz") || fileName.endsWith(".mcv.zst") || fileName.endsWith(".mcb");
+}
+
 bool MolconvFile::read(const QString &fileName)
 {
-    // check if we have the correct ending ".mcv"
-    if (!fileName.endsWith(".mcv"))
+    if (fileName.endsWith(".mcb"))
+    {
+        return readBinary(fileName);
+    }
+
+    // check if we have the correct ending ".mcv", ".mcv.gz" or ".mcv.zst"
+    if (!isMolconvFile(fileName))
     {
         return false;
     }
+    CompressedDevice::Compression compression = CompressedDevice::compressionOf(fileName);
     QFile file(fileName);
     if (!file.exists())
     {
         return false;
     }
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+    if (!file.open(compression == CompressedDevice::kNoCompression ? QIODevice::ReadOnly | QIODevice::Text : QIODevice::ReadOnly))
     {
         return false;
     }
 
-    QDomDocument testDoc;
-    testDoc.setContent(&file);
-    file.close();
+    // compressed files are decompressed on the fly while they are parsed:
+    CompressedDevice compressedFile(&file, compression);
+    QIODevice *device = &file;
+    if (compression != CompressedDevice::kNoCompression)
+    {
+        if (!compressedFile.open(QIODevice::ReadOnly))
+        {
+            return false;
+        }
+        device = &compressedFile;
+    }
 
-    QDomElement systemElement = testDoc.documentElement();
+    // the file is parsed as a stream, so that only the molecule
+    // that is currently being read has to be kept in memory:
+    QXmlStreamReader reader(device);
 
-    QDomNode moleculeNode = systemElement.firstChild();
+    if (!reader.readNextStartElement() || reader.name() != "System")
+    {
+        return false;
+    }
 
-    while (! moleculeNode.isNull())
+    while (reader.readNextStartElement())
     {
-        QDomElement moleculeElement = moleculeNode.toElement();
-        if (! moleculeElement.isNull())
+        if (reader.name() == "Molecule")
         {
-            molconv::moleculePtr currentMolecule(new molconv::Molecule);
-
-            currentMolecule->setName(moleculeElement.attribute("Name").toStdString());
-
-            // create the origin and the basis to transform the atoms to their global positions
-            // since only the internal positions are saved in the molconv file:
-            QDomElement originElement = moleculeElement.elementsByTagName("Origin").at(0).toElement();
-
-            molconv::OriginCode originCode = static_cast<molconv::OriginCode>(originElement.attribute("Type").toInt());
-            double vecx = originElement.attribute("vecX").toDouble();
-            double vecy = originElement.attribute("vecY").toDouble();
-            double vecz = originElement.attribute("vecZ").toDouble();
-            QString originAtomString = originElement.attribute("Atoms");
-            QString originListString = originElement.attribute("originList");
-            double originFactor = originElement.attribute("Factor").toDouble();
-
-            Eigen::Vector3d originVec(vecx, vecy, vecz);
-            int oA1, oA2;
-            oA1 = originAtomString.split(",").at(0).toInt();
-            oA2 = originAtomString.split(",").at(1).toInt();
-            std::vector<bool> originList;
-            for (int i = 0; i < originListString.split(",").length(); i++)
-                if (originListString.split(",").at(i) == "T")
-                    originList.push_back(true);
-                else
-                    originList.push_back(false);
-
-            QDomElement basisElement = moleculeElement.elementsByTagName("Basis").at(0).toElement();
-
-            molconv::BasisCode basisCode = static_cast<molconv::BasisCode>(basisElement.attribute("Type").toInt());
-            double phi = basisElement.attribute("phi").toDouble();
-            double theta = basisElement.attribute("theta").toDouble();
-            double psi = basisElement.attribute("psi").toDouble();
-            QString basisAtomString = basisElement.attribute("Atoms");
-            QString basisListString = basisElement.attribute("basisList");
-
-            int bA1, bA2, bA3;
-            bA1 = basisAtomString.split(",").at(0).toInt();
-            bA2 = basisAtomString.split(",").at(1).toInt();
-            bA3 = basisAtomString.split(",").at(2).toInt();
-            std::vector<bool> basisList;
-            for (int i = 0; i < basisListString.split(",").length(); i++)
-                if (basisListString.split(",").at(i) == "T")
-                    basisList.push_back(true);
-                else
-                    basisList.push_back(false);
-
-            Eigen::MatrixXd trafo(molconv::MoleculeBasis::euler2rot(psi, theta, phi));
-
-            QDomNode atomNode = basisElement.nextSibling();
-
-            while (! atomNode.isNull())
+            molconv::moleculePtr currentMolecule = readMolecule(reader);
+            if (!currentMolecule)
             {
-                QDomElement atomElement = atomNode.toElement();
-                if (! atomElement.isNull())
-                {
-                    double x = atomElement.attribute("X").toDouble();
-                    double y = atomElement.attribute("Y").toDouble();
-                    double z = atomElement.attribute("Z").toDouble();
-                    std::string element = atomElement.attribute("Ele").toStdString();
-
-                    Eigen::Vector3d intPos(x, y, z);
-                    Eigen::Vector3d globalPos(originVec + trafo * intPos);
-
-                    chemkit::Atom *currentAtom = currentMolecule->addAtom(chemkit::Element(element));
-
-                    currentAtom->setPosition(globalPos);
-                }
-                atomNode = atomNode.nextSibling();
+                return false;
             }
 
-            currentMolecule->setOrigin(originCode, originList, oA1, oA2, originFactor);
-            currentMolecule->setBasis(basisCode, basisList, bA1, bA2, bA3);
-
-            chemkit::BondPredictor::predictBonds(currentMolecule.get());
             m_molecules.push_back(currentMolecule);
         }
-        moleculeNode = moleculeNode.nextSibling();
+        else
+        {
+            reader.skipCurrentElement();
+        }
     }
-    return true;
+
+    return !reader.hasError();
 }
 
-bool MolconvFile::write(const QString &fileName)
+/*
+ * Read a single <Molecule> element. The reader must be positioned at its
+ * start tag, on return it is positioned at the corresponding end tag.
+ */
+molconv::moleculePtr MolconvFile::readMolecule(QXmlStreamReader &reader)
 {
-    // check if we have the correct ending ".mcv"
-    if (!fileName.endsWith(".mcv"))
+    molconv::moleculePtr currentMolecule(new molconv::Molecule);
+    currentMolecule->setName(reader.attributes().value("Name").toString().toStdString());
+
+    molconv::OriginCode originCode = molconv::kCenterOfGeometry;
+    std::vector<int> originAtoms;
+    molconv::AtomMask originList;
+    QString originMask;
+    double originFactor = 0.0;
+    Eigen::Vector3d originVec = Eigen::Vector3d::Zero();
+
+    molconv::BasisCode basisCode = molconv::kCovarianceVectors;
+    std::vector<int> basisAtoms;
+    molconv::AtomMask basisList;
+    QString basisMask;
+    Eigen::Matrix3d trafo = Eigen::Matrix3d::Identity();
+
+    while (reader.readNextStartElement())
     {
-        return false;
-    }
+        QXmlStreamAttributes attributes = reader.attributes();
 
-    molconv::System& system = molconv::System::get();
+        // create the origin and the basis to transform the atoms to their global positions
+        // since only the internal positions are saved in the molconv file:
+        if (reader.name() == "Origin")
+        {
+            originCode = static_cast<molconv::OriginCode>(attributes.value("Type").toInt());
+            originVec(0) = attributes.value("vecX").toDouble();
+            originVec(1) = attributes.value("vecY").toDouble();
+            originVec(2) = attributes.value("vecZ").toDouble();
+            originFactor = attributes.value("Factor").toDouble();
+            originAtoms = parseAtomIndices(attributes.value("Atoms").toString());
+            originMask = attributes.value("originMask").toString();
+            if (attributes.hasAttribute("originList"))
+                originList = parseAtomList(attributes.value("originList").toString());
+        }
+        else if (reader.name() == "Basis")
+        {
+            basisCode = static_cast<molconv::BasisCode>(attributes.value("Type").toInt());
+            double phi = attributes.value("phi").toDouble();
+            double theta = attributes.value("theta").toDouble();
+            double psi = attributes.value("psi").toDouble();
+            basisAtoms = parseAtomIndices(attributes.value("Atoms").toString());
+            basisMask = attributes.value("basisMask").toString();
+            if (attributes.hasAttribute("basisList"))
+                basisList = parseAtomList(attributes.value("basisList").toString());
+
+            trafo = molconv::MoleculeBasis::euler2rot(psi, theta, phi);
+        }
+        else if (reader.name() == "Atom")
+        {
+            Eigen::Vector3d intPos(attributes.value("X").toDouble(),
+                                   attributes.value("Y").toDouble(),
+                                   attributes.value("Z").toDouble());
+            Eigen::Vector3d globalPos(originVec + trafo * intPos);
+
+            chemkit::Atom *currentAtom = currentMolecule->addAtom(chemkit::Element(attributes.value("Ele").toString().toStdString()));
+            if (!currentAtom)
+            {
+                return molconv::moleculePtr();
+            }
+            currentAtom->setPosition(globalPos);
+        }
 
-    QDomDocument document;
-    QDomElement systemElement = document.createElement("System");
-    document.appendChild(systemElement);
+        reader.skipCurrentElement();
+    }
 
-    for (unsigned long id : system.getMolIDs())
+    if (reader.hasError() || originAtoms.size() < 2 || basisAtoms.size() < 3)
     {
-        QDomElement molecule = document.createElement("Molecule");
-        molecule.setAttribute("Name", QString::fromStdString(system.getMolecule(id)->name()));
-
-        QDomElement origin = document.createElement("Origin");
-        origin.setAttribute("Type", QString::number(system.getMolecule(id)->origin()->code()));
-        origin.setAttribute("Factor", QString::number(system.getMolecule(id)->originFactor()));
-
-        QString atomString = QString::number(system.getMolecule(id)->originAtoms()[0]);
-        atomString += ",";
-        atomString += QString::number(system.getMolecule(id)->originAtoms()[1]);
-        origin.setAttribute("Atoms", atomString);
-
-        QString originList;
-        for (int k = 0; k < int(system.getMolecule(id)->size() - 1); k++)
-            if (system.getMolecule(id)->originList()[k])
-                originList += "T,";
-            else
-                originList += "F,";
-        if (system.getMolecule(id)->originList()[system.getMolecule(id)->size() - 1])
-            originList += "T";
+        return molconv::moleculePtr();
+    }
+
+    // the packed masks are only complete once all atoms have been read, the
+    // lists of older files are cut or padded to the number of atoms. An unknown
+    // origin or basis, one on atoms that don't exist, or a center of no atoms
+    // (including a missing list) is rejected:
+    try
+    {
+        if (!originMask.isEmpty())
+            originList = molconv::AtomMask::fromHex(originMask.toStdString(), currentMolecule->size());
         else
-            originList += "F";
-        origin.setAttribute("originList", originList);
-
-        origin.setAttribute("vecX", QString::number(system.getMolecule(id)->originPosition()(0), 'e', 16));
-        origin.setAttribute("vecY", QString::number(system.getMolecule(id)->originPosition()(1), 'e', 16));
-        origin.setAttribute("vecZ", QString::number(system.getMolecule(id)->originPosition()(2), 'e', 16));
-        molecule.appendChild(origin);
-
-        QDomElement basis = document.createElement("Basis");
-        basis.setAttribute("Type", QString::number(system.getMolecule(id)->basis()->code()));
-
-        atomString = QString::number(system.getMolecule(id)->basisAtoms()[0]);
-        atomString += ",";
-        atomString += QString::number(system.getMolecule(id)->basisAtoms()[1]);
-        atomString += ",";
-        atomString += QString::number(system.getMolecule(id)->basisAtoms()[2]);
-        basis.setAttribute("Atoms", atomString);
-
-        QString basisList;
-        for (int k = 0; k < int(system.getMolecule(id)->size() - 1); k++)
-            if (system.getMolecule(id)->basisList()[k])
-                basisList += "T,";
-            else
-                basisList += "F,";
-        if (system.getMolecule(id)->basisList()[system.getMolecule(id)->size() - 1])
-            basisList += "T";
+            originList.resize(currentMolecule->size());
+        if (!basisMask.isEmpty())
+            basisList = molconv::AtomMask::fromHex(basisMask.toStdString(), currentMolecule->size());
         else
-            basisList += "F";
-        basis.setAttribute("basisList", basisList);
+            basisList.resize(currentMolecule->size());
+
+        currentMolecule->setOrigin(originCode, originList, size_t(originAtoms[0]), size_t(originAtoms[1]), originFactor);
+        currentMolecule->setBasis(basisCode, basisList, size_t(basisAtoms[0]), size_t(basisAtoms[1]), size_t(basisAtoms[2]));
+    }
+    catch (const std::invalid_argument &)
+    {
+        return molconv::moleculePtr();
+    }
+
+    return currentMolecule;
+}
+
+/*
+ * Convert a list of the form "T,F,T,..." (as written by older versions
+ * of molconv) to an atom mask.
+ */
+molconv::AtomMask MolconvFile::parseAtomList(const QString &listString)
+{
+    const QStringList items = listString.split(",");
+    molconv::AtomMask list(size_t(items.size()), false);
 
-        basis.setAttribute("phi", QString::number(system.getMolecule(id)->phi(), 'e', 16));
-        basis.setAttribute("theta", QString::number(system.getMolecule(id)->theta(), 'e', 16));
-        basis.setAttribute("psi", QString::number(system.getMolecule(id)->psi(), 'e', 16));
-        molecule.appendChild(basis);
+    for (int i = 0; i < items.size(); i++)
+    {
+        if (items.at(i) == "T")
+            list.set(size_t(i));
+    }
 
-        for (int j = 0; j < int(system.getMolecule(id)->size()); j++)
+    return list;
+}
+
+/*
+ * Convert a list of the form "1,5,7" to a vector of atom indices.
+ */
+std::vector<int> MolconvFile::parseAtomIndices(const QString &indexString)
+{
+    std::vector<int> indices;
+
+    for (auto const& item : indexString.split(","))
+        indices.push_back(item.toInt());
+
+    return indices;
+}
+
+bool MolconvFile::write(const QString &fileName)
+{
+    if (fileName.endsWith(".mcb"))
+    {
+        return writeBinary(fileName);
+    }
+
+    // check if we have the correct ending ".mcv", ".mcv.gz" or ".mcv.zst"
+    if (!isMolconvFile(fileName))
+    {
+        return false;
+    }
+
+    CompressedDevice::Compression compression = CompressedDevice::compressionOf(fileName);
+    QFile file(fileName);
+    if (!file.open(compression == CompressedDevice::kNoCompression ? QIODevice::WriteOnly | QIODevice::Text : QIODevice::WriteOnly))
+    {
+        return false;
+    }
+
+    CompressedDevice compressedFile(&file, compression);
+    QIODevice *device = &file;
+    if (compression != CompressedDevice::kNoCompression)
+    {
+        if (!compressedFile.open(QIODevice::WriteOnly))
         {
-            QDomElement atom = document.createElement("Atom");
-            atom.setAttribute("Ele", QString::fromStdString(system.getMolecule(id)->atom(j)->element().symbol()));
-            atom.setAttribute("X", QString::number(system.getMolecule(id)->internalPositions()[j](0), 'e', 16));
-            atom.setAttribute("Y", QString::number(system.getMolecule(id)->internalPositions()[j](1), 'e', 16));
-            atom.setAttribute("Z", QString::number(system.getMolecule(id)->internalPositions()[j](2), 'e', 16));
-            molecule.appendChild(atom);
+            return false;
         }
-        systemElement.appendChild(molecule);
+        device = &compressedFile;
+    }
+
+    molconv::System& system = molconv::System::get();
+
+    // the document is streamed to the file molecule by molecule
+    // instead of building the complete tree in memory first:
+    QXmlStreamWriter writer(device);
+    writer.setAutoFormatting(true);
+    writer.setAutoFormattingIndent(1);
+
+    writer.writeStartElement("System");
+
+    for (auto const& molecule : system.molecules())
+    {
+        writeMolecule(writer, *molecule);
     }
 
 //    for (int i = 0; i < int(system.nGroups()); i++)
@@ -252,14 +309,110 @@ bool MolconvFile::write(const QString &fileName)
 //        systemElement.appendChild(group);
 //    }
 
-    QFile file(fileName);
-    file.open(QIODevice::WriteOnly | QIODevice::Text);
-    QTextStream stream(&file);
-    stream << document.toString();
+    writer.writeEndElement();
+
+    // the compressed stream has to be finished before the file is closed,
+    // and if either can't write out its remaining data the file is incomplete:
+    bool complete = compression == CompressedDevice::kNoCompression || compressedFile.finish();
+    complete = file.flush() && complete;
     file.close();
+
+    return complete && !writer.hasError();
+}
+
+/*
+ * Write a single molecule as a <Molecule> element.
+ */
+void MolconvFile::writeMolecule(QXmlStreamWriter &writer, const molconv::Molecule &molecule)
+{
+    const Eigen::Vector3d originPosition = molecule.originPosition();
+    const std::array<int,2> originAtoms = molecule.originAtoms();
+    const std::array<int,3> basisAtoms = molecule.basisAtoms();
+    const Eigen::Matrix3Xd &internalPositions = molecule.internalPositions();
+
+    writer.writeStartElement("Molecule");
+    writer.writeAttribute("Name", QString::fromStdString(molecule.name()));
+
+    writer.writeEmptyElement("Origin");
+    writer.writeAttribute("Type", QString::number(molecule.origin()->code()));
+    writer.writeAttribute("Factor", QString::number(molecule.originFactor()));
+    writer.writeAttribute("Atoms", QString::number(originAtoms[0]) + "," + QString::number(originAtoms[1]));
+    writer.writeAttribute("originMask", QString::fromStdString(molecule.originList().toHex()));
+    writer.writeAttribute("vecX", QString::number(originPosition(0), 'e', 16));
+    writer.writeAttribute("vecY", QString::number(originPosition(1), 'e', 16));
+    writer.writeAttribute("vecZ", QString::number(originPosition(2), 'e', 16));
+
+    writer.writeEmptyElement("Basis");
+    writer.writeAttribute("Type", QString::number(molecule.basis()->code()));
+    writer.writeAttribute("Atoms", QString::number(basisAtoms[0]) + "," + QString::number(basisAtoms[1]) + "," + QString::number(basisAtoms[2]));
+    writer.writeAttribute("basisMask", QString::fromStdString(molecule.basisList().toHex()));
+    writer.writeAttribute("phi", QString::number(molecule.phi(), 'e', 16));
+    writer.writeAttribute("theta", QString::number(molecule.theta(), 'e', 16));
+    writer.writeAttribute("psi", QString::number(molecule.psi(), 'e', 16));
+
+    for (int j = 0; j < int(molecule.size()); j++)
+    {
+        writer.writeEmptyElement("Atom");
+        writer.writeAttribute("Ele", QString::fromStdString(molecule.atom(j)->element().symbol()));
+        writer.writeAttribute("X", QString::number(internalPositions(0, j), 'e', 16));
+        writer.writeAttribute("Y", QString::number(internalPositions(1, j), 'e', 16));
+        writer.writeAttribute("Z", QString::number(internalPositions(2, j), 'e', 16));
+    }
+
+    writer.writeEndElement();
+}
+
+/*
+ * Read a binary session file. The file has been validated when it was opened,
+ * so the atoms are created from the atomic numbers and all positions are
+ * computed from the mapped internal coordinates in one pass and handed to the
+ * coordinate store at once. The origin and basis are defined by the atoms, so
+ * they are set up from the codes and lists again rather than restored from
+ * the stored pose, which they reproduce.
+ */
+bool MolconvFile::readBinary(const QString &fileName)
+{
+    MolconvBinaryFile file;
+    if (!file.open(fileName))
+    {
+        return false;
+    }
+
+    for (size_t i = 0; i < file.moleculeCount(); i++)
+    {
+        MolconvBinaryFile::Record record = file.record(i);
+
+        molconv::moleculePtr currentMolecule(new molconv::Molecule);
+        currentMolecule->setName(record.name);
+
+        for (size_t j = 0; j < record.nAtoms; j++)
+        {
+            if (!currentMolecule->addAtom(chemkit::Element(record.atomicNumbers[j])))
+            {
+                return false;
+            }
+        }
+
+        Eigen::Matrix3d trafo = record.orientation.toRotationMatrix();
+        currentMolecule->setPositions((trafo * record.internalPositions()).colwise() + record.originPosition);
+
+        currentMolecule->setOrigin(record.originCode, record.originList(), size_t(record.originAtoms[0]), size_t(record.originAtoms[1]), record.originFactor);
+        currentMolecule->setBasis(record.basisCode, record.basisList(), size_t(record.basisAtoms[0]), size_t(record.basisAtoms[1]), size_t(record.basisAtoms[2]));
+
+        m_molecules.push_back(currentMolecule);
+    }
+
     return true;
 }
 
+/*
+ * Write all molecules of the system to a binary session file.
+ */
+bool MolconvFile::writeBinary(const QString &fileName)
+{
+    return MolconvBinaryFile::write(fileName, molconv::System::get().molecules());
+}
+
 std::vector<molconv::moleculePtr> MolconvFile::molecules()
 {
     return m_molecules;
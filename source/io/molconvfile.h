@@ -26,17 +26,35 @@
 #include <vector>
 #include <QString>
 #include "types.h"
+#include "atommask.h"
+
+class QXmlStreamReader;
+class QXmlStreamWriter;
+
+namespace molconv
+{
+    class Molecule;
+}
 
 class MolconvFile
 {
 public:
     MolconvFile();
 
+    static bool isMolconvFile(const QString &fileName);
+
     bool write(const QString &fileName);
     bool read(const QString &fileName);
 
     std::vector<molconv::moleculePtr> molecules();
 private:
+    bool readBinary(const QString &fileName);
+    bool writeBinary(const QString &fileName);
+    molconv::moleculePtr readMolecule(QXmlStreamReader &reader);
+    static void writeMolecule(QXmlStreamWriter &writer, const molconv::Molecule &molecule);
+    static molconv::AtomMask parseAtomList(const QString &listString);
+    static std::vector<int> parseAtomIndices(const QString &indexString);
+
     std::vector<molconv::moleculePtr> m_molecules;
 };
 
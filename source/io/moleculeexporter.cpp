@@ -0,0 +1,489 @@
+/*
+ * Copyright 2014 - 2019 Jan von Cosel & Sebastian Lenz
+ *
+ * This file is part of molconv.
+ *
+ * molconv is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * molconv is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have recieved a copy of the GNU General Public License
+ * along with molconv. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include <algorithm>
+#include <cstdarg>
+#include <cstdio>
+#include <locale.h>
+#include <QFile>
+#include <QFileInfo>
+#ifndef Q_MOC_RUN
+    #include<chemkit/bond.h>
+#endif
+
+#include "molecule.h"
+#include "moleculeexporter.h"
+
+namespace
+{
+    // the size of the output buffer before it is written to the file:
+    const size_t kFlushSize = size_t(1) << 20;
+
+    ///
+    /// switches the calling thread to the C locale for numbers while it
+    /// exists, so that printf writes a decimal point whatever the locale of
+    /// the application is. Other threads are not affected.
+    ///
+    class CNumericLocale
+    {
+    public:
+        CNumericLocale()
+            : m_locale(newlocale(LC_NUMERIC_MASK, "C", locale_t(0)))
+            , m_previous(m_locale ? uselocale(m_locale) : locale_t(0))
+        {
+        }
+
+        ~CNumericLocale()
+        {
+            if (m_locale)
+            {
+                uselocale(m_previous);
+                freelocale(m_locale);
+            }
+        }
+
+    private:
+        CNumericLocale(const CNumericLocale &);
+        CNumericLocale &operator=(const CNumericLocale &);
+
+        locale_t m_locale;
+        locale_t m_previous;
+    };
+}
+
+MoleculeExporter::MoleculeExporter()
+    : m_merged(false)
+    , m_device(0)
+{
+}
+
+///
+/// \brief MoleculeExporter::formatFromFileName
+/// \param fileName
+/// \return
+///
+/// the format of the file \p fileName as given by its extension
+///
+MoleculeExporter::Format MoleculeExporter::formatFromFileName(const QString &fileName)
+{
+    const QString suffix = QFileInfo(fileName).suffix().toLower();
+
+    if (suffix == "xyz")
+        return kXyzFormat;
+    else if (suffix == "pdb" || suffix == "ent")
+        return kPdbFormat;
+    else if (suffix == "mol")
+        return kMolFormat;
+    else if (suffix == "sdf" || suffix == "sd")
+        return kSdfFormat;
+    else if (suffix == "mol2")
+        return kMol2Format;
+    else
+        return kUnknownFormat;
+}
+
+bool MoleculeExporter::canExport(const QString &fileName)
+{
+    return formatFromFileName(fileName) != kUnknownFormat;
+}
+
+void MoleculeExporter::addMolecule(const molconv::moleculePtr &molecule)
+{
+    m_molecules.push_back(molecule);
+}
+
+size_t MoleculeExporter::moleculeCount() const
+{
+    return m_molecules.size();
+}
+
+///
+/// \brief MoleculeExporter::setMerged
+/// \param merged
+/// \param name
+///
+/// write all molecules as a single structure with the title \p name
+///
+void MoleculeExporter::setMerged(const bool merged, const std::string &name)
+{
+    m_merged = merged;
+    m_mergedName = name;
+}
+
+bool MoleculeExporter::isMerged() const
+{
+    return m_merged;
+}
+
+///
+/// \brief MoleculeExporter::write
+/// \param fileName
+/// \return
+///
+/// write the molecules to the file \p fileName, the format is chosen from its extension
+///
+bool MoleculeExporter::write(const QString &fileName)
+{
+    const Format format = formatFromFileName(fileName);
+    if (format == kUnknownFormat)
+    {
+        m_errorString = QString("the format of %1 is not supported").arg(fileName);
+        return false;
+    }
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        m_errorString = file.errorString();
+        return false;
+    }
+
+    return write(&file, format);
+}
+
+bool MoleculeExporter::write(QIODevice *device, const Format format)
+{
+    m_errorString.clear();
+
+    if (format == kUnknownFormat)
+    {
+        m_errorString = "unknown format";
+        return false;
+    }
+
+    if (m_molecules.empty())
+    {
+        m_errorString = "no molecules to write";
+        return false;
+    }
+
+    m_device = device;
+    m_buffer.clear();
+    m_buffer.reserve(kFlushSize + 256);
+
+    const CNumericLocale numericLocale;
+
+    // a molfile holds exactly one structure:
+    std::vector<Record> records;
+    if (m_merged || format == kMolFormat)
+        records.push_back(m_molecules);
+    else
+    {
+        for (auto const& molecule : m_molecules)
+            records.push_back(Record(1, molecule));
+    }
+
+    for (size_t i = 0; i < records.size(); i++)
+    {
+        const std::string name = records.size() == 1 && !m_mergedName.empty() ? m_mergedName : records[i].front()->name();
+
+        switch (format)
+        {
+        case kXyzFormat:
+            writeXyz(records[i], name);
+            break;
+        case kPdbFormat:
+            writePdb(records[i], name, records.size() > 1 ? int(i) + 1 : 0);
+            break;
+        case kMolFormat:
+        case kSdfFormat:
+            writeMdl(records[i], name);
+            if (format == kSdfFormat)
+                append("$$$$\n");
+            break;
+        case kMol2Format:
+            writeMol2(records[i], name);
+            break;
+        default:
+            break;
+        }
+    }
+
+    if (format == kPdbFormat)
+        append("END\n");
+
+    flush(true);
+    m_device = 0;
+
+    return m_errorString.isEmpty();
+}
+
+QString MoleculeExporter::errorString() const
+{
+    return m_errorString;
+}
+
+void MoleculeExporter::writeXyz(const Record &record, const std::string &name)
+{
+    size_t nAtoms = 0;
+    for (auto const& molecule : record)
+        nAtoms += molecule->size();
+
+    append("%zu\n%s\n", nAtoms, name.c_str());
+
+    for (auto const& molecule : record)
+    {
+        const Eigen::Matrix3Xd &positions = molecule->positions();
+        for (size_t i = 0; i < molecule->size(); i++)
+            append("%-3s%16.8f%16.8f%16.8f\n", molecule->atom(i)->symbol().c_str(), positions(0,i), positions(1,i), positions(2,i));
+    }
+}
+
+///
+/// \brief MoleculeExporter::writePdb
+/// \param record
+/// \param name
+/// \param model
+///
+/// write the record as HETATM entries, one residue per molecule. If \p model is
+/// positive, the record is enclosed in a MODEL section with this number.
+///
+void MoleculeExporter::writePdb(const Record &record, const std::string &name, const int model)
+{
+    if (model > 0)
+        append("MODEL     %4d\n", model);
+    else
+        append("COMPND    %.70s\n", name.c_str());
+
+    size_t serial = 0;
+    for (size_t m = 0; m < record.size(); m++)
+    {
+        const Eigen::Matrix3Xd &positions = record[m]->positions();
+        for (size_t i = 0; i < record[m]->size(); i++)
+        {
+            const std::string symbol = record[m]->atom(i)->symbol();
+
+            // one-letter elements start in the second column of the atom name:
+            char atomName[8];
+            std::snprintf(atomName, sizeof(atomName), symbol.size() == 1 ? " %-3s" : "%-4s", symbol.c_str());
+
+            serial++;
+            append("HETATM%5zu %4s MOL %c%4zu    %8.3f%8.3f%8.3f  1.00  0.00          %2s\n",
+                   serial % 100000, atomName, 'A', (m + 1) % 10000,
+                   positions(0,i), positions(1,i), positions(2,i), symbol.c_str());
+        }
+    }
+
+    // the atom serial numbers are limited to five digits:
+    if (serial < 100000)
+    {
+        std::vector<std::vector<size_t>> neighbors(serial);
+        for (auto const& bond : bondList(record))
+        {
+            neighbors[bond[0]].push_back(bond[1]);
+            neighbors[bond[1]].push_back(bond[0]);
+        }
+
+        for (size_t i = 0; i < neighbors.size(); i++)
+        {
+            for (size_t j = 0; j < neighbors[i].size(); j += 4)
+            {
+                append("CONECT%5zu", i + 1);
+                for (size_t k = j; k < std::min(j + 4, neighbors[i].size()); k++)
+                    append("%5zu", neighbors[i][k] + 1);
+                append("\n");
+            }
+        }
+    }
+
+    if (model > 0)
+        append("ENDMDL\n");
+}
+
+///
+/// \brief MoleculeExporter::writeMdl
+/// \param record
+/// \param name
+///
+/// write the record as an mdl connection table. The V2000 format is limited
+/// to 999 atoms and bonds, larger structures are written in the V3000 format.
+///
+void MoleculeExporter::writeMdl(const Record &record, const std::string &name)
+{
+    const std::vector<std::array<size_t,3>> bonds = bondList(record);
+
+    size_t nAtoms = 0;
+    for (auto const& molecule : record)
+        nAtoms += molecule->size();
+
+    append("%.80s\n  molconv\n\n", name.c_str());
+
+    if (nAtoms <= 999 && bonds.size() <= 999)
+    {
+        append("%3zu%3zu  0  0  0  0  0  0  0  0999 V2000\n", nAtoms, bonds.size());
+
+        for (auto const& molecule : record)
+        {
+            const Eigen::Matrix3Xd &positions = molecule->positions();
+            for (size_t i = 0; i < molecule->size(); i++)
+                append("%10.4f%10.4f%10.4f %-3s 0  0  0  0  0  0  0  0  0  0  0  0\n",
+                       positions(0,i), positions(1,i), positions(2,i), molecule->atom(i)->symbol().c_str());
+        }
+
+        for (auto const& bond : bonds)
+            append("%3zu%3zu%3zu  0\n", bond[0] + 1, bond[1] + 1, bond[2]);
+    }
+    else
+    {
+        append("  0  0  0     0  0            999 V3000\n");
+        append("M  V30 BEGIN CTAB\nM  V30 COUNTS %zu %zu 0 0 0\nM  V30 BEGIN ATOM\n", nAtoms, bonds.size());
+
+        size_t index = 0;
+        for (auto const& molecule : record)
+        {
+            const Eigen::Matrix3Xd &positions = molecule->positions();
+            for (size_t i = 0; i < molecule->size(); i++)
+                append("M  V30 %zu %s %.4f %.4f %.4f 0\n",
+                       ++index, molecule->atom(i)->symbol().c_str(), positions(0,i), positions(1,i), positions(2,i));
+        }
+
+        append("M  V30 END ATOM\n");
+        if (!bonds.empty())
+        {
+            append("M  V30 BEGIN BOND\n");
+            for (size_t i = 0; i < bonds.size(); i++)
+                append("M  V30 %zu %zu %zu %zu\n", i + 1, bonds[i][2], bonds[i][0] + 1, bonds[i][1] + 1);
+            append("M  V30 END BOND\n");
+        }
+        append("M  V30 END CTAB\n");
+    }
+
+    append("M  END\n");
+}
+
+///
+/// \brief MoleculeExporter::writeMol2
+/// \param record
+/// \param name
+///
+/// write the record as a tripos mol2 molecule, one substructure per molecule.
+/// The atom types are the element symbols.
+///
+void MoleculeExporter::writeMol2(const Record &record, const std::string &name)
+{
+    const std::vector<std::array<size_t,3>> bonds = bondList(record);
+
+    size_t nAtoms = 0;
+    for (auto const& molecule : record)
+        nAtoms += molecule->size();
+
+    append("@<TRIPOS>MOLECULE\n%s\n%zu %zu %zu 0 0\nSMALL\nNO_CHARGES\n\n@<TRIPOS>ATOM\n",
+           name.c_str(), nAtoms, bonds.size(), record.size());
+
+    size_t index = 0;
+    for (size_t m = 0; m < record.size(); m++)
+    {
+        const Eigen::Matrix3Xd &positions = record[m]->positions();
+        for (size_t i = 0; i < record[m]->size(); i++)
+        {
+            const std::string symbol = record[m]->atom(i)->symbol();
+
+            char atomName[32];
+            std::snprintf(atomName, sizeof(atomName), "%s%zu", symbol.c_str(), i + 1);
+
+            index++;
+            append("%7zu %-8s %10.4f %10.4f %10.4f %-5s %4zu MOL%zu 0.0000\n",
+                   index, atomName, positions(0,i), positions(1,i), positions(2,i), symbol.c_str(), m + 1, m + 1);
+        }
+    }
+
+    append("@<TRIPOS>BOND\n");
+    for (size_t i = 0; i < bonds.size(); i++)
+        append("%6zu %5zu %5zu %zu\n", i + 1, bonds[i][0] + 1, bonds[i][1] + 1, bonds[i][2]);
+}
+
+///
+/// \brief MoleculeExporter::bondList
+/// \param record
+/// \return
+///
+/// the bonds of all molecules in the record as pairs of atom indices within the
+/// record together with their bond order. Bonds are perceived if necessary.
+///
+std::vector<std::array<size_t,3>> MoleculeExporter::bondList(const Record &record) const
+{
+    std::vector<std::array<size_t,3>> bonds;
+
+    size_t offset = 0;
+    for (auto const& molecule : record)
+    {
+        molecule->perceiveBonds();
+
+        for (auto const& bond : molecule->bonds())
+        {
+            std::array<size_t,3> entry = {{offset + bond->atom1()->index(), offset + bond->atom2()->index(), size_t(bond->order())}};
+            bonds.push_back(entry);
+        }
+
+        offset += molecule->size();
+    }
+
+    return bonds;
+}
+
+void MoleculeExporter::append(const char *format, ...)
+{
+    char line[256];
+
+    va_list args;
+    va_start(args, format);
+    int length = std::vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+
+    if (length < 0)
+        return;
+
+    if (size_t(length) < sizeof(line))
+        m_buffer.append(line, size_t(length));
+    else
+    {
+        // long lines (e.g. titles) are formatted again with enough space:
+        std::vector<char> longLine(size_t(length) + 1);
+        va_start(args, format);
+        std::vsnprintf(longLine.data(), longLine.size(), format, args);
+        va_end(args);
+        m_buffer.append(longLine.data(), size_t(length));
+    }
+
+    if (m_buffer.size() >= kFlushSize)
+        flush();
+}
+
+///
+/// \brief MoleculeExporter::flush
+/// \param force
+/// \return
+///
+/// write the buffer to the device once it is full (or always, if \p force is set)
+///
+bool MoleculeExporter::flush(const bool force)
+{
+    if (m_buffer.empty() || (!force && m_buffer.size() < kFlushSize))
+        return true;
+
+    bool success = m_errorString.isEmpty() && m_device->write(m_buffer.data(), qint64(m_buffer.size())) == qint64(m_buffer.size());
+    if (!success && m_errorString.isEmpty())
+        m_errorString = m_device->errorString();
+
+    m_buffer.clear();
+
+    return success;
+}
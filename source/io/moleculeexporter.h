@@ -0,0 +1,96 @@
+/*
+ * Copyright 2014 - 2019 Jan von Cosel & Sebastian Lenz
+ *
+ * This file is part of molconv.
+ *
+ * molconv is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * molconv is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have recieved a copy of the GNU General Public License
+ * along with molconv. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#ifndef MOLECULEEXPORTER_H
+#define MOLECULEEXPORTER_H
+
+
+#include <array>
+#include <string>
+#include <vector>
+#include <QIODevice>
+#include <QString>
+#include "types.h"
+
+///
+/// \brief The MoleculeExporter class
+///
+/// writes molecules to xyz, pdb, mdl (mol/sdf) and mol2 files straight from
+/// their coordinate arrays. No chemkit atoms are copied or synchronized and
+/// no temporary molecule is built, the records are formatted into a buffer
+/// that is flushed to the file in large blocks. Other formats have to be
+/// written with chemkit.
+///
+/// The molecules are either written as separate records or, if merged, as a
+/// single structure containing the atoms of all of them.
+///
+class MoleculeExporter
+{
+public:
+    enum Format
+    {
+        kUnknownFormat,
+        kXyzFormat,
+        kPdbFormat,
+        kMolFormat,
+        kSdfFormat,
+        kMol2Format
+    };
+
+    MoleculeExporter();
+
+    static Format formatFromFileName(const QString &fileName);
+    static bool canExport(const QString &fileName);
+
+    void addMolecule(const molconv::moleculePtr &molecule);
+    size_t moleculeCount() const;
+
+    void setMerged(const bool merged, const std::string &name = std::string());
+    bool isMerged() const;
+
+    bool write(const QString &fileName);
+    bool write(QIODevice *device, const Format format);
+
+    QString errorString() const;
+
+private:
+    typedef std::vector<molconv::moleculePtr> Record;
+
+    void writeXyz(const Record &record, const std::string &name);
+    void writePdb(const Record &record, const std::string &name, const int model);
+    void writeMdl(const Record &record, const std::string &name);
+    void writeMol2(const Record &record, const std::string &name);
+
+    std::vector<std::array<size_t,3>> bondList(const Record &record) const;
+
+    void append(const char *format, ...);
+    bool flush(const bool force = false);
+
+    std::vector<molconv::moleculePtr> m_molecules;
+    bool m_merged;
+    std::string m_mergedName;
+
+    QIODevice *m_device;
+    std::string m_buffer;
+    QString m_errorString;
+};
+
+#endif // MOLECULEEXPORTER_H
@@ -0,0 +1,453 @@
+/*
+ * Copyright 2014 - 2019 Jan von Cosel & Sebastian Lenz
+ *
+ * This file is part of molconv.
+ *
+ * molconv is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * molconv is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have recieved a copy of the GNU General Public License
+ * along with molconv. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <QFile>
+#include <QFileInfo>
+#include "moleculefileprobe.h"
+
+namespace
+{
+    enum Format {
+        kUnknown,
+        kXyz,
+        kSdf,
+        kMol2,
+        kPdb
+    };
+
+    Format formatOf(const QString &fileName)
+    {
+        const QString suffix = QFileInfo(fileName).suffix().toLower();
+
+        if (suffix == "xyz")
+            return kXyz;
+        if (suffix == "sdf" || suffix == "sd" || suffix == "mol" || suffix == "mdl")
+            return kSdf;
+        if (suffix == "mol2")
+            return kMol2;
+        if (suffix == "pdb")
+            return kPdb;
+
+        return kUnknown;
+    }
+
+    ///
+    /// a cursor over the lines of the mapped file
+    ///
+    class LineReader
+    {
+    public:
+        LineReader(const char *data, const size_t size)
+            : m_end(data + size)
+            , m_pos(data)
+        {
+        }
+
+        bool atEnd() const
+        {
+            return m_pos >= m_end;
+        }
+
+        // the next line without the line break:
+        std::string next()
+        {
+            const char *begin = m_pos;
+            const char *end = skip();
+
+            if (end > begin && end[-1] == '\r')
+                end--;
+
+            return std::string(begin, end);
+        }
+
+        // move to the next line, returns the end of the current one:
+        const char *skip()
+        {
+            const char *newline = static_cast<const char *>(std::memchr(m_pos, '\n', size_t(m_end - m_pos)));
+            const char *end = newline ? newline : m_end;
+
+            m_pos = newline ? newline + 1 : m_end;
+
+            return end;
+        }
+
+        // move to the line after the next one starting with \p marker, returns false if there is none:
+        bool skipPast(const char *marker)
+        {
+            const size_t length = std::strlen(marker);
+
+            while (! atEnd())
+            {
+                const bool found = size_t(m_end - m_pos) >= length && std::memcmp(m_pos, marker, length) == 0;
+                skip();
+
+                if (found)
+                    return true;
+            }
+
+            return false;
+        }
+
+        bool startsWith(const char *marker) const
+        {
+            const size_t length = std::strlen(marker);
+
+            return size_t(m_end - m_pos) >= length && std::memcmp(m_pos, marker, length) == 0;
+        }
+
+    private:
+        const char *m_end;
+        const char *m_pos;
+    };
+
+    std::string trimmed(const std::string &text)
+    {
+        size_t begin = 0;
+        size_t end = text.size();
+
+        while (begin < end && std::isspace(static_cast<unsigned char>(text[begin])))
+            begin++;
+        while (end > begin && std::isspace(static_cast<unsigned char>(text[end - 1])))
+            end--;
+
+        return text.substr(begin, end - begin);
+    }
+
+    bool parseCount(const std::string &text, size_t &count)
+    {
+        const std::string number = trimmed(text);
+        if (number.empty())
+            return false;
+
+        char *end = 0;
+        const long value = std::strtol(number.c_str(), &end, 10);
+
+        if (value < 0 || (*end != '\0' && ! std::isspace(static_cast<unsigned char>(*end))))
+            return false;
+
+        count = size_t(value);
+        return true;
+    }
+
+    bool scanXyz(LineReader &reader, std::vector<MoleculeFileProbe::Entry> &entries, const size_t maxMolecules)
+    {
+        while (! reader.atEnd() && entries.size() < maxMolecules)
+        {
+            const std::string countLine = reader.next();
+            if (trimmed(countLine).empty())
+                continue;
+
+            MoleculeFileProbe::Entry entry;
+            if (! parseCount(countLine, entry.atomCount))
+                return false;
+
+            entry.name = trimmed(reader.next());
+            entries.push_back(entry);
+
+            for (size_t i = 0; i < entry.atomCount && ! reader.atEnd(); i++)
+                reader.skip();
+        }
+
+        return true;
+    }
+
+    bool scanSdf(LineReader &reader, std::vector<MoleculeFileProbe::Entry> &entries, const size_t maxMolecules)
+    {
+        while (! reader.atEnd() && entries.size() < maxMolecules)
+        {
+            MoleculeFileProbe::Entry entry;
+            entry.name = trimmed(reader.next());
+
+            reader.skip();
+            reader.skip();
+            const std::string countsLine = reader.next();
+
+            if (countsLine.find("V3000") != std::string::npos)
+            {
+                // the counts are in the "M  V30 COUNTS na nb ..." line of the ctab:
+                while (! reader.atEnd() && ! reader.startsWith("M  V30 COUNTS"))
+                    reader.skip();
+
+                if (reader.atEnd() || ! parseCount(reader.next().substr(13), entry.atomCount))
+                    return false;
+            }
+            else if (! parseCount(countsLine.substr(0, 3), entry.atomCount))
+            {
+                return false;
+            }
+
+            entries.push_back(entry);
+
+            // a single mol file has no separator:
+            if (! reader.skipPast("$$$$"))
+                break;
+
+            // skip blank lines at the end of the file:
+            while (! reader.atEnd() && (reader.startsWith("\n") || reader.startsWith("\r\n")))
+                reader.skip();
+        }
+
+        return true;
+    }
+
+    bool scanMol2(LineReader &reader, std::vector<MoleculeFileProbe::Entry> &entries, const size_t maxMolecules)
+    {
+        while (entries.size() < maxMolecules && reader.skipPast("@<TRIPOS>MOLECULE"))
+        {
+            MoleculeFileProbe::Entry entry;
+            entry.name = trimmed(reader.next());
+
+            if (! parseCount(reader.next(), entry.atomCount))
+                return false;
+
+            entries.push_back(entry);
+        }
+
+        return true;
+    }
+
+    bool scanPdb(LineReader &reader, std::vector<MoleculeFileProbe::Entry> &entries, const size_t maxMolecules)
+    {
+        MoleculeFileProbe::Entry entry;
+        entry.atomCount = 0;
+
+        while (! reader.atEnd() && entries.size() < maxMolecules)
+        {
+            if (reader.startsWith("ATOM  ") || reader.startsWith("HETATM"))
+            {
+                entry.atomCount++;
+            }
+            else if (reader.startsWith("COMPND") && entry.name.empty())
+            {
+                const std::string line = reader.next();
+                const size_t colon = line.find("MOLECULE:");
+                entry.name = trimmed(colon == std::string::npos ? line.substr(std::min<size_t>(10, line.size())) : line.substr(colon + 9));
+                if (! entry.name.empty() && entry.name.back() == ';')
+                    entry.name.pop_back();
+                continue;
+            }
+            else if (reader.startsWith("ENDMDL") && entry.atomCount > 0)
+            {
+                // every model is a molecule of its own:
+                const std::string name = entry.name;
+                entries.push_back(entry);
+                entry.atomCount = 0;
+                entry.name = name;
+            }
+
+            reader.skip();
+        }
+
+        if (entry.atomCount > 0 && entries.size() < maxMolecules)
+            entries.push_back(entry);
+
+        return true;
+    }
+
+    std::mutex cacheMutex;
+    std::map<QString, MoleculeFileProbe> cache;
+}
+
+MoleculeFileProbe::MoleculeFileProbe()
+    : m_fileSize(0)
+    , m_valid(false)
+    , m_complete(false)
+{
+}
+
+bool MoleculeFileProbe::canProbe(const QString &fileName)
+{
+    return formatOf(fileName) != kUnknown;
+}
+
+///
+/// \brief MoleculeFileProbe::probeFile
+/// \param fileName
+/// \param maxMolecules
+/// \return
+///
+/// the probe of the file \p fileName, covering at least its first
+/// \p maxMolecules molecules. The file is only scanned, if it has changed since
+/// the last call or if fewer of its molecules have been scanned than needed.
+///
+MoleculeFileProbe MoleculeFileProbe::probeFile(const QString &fileName, const size_t maxMolecules)
+{
+    const QFileInfo info(fileName);
+    const QString key = info.absoluteFilePath();
+
+    {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        auto cached = cache.find(key);
+
+        if (cached != cache.end()
+                && cached->second.m_fileSize == info.size()
+                && cached->second.m_lastModified == info.lastModified()
+                && (cached->second.m_complete || cached->second.moleculeCount() >= maxMolecules))
+            return cached->second;
+    }
+
+    MoleculeFileProbe result;
+    if (result.probe(fileName, maxMolecules))
+    {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        cache[key] = result;
+    }
+
+    return result;
+}
+
+///
+/// \brief MoleculeFileProbe::probe
+/// \param fileName
+/// \param maxMolecules
+/// \return
+///
+/// scan the headers of the first \p maxMolecules molecules of the file \p fileName
+///
+bool MoleculeFileProbe::probe(const QString &fileName, const size_t maxMolecules)
+{
+    m_fileName = fileName;
+    m_entries.clear();
+    m_valid = false;
+    m_complete = false;
+
+    const Format format = formatOf(fileName);
+    if (format == kUnknown)
+    {
+        m_errorString = "the format of " + fileName + " can not be probed";
+        return false;
+    }
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        m_errorString = file.errorString();
+        return false;
+    }
+
+    const QFileInfo info(file);
+    m_fileSize = info.size();
+    m_lastModified = info.lastModified();
+
+    const char *data = 0;
+    if (m_fileSize > 0)
+    {
+        data = reinterpret_cast<const char *>(file.map(0, m_fileSize));
+        if (!data)
+        {
+            m_errorString = file.errorString();
+            return false;
+        }
+    }
+
+    LineReader reader(data, size_t(m_fileSize));
+    bool success = false;
+
+    switch (format)
+    {
+    case kXyz:
+        success = scanXyz(reader, m_entries, maxMolecules);
+        break;
+    case kSdf:
+        success = scanSdf(reader, m_entries, maxMolecules);
+        break;
+    case kMol2:
+        success = scanMol2(reader, m_entries, maxMolecules);
+        break;
+    case kPdb:
+        success = scanPdb(reader, m_entries, maxMolecules);
+        break;
+    case kUnknown:
+        break;
+    }
+
+    m_complete = success && (reader.atEnd() || m_entries.size() < maxMolecules);
+
+    if (data)
+        file.unmap(reinterpret_cast<uchar *>(const_cast<char *>(data)));
+
+    if (!success)
+    {
+        m_errorString = "unexpected header in " + fileName;
+        m_entries.clear();
+        return false;
+    }
+
+    m_valid = true;
+    return true;
+}
+
+bool MoleculeFileProbe::isValid() const
+{
+    return m_valid;
+}
+
+///
+/// \brief MoleculeFileProbe::isComplete
+/// \return
+///
+/// whether all molecules of the file have been scanned
+///
+bool MoleculeFileProbe::isComplete() const
+{
+    return m_complete;
+}
+
+size_t MoleculeFileProbe::moleculeCount() const
+{
+    return m_entries.size();
+}
+
+size_t MoleculeFileProbe::atomCount(const size_t index) const
+{
+    return m_entries.at(index).atomCount;
+}
+
+std::string MoleculeFileProbe::name(const size_t index) const
+{
+    return m_entries.at(index).name;
+}
+
+std::vector<std::string> MoleculeFileProbe::names() const
+{
+    std::vector<std::string> result;
+    result.reserve(m_entries.size());
+
+    for (auto const& entry : m_entries)
+        result.push_back(entry.name);
+
+    return result;
+}
+
+const std::vector<MoleculeFileProbe::Entry> &MoleculeFileProbe::entries() const
+{
+    return m_entries;
+}
+
+QString MoleculeFileProbe::errorString() const
+{
+    return m_errorString;
+}
@@ -0,0 +1,80 @@
+/*
+ * Copyright 2014 - 2019 Jan von Cosel & Sebastian Lenz
+ *
+ * This file is part of molconv.
+ *
+ * molconv is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * molconv is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have recieved a copy of the GNU General Public License
+ * along with molconv. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#ifndef MOLECULEFILEPROBE_H
+#define MOLECULEFILEPROBE_H
+
+
+#include <limits>
+#include <string>
+#include <vector>
+#include <QDateTime>
+#include <QString>
+
+///
+/// \brief The MoleculeFileProbe class
+///
+/// the number of molecules in a molecule file together with the name and the
+/// number of atoms of each of them, found by scanning only the header lines
+/// of the records (the count lines of xyz files, the header blocks and "$$$$"
+/// separators of sd files, the molecule sections of mol2 files and the models
+/// of pdb files) without parsing any coordinates. Other formats can't be
+/// probed, these have to be read with chemkit.
+///
+/// The results are cached per file, so that the import dialog and the import
+/// itself only scan a file once as long as it does not change.
+///
+class MoleculeFileProbe
+{
+public:
+    struct Entry
+    {
+        std::string name;
+        size_t atomCount;
+    };
+
+    MoleculeFileProbe();
+
+    static bool canProbe(const QString &fileName);
+    static MoleculeFileProbe probeFile(const QString &fileName, const size_t maxMolecules = std::numeric_limits<size_t>::max());
+
+    bool probe(const QString &fileName, const size_t maxMolecules = std::numeric_limits<size_t>::max());
+
+    bool isValid() const;
+    bool isComplete() const;
+    size_t moleculeCount() const;
+    size_t atomCount(const size_t index) const;
+    std::string name(const size_t index) const;
+    std::vector<std::string> names() const;
+    const std::vector<Entry> &entries() const;
+    QString errorString() const;
+
+private:
+    QString m_fileName;
+    qint64 m_fileSize;
+    QDateTime m_lastModified;
+    std::vector<Entry> m_entries;
+    bool m_valid;
+    bool m_complete;
+    QString m_errorString;
+};
+
+#endif // MOLECULEFILEPROBE_H
@@ -0,0 +1,219 @@
+/*
+ * Copyright 2014 - 2019 Jan von Cosel & Sebastian Lenz
+ *
+ * This file is part of molconv.
+ *
+ * molconv is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * molconv is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have recieved a copy of the GNU General Public License
+ * along with molconv. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#ifndef Q_MOC_RUN
+    #include<chemkit/moleculefile.h>
+#endif
+
+#include "molecule.h"
+#include "parallelfor.h"
+#include "moleculeimporter.h"
+
+MoleculeImporter::MoleculeImporter(QObject *parent)
+    : QThread(parent)
+    , m_originCode(molconv::kCenterOfGeometry)
+    , m_originFactor(0.0)
+    , m_basisCode(molconv::kCovarianceVectors)
+    , m_cancelled(false)
+    , m_filesDone(0)
+    , m_imported(0)
+{
+    qRegisterMetaType<molconv::moleculePtr>();
+
+    m_originAtoms.fill(0);
+    m_basisAtoms.fill(0);
+}
+
+void MoleculeImporter::addFile(const QString &fileName)
+{
+    Job job;
+    job.fileName = fileName;
+
+    addJob(job);
+}
+
+void MoleculeImporter::addJob(const Job &job)
+{
+    m_jobs.push_back(job);
+}
+
+int MoleculeImporter::jobCount() const
+{
+    return int(m_jobs.size());
+}
+
+///
+/// \brief MoleculeImporter::setOrigin
+///
+/// the internal origin that is given to all imported molecules
+///
+void MoleculeImporter::setOrigin(const molconv::OriginCode code, const size_t atom1, const size_t atom2, const double factor)
+{
+    m_originCode = code;
+    m_originAtoms[0] = atom1;
+    m_originAtoms[1] = atom2;
+    m_originFactor = factor;
+}
+
+///
+/// \brief MoleculeImporter::setBasis
+///
+/// the internal basis that is given to all imported molecules
+///
+void MoleculeImporter::setBasis(const molconv::BasisCode code, const size_t atom1, const size_t atom2, const size_t atom3)
+{
+    m_basisCode = code;
+    m_basisAtoms[0] = atom1;
+    m_basisAtoms[1] = atom2;
+    m_basisAtoms[2] = atom3;
+}
+
+bool MoleculeImporter::isCancelled() const
+{
+    return m_cancelled;
+}
+
+int MoleculeImporter::importedCount() const
+{
+    return m_imported;
+}
+
+///
+/// \brief MoleculeImporter::cancel
+///
+/// stop the import after the files and molecules that are currently being
+/// processed. Molecules that have already been handed out are kept.
+///
+void MoleculeImporter::cancel()
+{
+    m_cancelled = true;
+}
+
+void MoleculeImporter::run()
+{
+    // load the chemkit file format plugins before the workers need them:
+    chemkit::MoleculeFile::formats();
+
+    const int nJobs = int(m_jobs.size());
+    emit progress(0, nJobs);
+
+    // a single file is split over its molecules, several files over the files:
+    molconv::parallelFor(m_jobs.size(), [&](const size_t j)
+    {
+        if (m_cancelled)
+            return;
+
+        importJob(m_jobs[j], nJobs == 1);
+        emit progress(++m_filesDone, nJobs);
+    });
+}
+
+void MoleculeImporter::importJob(const Job &job, const bool parallel)
+{
+    boost::shared_ptr<chemkit::MoleculeFile> file = job.file;
+
+    if (!file)
+    {
+        file.reset(new chemkit::MoleculeFile(job.fileName.toStdString()));
+        if (!file->read())
+        {
+            emit fileFailed(job.fileName, QString::fromStdString(file->errorString()));
+            return;
+        }
+    }
+
+    if (file->moleculeCount() == 0)
+    {
+        emit fileFailed(job.fileName, tr("No molecule found in file"));
+        return;
+    }
+
+    std::vector<size_t> indices;
+    for (size_t i = 0; i < file->moleculeCount(); i++)
+    {
+        if (job.selection.empty() || (i < job.selection.size() && job.selection[i]))
+            indices.push_back(i);
+    }
+
+    std::string baseName = job.name.isEmpty()
+            ? job.fileName.split("/").last().split(".").first().toStdString()
+            : job.name.toStdString();
+
+    std::vector<molconv::moleculePtr> molecules(indices.size());
+
+    auto convertAt = [&](const size_t k)
+    {
+        if (m_cancelled)
+            return;
+
+        std::string name = baseName;
+        if (indices.size() > 1)
+            name += "_" + std::to_string(k + 1);
+
+        molecules[k] = convert(file->molecule(indices[k]), name);
+    };
+
+    if (parallel)
+        molconv::parallelFor(indices.size(), convertAt);
+    else
+        for (size_t k = 0; k < indices.size(); k++)
+            convertAt(k);
+
+    // hand the molecules out in the order of the file. The ones that are
+    // missing without a cancellation couldn't be given their origin and basis:
+    for (size_t k = 0; k < molecules.size(); k++)
+    {
+        if (molecules[k])
+        {
+            m_imported++;
+            emit moleculeImported(molecules[k]);
+        }
+        else if (!m_cancelled)
+        {
+            emit fileFailed(job.fileName, tr("The origin or basis can't be set up for molecule %1").arg(indices[k] + 1));
+        }
+    }
+}
+
+///
+/// \brief MoleculeImporter::convert
+///
+/// the molecule \p baseMolecule with the importer's origin and basis, or a
+/// null pointer if they can't be set up for its atoms (e.g. because the atom
+/// indices they refer to don't exist in this molecule)
+///
+molconv::moleculePtr MoleculeImporter::convert(const boost::shared_ptr<chemkit::Molecule> &baseMolecule, const std::string &name) const
+{
+    molconv::moleculePtr molecule(new molconv::Molecule(baseMolecule));
+
+    molconv::AtomMask allAtoms(molecule->size(), true);
+    if (!molconv::Molecule::isValidOrigin(m_originCode, molecule->size(), allAtoms, m_originAtoms[0], m_originAtoms[1])
+            || !molconv::Molecule::isValidBasis(m_basisCode, molecule->size(), allAtoms, m_basisAtoms[0], m_basisAtoms[1], m_basisAtoms[2]))
+    {
+        return molconv::moleculePtr();
+    }
+
+    molecule->setOrigin(m_originCode, allAtoms, m_originAtoms[0], m_originAtoms[1], m_originFactor);
+    molecule->setBasis(m_basisCode, allAtoms, m_basisAtoms[0], m_basisAtoms[1], m_basisAtoms[2]);
+    molecule->setName(name);
+
+    return molecule;
+}
@@ -0,0 +1,114 @@
+/*
+ * Copyright 2014 - 2019 Jan von Cosel & Sebastian Lenz
+ *
+ * This file is part of molconv.
+ *
+ * molconv is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * molconv is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have recieved a copy of the GNU General Public License
+ * along with molconv. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#ifndef MOLECULEIMPORTER_H
+#define MOLECULEIMPORTER_H
+
+
+#include <array>
+#include <atomic>
+#include <vector>
+#include <QMetaType>
+#include <QString>
+#include <QThread>
+#ifndef Q_MOC_RUN
+    #include <boost/shared_ptr.hpp>
+#endif
+#include "types.h"
+
+namespace chemkit
+{
+    class Molecule;
+    class MoleculeFile;
+}
+
+Q_DECLARE_METATYPE(molconv::moleculePtr)
+
+///
+/// \brief The MoleculeImporter class
+///
+/// imports molecules from chemkit readable files in a background thread.
+/// Each file is parsed, its molecules are converted to molconv molecules and
+/// given their internal origin and basis. The files (or the molecules of a
+/// single file) are spread over a pool of worker threads and every finished
+/// molecule is handed to the receiver of moleculeImported(), which is meant
+/// to live in the GUI thread.
+///
+class MoleculeImporter : public QThread
+{
+    Q_OBJECT
+
+public:
+    struct Job
+    {
+        QString fileName;
+
+        // the file, if it has already been read (otherwise it is read by the importer):
+        boost::shared_ptr<chemkit::MoleculeFile> file;
+
+        // the molecules to import, all of them if empty:
+        std::vector<bool> selection;
+
+        // the base name of the molecules, the file name if empty:
+        QString name;
+    };
+
+    explicit MoleculeImporter(QObject *parent = 0);
+
+    void addFile(const QString &fileName);
+    void addJob(const Job &job);
+    int jobCount() const;
+
+    void setOrigin(const molconv::OriginCode code, const size_t atom1 = 0, const size_t atom2 = 0, const double factor = 0.0);
+    void setBasis(const molconv::BasisCode code, const size_t atom1 = 0, const size_t atom2 = 0, const size_t atom3 = 0);
+
+    bool isCancelled() const;
+    int importedCount() const;
+
+public slots:
+    void cancel();
+
+signals:
+    void moleculeImported(molconv::moleculePtr molecule);
+    void fileFailed(const QString &fileName, const QString &error);
+    void progress(int filesDone, int fileCount);
+
+protected:
+    void run();
+
+private:
+    void importJob(const Job &job, const bool parallel);
+    molconv::moleculePtr convert(const boost::shared_ptr<chemkit::Molecule> &baseMolecule, const std::string &name) const;
+
+    std::vector<Job> m_jobs;
+
+    molconv::OriginCode m_originCode;
+    std::array<size_t,2> m_originAtoms;
+    double m_originFactor;
+    molconv::BasisCode m_basisCode;
+    std::array<size_t,3> m_basisAtoms;
+
+    std::atomic<bool> m_cancelled;
+    std::atomic<int> m_filesDone;
+    std::atomic<int> m_imported;
+};
+
+#endif // MOLECULEIMPORTER_H
@@ -0,0 +1,362 @@
+/*
+ * Copyright 2014 - 2019 Jan von Cosel & Sebastian Lenz
+ *
+ * This file is part of molconv.
+ *
+ * molconv is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * molconv is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have recieved a copy of the GNU General Public License
+ * along with molconv. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <QByteArray>
+#include <QFileInfo>
+#ifndef Q_MOC_RUN
+    #include<chemkit/element.h>
+#endif
+
+#include "molecule.h"
+#include "xyztrajectory.h"
+
+XyzTrajectory::XyzTrajectory(const size_t cacheSize)
+    : m_data(0)
+    , m_size(0)
+    , m_atomCount(0)
+    , m_cacheSize(std::max(cacheSize, size_t(1)))
+    , m_currentFrame(0)
+{
+}
+
+XyzTrajectory::~XyzTrajectory()
+{
+    close();
+}
+
+///
+/// \brief XyzTrajectory::open
+/// \param fileName
+/// \return
+///
+/// map the file \p fileName and index its frames. All frames must have the
+/// same number of atoms.
+///
+bool XyzTrajectory::open(const QString &fileName)
+{
+    close();
+
+    m_file.setFileName(fileName);
+    if (!m_file.open(QIODevice::ReadOnly))
+    {
+        m_errorString = m_file.errorString();
+        return false;
+    }
+
+    m_size = m_file.size();
+    if (m_size > 0)
+        m_data = reinterpret_cast<const char *>(m_file.map(0, m_size));
+
+    if (!m_data)
+    {
+        m_errorString = m_size > 0 ? m_file.errorString() : QString("empty file");
+        close();
+        return false;
+    }
+
+    const char *line = m_data;
+    const char *end = m_data + m_size;
+
+    while (line < end)
+    {
+        const std::string countLine(line, lineEnd(line));
+        char *countEnd = 0;
+        const long count = std::strtol(countLine.c_str(), &countEnd, 10);
+
+        if (countEnd == countLine.c_str())
+        {
+            // blank lines at the end of the file are fine:
+            bool blank = true;
+            for (auto c : countLine)
+                blank = blank && std::isspace(static_cast<unsigned char>(c));
+
+            if (blank)
+            {
+                line = nextLine(line);
+                continue;
+            }
+
+            m_errorString = QString("invalid atom count in frame %1").arg(m_offsets.size() + 1);
+            close();
+            return false;
+        }
+
+        if (m_offsets.empty())
+            m_atomCount = size_t(count);
+
+        if (count < 0 || size_t(count) != m_atomCount)
+        {
+            m_errorString = QString("frame %1 has a different number of atoms").arg(m_offsets.size() + 1);
+            close();
+            return false;
+        }
+
+        m_offsets.push_back(qint64(line - m_data));
+
+        // skip the count line, the comment line and the atoms:
+        line = nextLine(line);
+        for (size_t i = 0; i < m_atomCount + 1 && line < end; i++)
+            line = nextLine(line);
+    }
+
+    if (m_offsets.empty() || m_atomCount == 0)
+    {
+        m_errorString = "no frames found";
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+void XyzTrajectory::close()
+{
+    if (m_data)
+        m_file.unmap(reinterpret_cast<uchar *>(const_cast<char *>(m_data)));
+    if (m_file.isOpen())
+        m_file.close();
+
+    m_data = 0;
+    m_size = 0;
+    m_offsets.clear();
+    m_atomCount = 0;
+    m_cache.clear();
+    m_cacheIndex.clear();
+    m_molecule.reset();
+    m_currentFrame = 0;
+}
+
+QString XyzTrajectory::fileName() const
+{
+    return m_file.fileName();
+}
+
+QString XyzTrajectory::errorString() const
+{
+    return m_errorString;
+}
+
+size_t XyzTrajectory::frameCount() const
+{
+    return m_offsets.size();
+}
+
+size_t XyzTrajectory::atomCount() const
+{
+    return m_atomCount;
+}
+
+std::string XyzTrajectory::comment(const size_t index) const
+{
+    const char *line = nextLine(m_data + m_offsets.at(index));
+    std::string text(line, lineEnd(line));
+
+    if (!text.empty() && text.back() == '\r')
+        text.pop_back();
+
+    return text;
+}
+
+///
+/// \brief XyzTrajectory::frame
+/// \param index
+/// \return
+///
+/// the atomic positions of the frame \p index. The reference stays valid until
+/// the frame is evicted from the cache, i.e. until cacheSize other frames have
+/// been requested.
+///
+const Eigen::Matrix3Xd &XyzTrajectory::frame(const size_t index)
+{
+    if (index >= m_offsets.size())
+        throw std::out_of_range("frame index out of range.\n");
+
+    auto cached = m_cacheIndex.find(index);
+    if (cached != m_cacheIndex.end())
+    {
+        // move the frame to the front of the cache:
+        m_cache.splice(m_cache.begin(), m_cache, cached->second);
+        return m_cache.front().second;
+    }
+
+    if (m_cache.size() >= m_cacheSize)
+    {
+        m_cacheIndex.erase(m_cache.back().first);
+        m_cache.pop_back();
+    }
+
+    m_cache.push_front(CachedFrame(index, Eigen::Matrix3Xd(3, m_atomCount)));
+
+    // a frame that can't be parsed must not stay in the cache:
+    try
+    {
+        decode(index, m_cache.front().second, 0);
+    }
+    catch (...)
+    {
+        m_cache.pop_front();
+        throw;
+    }
+
+    m_cacheIndex[index] = m_cache.begin();
+
+    return m_cache.front().second;
+}
+
+///
+/// \brief XyzTrajectory::createMolecule
+/// \param index
+/// \return
+///
+/// a new molecule with the atoms of frame \p index. Throws if the frame can't
+/// be decoded or names an element that is not known.
+///
+molconv::moleculePtr XyzTrajectory::createMolecule(const size_t index) const
+{
+    if (index >= m_offsets.size())
+        throw std::out_of_range("frame index out of range.\n");
+
+    Eigen::Matrix3Xd positions(3, m_atomCount);
+    std::vector<std::string> elements;
+    decode(index, positions, &elements);
+
+    molconv::moleculePtr newMolecule(new molconv::Molecule);
+    for (size_t i = 0; i < m_atomCount; i++)
+    {
+        const std::string &symbol = elements[i];
+        const bool isNumber = !symbol.empty() && std::isdigit(static_cast<unsigned char>(symbol[0]));
+
+        chemkit::Atom *atom = newMolecule->addAtom(isNumber ? chemkit::Element(std::atoi(symbol.c_str())) : chemkit::Element(symbol));
+        if (!atom)
+            throw std::runtime_error("unknown element " + symbol + " in frame " + std::to_string(index + 1) + ".\n");
+
+        atom->setPosition(Eigen::Vector3d(positions.col(i)));
+    }
+
+    molconv::AtomMask allAtoms(m_atomCount, true);
+    newMolecule->setOrigin(molconv::kCenterOfGeometry, allAtoms);
+    newMolecule->setBasis(molconv::kCovarianceVectors, allAtoms);
+    newMolecule->setName(QFileInfo(fileName()).completeBaseName().toStdString());
+
+    return newMolecule;
+}
+
+///
+/// \brief XyzTrajectory::molecule
+/// \return
+///
+/// the molecule that the frames are loaded into. It is created from the
+/// first frame when it is needed for the first time.
+///
+molconv::moleculePtr XyzTrajectory::molecule()
+{
+    if (!m_molecule && !m_offsets.empty())
+    {
+        m_molecule = createMolecule(0);
+        m_currentFrame = 0;
+    }
+
+    return m_molecule;
+}
+
+///
+/// \brief XyzTrajectory::setFrame
+/// \param index
+///
+/// load the positions of frame \p index into the molecule
+///
+void XyzTrajectory::setFrame(const size_t index)
+{
+    molecule()->setPositions(frame(index));
+    m_currentFrame = index;
+}
+
+size_t XyzTrajectory::currentFrame() const
+{
+    return m_currentFrame;
+}
+
+const char *XyzTrajectory::lineEnd(const char *line) const
+{
+    const char *newline = static_cast<const char *>(std::memchr(line, '\n', size_t(m_data + m_size - line)));
+
+    return newline ? newline : m_data + m_size;
+}
+
+const char *XyzTrajectory::nextLine(const char *line) const
+{
+    const char *end = lineEnd(line);
+
+    return end < m_data + m_size ? end + 1 : end;
+}
+
+void XyzTrajectory::decode(const size_t index, Eigen::Matrix3Xd &positions, std::vector<std::string> *elements) const
+{
+    const char *end = m_data + m_size;
+    const char *line = nextLine(nextLine(m_data + m_offsets[index]));
+
+    if (elements)
+        elements->resize(m_atomCount);
+
+    // each line is copied, since the mapped file is not null terminated:
+    std::string text;
+    for (size_t i = 0; i < m_atomCount; i++)
+    {
+        if (line >= end)
+            throw std::runtime_error("frame " + std::to_string(index + 1) + " is incomplete.\n");
+
+        text.assign(line, lineEnd(line));
+        line = nextLine(line);
+
+        const char *pos = text.c_str();
+        while (std::isspace(static_cast<unsigned char>(*pos)))
+            pos++;
+
+        const char *symbol = pos;
+        while (*pos && !std::isspace(static_cast<unsigned char>(*pos)))
+            pos++;
+
+        if (elements)
+            (*elements)[i].assign(symbol, pos);
+
+        for (int k = 0; k < 3; k++)
+        {
+            while (std::isspace(static_cast<unsigned char>(*pos)))
+                pos++;
+
+            const char *number = pos;
+            while (*pos && !std::isspace(static_cast<unsigned char>(*pos)))
+                pos++;
+
+            // unlike strtod, QByteArray always uses the C locale:
+            bool ok = false;
+            positions(k, i) = QByteArray::fromRawData(number, int(pos - number)).toDouble(&ok);
+
+            if (!ok)
+                throw std::runtime_error("invalid coordinates in frame " + std::to_string(index + 1) + ".\n");
+        }
+    }
+}
@@ -0,0 +1,92 @@
+/*
+ * Copyright 2014 - 2019 Jan von Cosel & Sebastian Lenz
+ *
+ * This file is part of molconv.
+ *
+ * molconv is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * molconv is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have recieved a copy of the GNU General Public License
+ * along with molconv. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#ifndef XYZTRAJECTORY_H
+#define XYZTRAJECTORY_H
+
+
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <QFile>
+#include <QString>
+#include <Eigen/Core>
+#include "types.h"
+
+///
+/// \brief The XyzTrajectory class
+///
+/// a multi-frame xyz file (e.g. from a molecular dynamics run) that is mapped
+/// into memory. Opening the file only indexes the frames, the coordinates of a
+/// frame are parsed when it is requested and kept in a small cache of the most
+/// recently used frames. Instead of one molecule per frame, the frames are
+/// loaded one at a time into a single molecule, so that the memory needed
+/// does not depend on the length of the trajectory.
+///
+class XyzTrajectory
+{
+public:
+    XyzTrajectory(const size_t cacheSize = 8);
+    ~XyzTrajectory();
+
+    bool open(const QString &fileName);
+    void close();
+
+    QString fileName() const;
+    QString errorString() const;
+    size_t frameCount() const;
+    size_t atomCount() const;
+    std::string comment(const size_t index) const;
+
+    const Eigen::Matrix3Xd &frame(const size_t index);
+    molconv::moleculePtr createMolecule(const size_t index) const;
+
+    molconv::moleculePtr molecule();
+    void setFrame(const size_t index);
+    size_t currentFrame() const;
+
+private:
+    typedef std::pair<size_t, Eigen::Matrix3Xd> CachedFrame;
+
+    const char *lineEnd(const char *line) const;
+    const char *nextLine(const char *line) const;
+    void decode(const size_t index, Eigen::Matrix3Xd &positions, std::vector<std::string> *elements) const;
+
+    QFile m_file;
+    const char *m_data;
+    qint64 m_size;
+
+    // the offsets of the count lines of all frames:
+    std::vector<qint64> m_offsets;
+    size_t m_atomCount;
+
+    size_t m_cacheSize;
+    std::list<CachedFrame> m_cache;
+    std::unordered_map<size_t, std::list<CachedFrame>::iterator> m_cacheIndex;
+
+    molconv::moleculePtr m_molecule;
+    size_t m_currentFrame;
+    QString m_errorString;
+};
+
+#endif // XYZTRAJECTORY_H
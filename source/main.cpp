@@ -47,8 +47,7 @@ int main(int argc, char *argv[])
     }
 
     if (app.arguments().size() > 1)
-        for (int i = 1; i < app.arguments().size(); i++)
-            the_window.openFile(app.arguments()[i]);
+        the_window.openFiles(app.arguments().mid(1));
 
     return app.exec();
 }
@@ -49,6 +49,11 @@
 #include "selecttool.h"
 #include "moleculeinfo.h"
 #include "molconvfile.h"
+#include "moleculeimporter.h"
+#include "moleculefileprobe.h"
+#include "xyztrajectory.h"
+#include "trajectoryscrubber.h"
+#include "contactmonitor.h"
 #include "moleculeorigin.h"
 #include "moleculebasis.h"
 
@@ -57,6 +62,10 @@ class MolconvWindowPrivate
 {
 public:
     MolconvWindowPrivate()
+        : m_importer(0)
+        , m_importProgress(0)
+        , m_publishPending(false)
+        , m_contactsPending(false)
     {
     }
 
@@ -68,6 +77,7 @@ public:
     ListOfMolecules *m_ListOfMolecules;
     MoleculeSettings *m_MoleculeSettings;
     MoleculeInfo *m_MoleculeInfo;
+    TrajectoryScrubber *m_TrajectoryScrubber;
 
 //    std::vector<molconv::MoleculeGroup *> m_MoleculeGroups;
     std::map<unsigned long, chemkit::GraphicsMoleculeItem *> m_GraphicsItemMap;
@@ -75,12 +85,28 @@ public:
     std::vector<chemkit::Atom *> m_SelectedAtoms;
 
     GraphicsSelectionItem *m_Selection;
+    GraphicsSelectionItem *m_Clashes;
     unsigned long m_activeMolID;
 
     boost::shared_ptr<NavigateTool> m_navigatetool;
     boost::shared_ptr<SelectTool> m_selecttool;
 
     QString m_currentFile;
+
+    // the running import (if any) and its progress:
+    MoleculeImporter *m_importer;
+    QProgressDialog *m_importProgress;
+    QStringList m_importErrors;
+
+    // the open trajectory, its frames are shown in a single molecule:
+    boost::shared_ptr<XyzTrajectory> m_trajectory;
+
+    // whether a new version of the system will be published for background readers:
+    bool m_publishPending;
+
+    // the clashes and contacts between the molecules, checked while they are moved:
+    molconv::ContactMonitor m_contactMonitor;
+    bool m_contactsPending;
 };
 
 
@@ -97,10 +123,13 @@ MolconvWindow::MolconvWindow(QMainWindow *parent)
     d->m_ListOfMolecules = new ListOfMolecules(this);
     d->m_MoleculeSettings = new MoleculeSettings(this);
     d->m_MoleculeInfo = new MoleculeInfo(this);
+    d->m_TrajectoryScrubber = new TrajectoryScrubber(this);
 
     addDockWidget(Qt::BottomDockWidgetArea, d->m_ListOfMolecules);
     addDockWidget(Qt::LeftDockWidgetArea, d->m_MoleculeSettings);
     addDockWidget(Qt::RightDockWidgetArea, d->m_MoleculeInfo);
+    addDockWidget(Qt::BottomDockWidgetArea, d->m_TrajectoryScrubber);
+    d->m_TrajectoryScrubber->hide();
 
     ui->actionSet_internal_basis->setEnabled(false);
     ui->actionDuplicate->setEnabled(false);
@@ -119,6 +148,8 @@ MolconvWindow::MolconvWindow(QMainWindow *parent)
     connect(ui->actionSave, SIGNAL(triggered()), SLOT(saveFile()));
     connect(ui->actionOpen, SIGNAL(triggered()), SLOT(openFile()));
     connect(ui->actionImport_Molecule, SIGNAL(triggered()), SLOT(startImportDialog()));
+    connect(ui->actionOpen_Trajectory, SIGNAL(triggered()), SLOT(openTrajectory()));
+    connect(d->m_TrajectoryScrubber, SIGNAL(frameChanged(int)), SLOT(showTrajectoryFrame(int)));
     connect(ui->actionExport_Molecule, SIGNAL(triggered()), SLOT(startExportDialog()));
     connect(ui->actionQuit, SIGNAL(triggered()), SLOT(close()));
     connect(ui->actionAbout, SIGNAL(triggered()), SLOT(about()));
@@ -132,6 +163,7 @@ MolconvWindow::MolconvWindow(QMainWindow *parent)
     connect(ui->actionAlign, SIGNAL(triggered()), d->m_ListOfMolecules, SLOT(alignMolecules()));
     connect(ui->actionNavigate, SIGNAL(triggered()), SLOT(useNavigateTool()));
     connect(ui->actionSelect, SIGNAL(triggered()), SLOT(useSelectTool()));
+    connect(ui->actionMonitor_Contacts, SIGNAL(toggled(bool)), SLOT(monitorContacts(bool)));
 
     connect(d->m_ImportDialog, SIGNAL(accepted()), SLOT(importFile()));
 
@@ -154,6 +186,10 @@ MolconvWindow::MolconvWindow(QMainWindow *parent)
     d->m_Selection = new GraphicsSelectionItem;
     ui->molconv_graphicsview->addItem(d->m_Selection);
 
+    d->m_Clashes = new GraphicsSelectionItem;
+    d->m_Clashes->setColor(QColor(255, 48, 48));
+    ui->molconv_graphicsview->addItem(d->m_Clashes);
+
     d->m_navigatetool = boost::make_shared<NavigateTool>();
     d->m_selecttool = boost::make_shared<SelectTool>(this);
     useNavigateTool();
@@ -163,12 +199,21 @@ MolconvWindow::MolconvWindow(QMainWindow *parent)
     d->m_activeMolID = 0;
     d->m_currentFile = QString();
 
-    molconv::Molecule::initRand();
+    molconv::System::get().setMoveCallback([this](const std::vector<unsigned long> &molIDs) { moleculesMoved(molIDs); });
+
+    setAcceptDrops(true);
     setWindowTitle(tr("untitled[*] - molconv"));
 }
 
 MolconvWindow::~MolconvWindow()
 {
+    if (d->m_importer)
+    {
+        d->m_importer->cancel();
+        d->m_importer->wait();
+    }
+
+    molconv::System::get().setMoveCallback(molconv::System::MoveCallback());
     delete ui->molconv_graphicsview;
     delete ui;
     delete d;
@@ -181,6 +226,9 @@ void MolconvWindow::add_molecule(molconv::moleculePtr temp_mol)
     system.addMolecule(temp_mol);
     d->m_activeMolID = temp_mol->molId();
 
+    // the bonds are only needed once the molecule is drawn:
+    temp_mol->syncAtoms();
+    temp_mol->perceiveBonds();
     chemkit::GraphicsMoleculeItem *item = new chemkit::GraphicsMoleculeItem(temp_mol.get());
     d->m_GraphicsItemMap.insert(std::make_pair(d->m_activeMolID, item));
     ui->molconv_graphicsview->addItem(item);
@@ -202,6 +250,9 @@ void MolconvWindow::add_molecule(molconv::moleculePtr temp_mol)
     ui->actionAdd_To_Group->setEnabled(true);
     ui->actionAlign->setEnabled(true);
 
+    publishLater();
+    checkContactsLater();
+
     emit new_molecule(d->m_activeMolID);
 }
 
@@ -231,6 +282,15 @@ void MolconvWindow::removeMolecule(const unsigned long id)
 
     system.removeMolecule(id);
 
+    if (d->m_trajectory && d->m_trajectory->molecule()->molId() == id)
+    {
+        d->m_trajectory.reset();
+        d->m_TrajectoryScrubber->hide();
+    }
+
+    publishLater();
+    checkContactsLater();
+
     ui->molconv_graphicsview->update();
 
     if (system.nMolecules() > 0)
@@ -304,7 +364,7 @@ molconv::moleculePtr MolconvWindow::getMol(const unsigned long key)
     return molconv::System::get().getMolecule(key);
 }
 
-std::vector<unsigned long> MolconvWindow::getMolIDs()
+const std::vector<unsigned long> &MolconvWindow::getMolIDs()
 {
     return molconv::System::get().getMolIDs();
 }
@@ -411,14 +471,23 @@ void MolconvWindow::saveFileAs()
     QSettings settings;
     QString startSavePath = settings.value("savePath").toString();
 
-    QString fileName = QFileDialog::getSaveFileName(this, tr("Save File"), startSavePath, tr("Molconv files (*.mcv)"));
+    QString selectedFilter;
+    QString fileName = QFileDialog::getSaveFileName(this, tr("Save File"), startSavePath,
+                                                    tr("Molconv files (*.mcv);;Compressed molconv files (*.mcv.gz);;Molconv binary files (*.mcb)"), &selectedFilter);
 
     if (!fileName.isEmpty())
     {
         settings.setValue("savePath", QFileInfo(fileName).absolutePath());
 
-        if (fileName.split(".").last() != QString("mcv"))
-            fileName += QString(".mcv");
+        if (!MolconvFile::isMolconvFile(fileName))
+        {
+            if (selectedFilter.contains("*.mcb"))
+                fileName += QString(".mcb");
+            else if (selectedFilter.contains("*.mcv.gz"))
+                fileName += QString(".mcv.gz");
+            else
+                fileName += QString(".mcv");
+        }
 
         writeMolconvFile(fileName);
     }
@@ -434,7 +503,7 @@ void MolconvWindow::openFile()
     QSettings settings;
     QString startOpenPath = settings.value("openPath").toString();
 
-    QString fileName = QFileDialog::getOpenFileName(this, tr("Open File"), startOpenPath, tr("Molconv files (*.mcv)"));
+    QString fileName = QFileDialog::getOpenFileName(this, tr("Open File"), startOpenPath, tr("Molconv files (*.mcv *.mcv.gz *.mcv.zst *.mcb)"));
 
     if (!fileName.isEmpty())
     {
@@ -445,90 +514,269 @@ void MolconvWindow::openFile()
 
 void MolconvWindow::openFile(const QString &fileName)
 {
-    bool result = false;
-    if (fileName.endsWith("mcv"))
+    openFiles(QStringList(fileName));
+}
+
+///
+/// \brief MolconvWindow::openFiles
+/// \param fileNames
+///
+/// open molconv session files directly and import all other files
+/// (in the background) with the settings of the import dialog
+///
+void MolconvWindow::openFiles(const QStringList &fileNames)
+{
+    QStringList moleculeFiles;
+
+    for (auto const& fileName : fileNames)
+    {
+        if (MolconvFile::isMolconvFile(fileName))
+        {
+            if (!readMolconvFile(fileName))
+                QMessageBox::critical(this, "Error", QString("Error opening file: %1").arg(fileName));
+        }
+        else
+        {
+            moleculeFiles << fileName;
+        }
+    }
+
+    if (!moleculeFiles.isEmpty())
+        importFiles(moleculeFiles);
+}
+
+void MolconvWindow::importFile(const QString &fileName, const bool showList)
+{
+    if (! showList)
+    {
+        importFiles(QStringList(fileName));
+        return;
+    }
+
+    MoleculeImporter::Job job;
+    job.fileName = fileName;
+    job.name = d->m_ImportDialog->getMoleculeName();
+
+    // the user may choose from the molecules of the file. Their number and names
+    // are taken from the headers if possible (the probe of the import dialog is
+    // reused), the file is only read here if its format can not be probed:
+    std::vector<std::string> names;
+    MoleculeFileProbe probe = MoleculeFileProbe::probeFile(fileName);
+
+    if (probe.isValid())
     {
-        result = readMolconvFile(fileName);
+        names = probe.names();
     }
     else
     {
-        importFile(fileName);
+        job.file.reset(new chemkit::MoleculeFile(fileName.toStdString()));
+
+        if (! job.file->read())
+        {
+            std::cerr << "Could not read molecule file " << fileName.toStdString() << std::endl;
+            QMessageBox::critical(this, "Error", QString("Error opening file: %1").arg(job.file->errorString().c_str()));
+            return;
+        }
+
+        for (size_t i = 0; i < job.file->moleculeCount(); i++)
+            names.push_back(job.file->molecule(i)->name());
+    }
+
+    if (names.empty())
+    {
+        std::cerr << "No molecule found in file " << fileName.toStdString() << std::endl;
+        QMessageBox::critical(this, "Error", QString("No molecule found in file: %1").arg(fileName));
+        return;
     }
 
-    if (!result)
+    if (names.size() > 1)
     {
-        QMessageBox::critical(this, "Error", QString("Error opening file: %1").arg(fileName));
+        MultiMolDialog *mmd = new MultiMolDialog(this);
+        mmd->createMoleculeList(names);
+        mmd->setWindowTitle("Open '" + fileName.split("/").last() + "'");
+        mmd->exec();
+        job.selection = mmd->molecules();
+        delete mmd;
     }
+
+    MoleculeImporter *importer = new MoleculeImporter(this);
+    importer->addJob(job);
+    startImport(importer);
 }
 
-void MolconvWindow::importFile(const QString &fileName, const bool showList)
+///
+/// \brief MolconvWindow::importFiles
+/// \param fileNames
+///
+/// import all molecules from the files \p fileNames. The files are read and
+/// the molecules are set up in the background, only adding them to the
+/// scene happens in the GUI thread.
+///
+void MolconvWindow::importFiles(const QStringList &fileNames)
 {
-    chemkit::MoleculeFile *molFile = new chemkit::MoleculeFile(fileName.toStdString());
+    MoleculeImporter *importer = new MoleculeImporter(this);
 
-    if (! molFile->read())
+    for (auto const& fileName : fileNames)
+        importer->addFile(fileName);
+
+    startImport(importer);
+}
+
+void MolconvWindow::startImport(MoleculeImporter *importer)
+{
+    if (d->m_importer)
     {
-        std::cerr << "Could not read molecule file " << fileName.toStdString() << std::endl;
-        QMessageBox::critical(this, "Error", QString("Error opening file: %1").arg(molFile->errorString().c_str()));
-        delete molFile;
+        QMessageBox::warning(this, tr("Import running"), tr("Please wait until the current import has finished."));
+        delete importer;
         return;
     }
 
-    if (molFile->moleculeCount() > 0)
-    {
-        std::vector<bool> molsToOpen(molFile->moleculeCount(), true);
+    importer->setOrigin(d->m_ImportDialog->getOriginCode(), size_t(d->m_ImportDialog->getOriginAtom()));
+    importer->setBasis(d->m_ImportDialog->getBasisCode(),
+                       size_t(d->m_ImportDialog->getBasisAtoms()[0]),
+                       size_t(d->m_ImportDialog->getBasisAtoms()[1]),
+                       size_t(d->m_ImportDialog->getBasisAtoms()[2]));
 
-        if (molFile->moleculeCount() > 1 && showList)
-        {
-            MultiMolDialog *mmd = new MultiMolDialog(this);
-            mmd->createMoleculeList(molFile);
-            mmd->setWindowTitle("Open '" + fileName.split("/").last() + "'");
-            mmd->exec();
-            molsToOpen = mmd->molecules();
-            delete mmd;
-        }
+    d->m_importer = importer;
+    d->m_importErrors.clear();
 
-        int index = 0;
-        for (int i = 0; i < int(molsToOpen.size()); i++)
-        {
-            if (molsToOpen.at(i))
-            {
-                index++;
-                chemkit::Molecule tempCMol = *molFile->molecule(i);
-                molconv::moleculePtr tempMol;
-                tempMol.reset(new molconv::Molecule(tempCMol));
-                std::vector<bool> boolVec(tempMol->size(), true);
-                tempMol->setOrigin(d->m_ImportDialog->getOriginCode(), boolVec, d->m_ImportDialog->getOriginAtom());
-                tempMol->setBasis(d->m_ImportDialog->getBasisCode(), boolVec,
-                                  d->m_ImportDialog->getBasisAtoms()[0],
-                                  d->m_ImportDialog->getBasisAtoms()[1],
-                                  d->m_ImportDialog->getBasisAtoms()[2]);
-                QString tempName;
-                if (d->m_ImportDialog->getMoleculeName().isEmpty())
-                {
-                    tempName = fileName.split("/").last().split(".").first();
-                    if (molsToOpen.size() > 1)
-                        tempName += "_" + QString::number(index);
-                }
-                else
-                {
-                    tempName = d->m_ImportDialog->getMoleculeName();
-                    if (molsToOpen.size() > 1)
-                        tempName += "_" + QString::number(index);
-                }
-                tempMol->setName(tempName.toStdString());
-                add_molecule(tempMol);
-            }
-        }
-        delete molFile;
+    d->m_importProgress = new QProgressDialog(tr("Importing molecules..."), tr("Cancel"), 0, importer->jobCount(), this);
+    d->m_importProgress->setMinimumDuration(500);
+
+    connect(importer, SIGNAL(moleculeImported(molconv::moleculePtr)), SLOT(addImportedMolecule(molconv::moleculePtr)));
+    connect(importer, SIGNAL(fileFailed(QString,QString)), SLOT(importFailed(QString,QString)));
+    connect(importer, SIGNAL(progress(int,int)), d->m_importProgress, SLOT(setValue(int)));
+    connect(importer, SIGNAL(finished()), SLOT(importFinished()));
+    connect(d->m_importProgress, SIGNAL(canceled()), importer, SLOT(cancel()));
+
+    importer->start();
+}
+
+void MolconvWindow::addImportedMolecule(molconv::moleculePtr molecule)
+{
+    add_molecule(molecule);
+}
+
+void MolconvWindow::importFailed(const QString &fileName, const QString &error)
+{
+    std::cerr << "Could not import molecule file " << fileName.toStdString() << std::endl;
+    d->m_importErrors << fileName.split("/").last() + ": " + error;
+}
+
+void MolconvWindow::importFinished()
+{
+    MoleculeImporter *importer = d->m_importer;
+    d->m_importer = 0;
+
+    d->m_importProgress->deleteLater();
+    d->m_importProgress = 0;
+
+    if (importer->importedCount() > 0)
         wasModified();
+
+    if (!d->m_importErrors.isEmpty())
+        QMessageBox::critical(this, "Error", QString("Error importing files:\n%1").arg(d->m_importErrors.join("\n")));
+
+    importer->deleteLater();
+}
+
+void MolconvWindow::openTrajectory()
+{
+    QSettings settings;
+    QString startImportPath = settings.value("importPath").toString();
+
+    QString fileName = QFileDialog::getOpenFileName(this, tr("Open Trajectory"), startImportPath, tr("XYZ trajectories (*.xyz)"));
+
+    if (!fileName.isEmpty())
+    {
+        settings.setValue("importPath", QFileInfo(fileName).absolutePath());
+        openTrajectory(fileName);
     }
-    else
+}
+
+///
+/// \brief MolconvWindow::openTrajectory
+/// \param fileName
+/// \return
+///
+/// open the multi-frame xyz file \p fileName as a trajectory. Only a single
+/// molecule is added, its frames are chosen with the trajectory scrubber.
+///
+bool MolconvWindow::openTrajectory(const QString &fileName)
+{
+    boost::shared_ptr<XyzTrajectory> trajectory(new XyzTrajectory);
+
+    if (!trajectory->open(fileName))
     {
-        std::cerr << "No molecule found in file " << fileName.toStdString() << std::endl;
-        QMessageBox::critical(this, "Error", QString("No molecule found in file: %1").arg(molFile->errorString().c_str()));
-        delete molFile;
+        QMessageBox::critical(this, "Error", QString("Error opening trajectory %1: %2").arg(fileName, trajectory->errorString()));
+        return false;
+    }
+
+    // the molecule is created from the first frame, which is only parsed now:
+    molconv::moleculePtr molecule;
+    try
+    {
+        molecule = trajectory->molecule();
+    }
+    catch (const std::exception &error)
+    {
+        QMessageBox::critical(this, "Error", QString("Error opening trajectory %1: %2").arg(fileName, error.what()));
+        return false;
+    }
+
+    // only one trajectory is shown at a time:
+    if (d->m_trajectory)
+        removeMolecule(d->m_trajectory->molecule()->molId());
+
+    d->m_trajectory = trajectory;
+    add_molecule(molecule);
+
+    d->m_TrajectoryScrubber->setFrameCount(int(trajectory->frameCount()));
+    d->m_TrajectoryScrubber->setWindowTitle(tr("Trajectory") + " - " + QFileInfo(fileName).fileName());
+    d->m_TrajectoryScrubber->show();
+
+    wasModified();
+
+    return true;
+}
+
+void MolconvWindow::showTrajectoryFrame(int frame)
+{
+    if (!d->m_trajectory)
         return;
+
+    try
+    {
+        d->m_trajectory->setFrame(size_t(frame));
+    }
+    catch (const std::exception &error)
+    {
+        QMessageBox::critical(this, "Error", QString("Error reading frame %1: %2").arg(frame + 1).arg(error.what()));
+        return;
+    }
+
+    moleculesMoved(std::vector<unsigned long>(1, d->m_trajectory->molecule()->molId()));
+    ui->molconv_graphicsview->update();
+}
+
+void MolconvWindow::dragEnterEvent(QDragEnterEvent *event)
+{
+    if (event->mimeData()->hasUrls())
+        event->acceptProposedAction();
+}
+
+void MolconvWindow::dropEvent(QDropEvent *event)
+{
+    QStringList fileNames;
+
+    for (auto const& url : event->mimeData()->urls())
+    {
+        if (url.isLocalFile())
+            fileNames << url.toLocalFile();
     }
+
+    event->acceptProposedAction();
+    openFiles(fileNames);
 }
 
 void MolconvWindow::selectAtom(chemkit::Atom *theAtom, bool wholeMolecule)
@@ -607,6 +855,8 @@ void MolconvWindow::DuplicateActiveMolecule()
 
 void MolconvWindow::DuplicateMolecule(const unsigned long oldMolID)
 {
+    // the new molecule is built from the chemkit atoms of the old one:
+    getMol(oldMolID)->syncAtoms();
     molconv::moleculePtr newMol = boost::make_shared<molconv::Molecule>(getMol(oldMolID));
 
     add_molecule(newMol);
@@ -679,13 +929,11 @@ void MolconvWindow::ResetView()
 {
     // determine largest distance of any atom from the global origin:
     double maxLength = 0;
-    for (unsigned long id : getMolIDs())
+    for (auto const& mol : molconv::System::get().molecules())
     {
-        molconv::moleculePtr mol = getMol(id);
-
-        for (int j = 0; j < int(mol->size()); j++)
+        if (mol->size() > 0)
         {
-            double length = mol->atom(j)->position().norm();
+            double length = mol->positions().colwise().norm().maxCoeff();
             if (length > maxLength)
                 maxLength = length;
         }
@@ -714,8 +962,8 @@ void MolconvWindow::changeOriginBasis()
 
     double newAtomLineScale = d->m_setBasisDialog->atomLineScale();
 
-    std::vector<bool> newOriginList = d->m_setBasisDialog->selectedOriginAtoms();
-    std::vector<bool> newBasisList = d->m_setBasisDialog->selectedBasisAtoms();
+    molconv::AtomMask newOriginList(d->m_setBasisDialog->selectedOriginAtoms());
+    molconv::AtomMask newBasisList(d->m_setBasisDialog->selectedBasisAtoms());
 
     molconv::moleculePtr tmpMolPtr = getMol(d->m_activeMolID);
 
@@ -726,15 +974,22 @@ void MolconvWindow::changeOriginBasis()
          || newAtomLineScale != tmpMolPtr->originFactor()
          || ! std::equal(newOriginAtoms.begin(), newOriginAtoms.end(), tmpMolPtr->originAtoms().begin())
          || ! std::equal(newBasisAtoms.begin(), newBasisAtoms.end(), tmpMolPtr->basisAtoms().begin())
-         || ! std::equal(newOriginList.begin(), newOriginList.end(), tmpMolPtr->originList().begin())
-         || ! std::equal(newBasisList.begin(), newBasisList.end(), tmpMolPtr->basisList().begin())
+         || newOriginList != tmpMolPtr->originList()
+         || newBasisList != tmpMolPtr->basisList()
             )
     {
         wasModified();
     }
 
-    tmpMolPtr->setOrigin(newOriginCode, newOriginList, size_t(newOriginAtoms[0]), size_t(newOriginAtoms[1]), newAtomLineScale);
-    tmpMolPtr->setBasis(newBasisCode, newBasisList, newBasisAtoms[0], newBasisAtoms[1], newBasisAtoms[2]);
+    try
+    {
+        tmpMolPtr->setOrigin(newOriginCode, newOriginList, size_t(newOriginAtoms[0]), size_t(newOriginAtoms[1]), newAtomLineScale);
+        tmpMolPtr->setBasis(newBasisCode, newBasisList, newBasisAtoms[0], newBasisAtoms[1], newBasisAtoms[2]);
+    }
+    catch (const std::exception &error)
+    {
+        QMessageBox::critical(this, "Error", QString("Error changing the origin and basis: %1").arg(error.what()));
+    }
 
     d->m_MoleculeSettings->setMolecule(d->m_activeMolID);
     updateAxes();
@@ -768,18 +1023,142 @@ void MolconvWindow::wasModified()
 {
     setWindowModified(true);
     ui->actionSave->setEnabled(true);
+    publishLater();
+    checkContactsLater();
+}
+
+///
+/// \brief MolconvWindow::publishLater
+///
+/// publish the state of the system for background readers once control returns
+/// to the event loop, so that a burst of changes (e.g. a slider drag or an import)
+/// only results in a single new version
+///
+void MolconvWindow::publishLater()
+{
+    if (d->m_publishPending)
+        return;
+
+    d->m_publishPending = true;
+    QTimer::singleShot(0, this, SLOT(publishSystem()));
+}
+
+void MolconvWindow::publishSystem()
+{
+    d->m_publishPending = false;
+    molconv::System::get().publish();
+}
+
+///
+/// \brief MolconvWindow::monitorContacts
+/// \param enabled
+///
+/// switch the monitoring of clashes and close contacts between the molecules on or off
+///
+void MolconvWindow::monitorContacts(bool enabled)
+{
+    d->m_contactMonitor.reset();
+    d->m_Clashes->clear();
+
+    if (enabled)
+        checkContactsLater();
+    else
+    {
+        statusBar()->clearMessage();
+        ui->molconv_graphicsview->update();
+    }
+}
+
+///
+/// \brief MolconvWindow::checkContactsLater
+///
+/// check the contacts of the molecules that were moved once control returns to
+/// the event loop, so that a slider drag does not wait for the check
+///
+void MolconvWindow::checkContactsLater()
+{
+    if (!ui->actionMonitor_Contacts->isChecked() || d->m_contactsPending)
+        return;
+
+    d->m_contactsPending = true;
+    QTimer::singleShot(0, this, SLOT(updateContacts()));
+}
+
+///
+/// \brief MolconvWindow::updateContacts
+///
+/// check the contacts for one time budget, highlight the clashing atoms and show
+/// the shortest contact in the status bar. If pairs of molecules are left, the
+/// check continues in the next turn of the event loop.
+///
+void MolconvWindow::updateContacts()
+{
+    d->m_contactsPending = false;
+
+    if (!ui->actionMonitor_Contacts->isChecked())
+        return;
+
+    const bool complete = d->m_contactMonitor.update();
+
+    d->m_Clashes->clear();
+    for (auto const& atom : d->m_contactMonitor.clashingAtoms())
+        d->m_Clashes->addPosition(getMol(atom.first)->atom(atom.second)->position());
+
+    std::vector<molconv::ContactMonitor::Contact> closest = d->m_contactMonitor.closestContacts(1);
+    QString message;
+
+    if (closest.empty())
+        message = tr("No contacts below %1 Å").arg(d->m_contactMonitor.contactCutoff());
+    else
+    {
+        const molconv::ContactMonitor::Contact &contact = closest.front();
+        message = tr("Shortest contact: %1 Å between %2 and %3, %4 clashes")
+                .arg(contact.distance, 0, 'f', 2)
+                .arg(QString::fromStdString(getMol(contact.molId1)->name()))
+                .arg(QString::fromStdString(getMol(contact.molId2)->name()))
+                .arg(d->m_contactMonitor.nClashes());
+    }
+
+    if (!complete)
+        message += " " + tr("(checking...)");
+
+    statusBar()->showMessage(message);
+    ui->molconv_graphicsview->update();
+
+    if (!complete)
+        checkContactsLater();
 }
 
 void MolconvWindow::moveActiveMoleculeTo(const double x, const double y, const double z,
                                          const double phi, const double theta, const double psi)
 {
     getMol(d->m_activeMolID)->moveFromParas(x, y, z, phi, theta, psi);
+    getMol(d->m_activeMolID)->syncAtoms();
     updateAxes();
     updateSelection();
     d->m_MoleculeInfo->updateLive();
     wasModified();
 }
 
+void MolconvWindow::moleculesMoved(const std::vector<unsigned long> &molIDs)
+{
+    for (auto id : molIDs)
+    {
+        getMol(id)->syncAtoms();
+        d->m_GraphicsAxisMap.at(id)->setPosition(getMol(id)->originPosition());
+        d->m_GraphicsAxisMap.at(id)->setVectors(getMol(id)->basisVectors());
+    }
+
+    if (std::find(molIDs.begin(), molIDs.end(), d->m_activeMolID) != molIDs.end())
+    {
+        d->m_MoleculeSettings->setMolecule(d->m_activeMolID);
+        d->m_MoleculeInfo->updateLive();
+    }
+
+    updateSelection();
+    wasModified();
+}
+
 void MolconvWindow::resetCoords()
 {
     std::array<double,6> oB = getMol(d->m_activeMolID)->originalBasis();
@@ -799,10 +1178,46 @@ void MolconvWindow::alignMolecules(std::vector<unsigned long> &molecules)
 {
     unsigned long refMolID = d->m_activeMolID;
 
+    std::vector<unsigned long> otherMolIDs;
     for (auto i : molecules)
     {
         if (i != refMolID)
-            minimizeRMSD(refMolID, i);
+            otherMolIDs.push_back(i);
+    }
+
+    if (otherMolIDs.size() == 1)
+    {
+        minimizeRMSD(refMolID, otherMolIDs.front());
+        return;
+    }
+
+    // the moved molecules are synced by moleculesMoved once the whole batch is done
+    std::vector<double> rmsds = molconv::System::get().alignMoleculesTo(refMolID, otherMolIDs);
+
+    int nAligned = 0;
+    double maxRMSD = 0.0;
+    for (auto rmsd : rmsds)
+    {
+        if (rmsd >= 0.0)
+        {
+            nAligned++;
+            maxRMSD = std::max(maxRMSD, rmsd);
+        }
+    }
+
+    if (nAligned < int(rmsds.size()))
+    {
+        QMessageBox::warning(this, tr("Alignment impossible"), tr("%1 molecules could not be aligned because their number of atoms differs from the reference.").arg(int(rmsds.size()) - nAligned));
+    }
+
+    if (nAligned > 0)
+    {
+        QString message = tr("%1 molecules were aligned to\n'").arg(nAligned)
+                + QString::fromStdString(getMol(refMolID)->name())
+                + tr("'\nwith a largest residual\nRMSD of ")
+                + QString::number(maxRMSD) + QString::fromUtf8(" \u00C5");
+
+        QMessageBox::information(this, tr("RMSD"), message);
     }
 }
 
@@ -861,6 +1276,8 @@ void MolconvWindow::minimizeRMSD(const unsigned long refMolID, const unsigned lo
         return;
     }
 
+    otherMol->syncAtoms();
+
     updateAxes();
     updateSelection();
     d->m_MoleculeInfo->updateLive();
@@ -37,6 +37,8 @@
 
 class ListOfMolecules;
 class MolconvWindowPrivate;
+class MoleculeImporter;
+class XyzTrajectory;
 
 namespace Ui
 {
@@ -53,11 +55,13 @@ public:
     void add_molecule(molconv::moleculePtr temp_mol);
     int nMolecules();
     molconv::moleculePtr getMol(const unsigned long key);
-    std::vector<unsigned long> getMolIDs();
+    const std::vector<unsigned long> &getMolIDs();
 
     unsigned long activeMolID();
 
     void importFile(const QString &fileName, const bool showList = false);
+    void importFiles(const QStringList &fileNames);
+    bool openTrajectory(const QString &fileName);
 
     bool readMolconvFile(const QString &fileName);
     void writeMolconvFile(const QString &fileName);
@@ -69,6 +73,8 @@ public:
 
 protected:
     void closeEvent(QCloseEvent *event);
+    void dragEnterEvent(QDragEnterEvent *event);
+    void dropEvent(QDropEvent *event);
 
 public slots:
     void moveActiveMoleculeTo(const double x, const double y, const double z,
@@ -76,6 +82,8 @@ public slots:
     void importFile();
     void openFile();
     void openFile(const QString &fileName);
+    void openFiles(const QStringList &fileNames);
+    void openTrajectory();
     void saveFile();
     void saveFileAs();
     void startImportDialog();
@@ -101,11 +109,20 @@ public slots:
     void useNavigateTool();
     void useSelectTool();
     void wasModified();
+    void publishLater();
+    void checkContactsLater();
 
 private slots:
     void resetCoords();
     void zeroCoords();
     void updateSelection();
+    void addImportedMolecule(molconv::moleculePtr molecule);
+    void importFailed(const QString &fileName, const QString &error);
+    void importFinished();
+    void showTrajectoryFrame(int frame);
+    void publishSystem();
+    void monitorContacts(bool enabled);
+    void updateContacts();
 
 signals:
     void new_molecule(unsigned long newMolID);
@@ -114,6 +131,8 @@ private:
     void selectAtom(chemkit::Atom *theAtom);
     void deselectAtom(chemkit::Atom *theAtom);
     bool maybeSave();
+    void moleculesMoved(const std::vector<unsigned long> &molIDs);
+    void startImport(MoleculeImporter *importer);
 
     MolconvWindowPrivate *d;
     Ui::MolconvWindow *ui;
@@ -0,0 +1,236 @@
+/*
+ * Copyright 2014 - 2019 Jan von Cosel & Sebastian Lenz
+ *
+ * This file is part of molconv.
+ *
+ * molconv is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * molconv is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have recieved a copy of the GNU General Public License
+ * along with molconv. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include <stdexcept>
+#include "atommask.h"
+
+namespace molconv {
+
+namespace {
+
+size_t wordCount(const size_t nAtoms)
+{
+    return (nAtoms + 63) / 64;
+}
+
+}
+
+AtomMask::AtomMask()
+    : m_size(0)
+{
+}
+
+AtomMask::AtomMask(const size_t nAtoms, const bool value)
+    : m_size(nAtoms)
+    , m_words(wordCount(nAtoms), value ? ~uint64_t(0) : uint64_t(0))
+{
+    clearPadding();
+}
+
+AtomMask::AtomMask(const std::vector<bool> &list)
+    : m_size(list.size())
+    , m_words(wordCount(list.size()), 0)
+{
+    for (size_t i = 0; i < list.size(); i++)
+    {
+        if (list[i])
+            m_words[i / 64] |= uint64_t(1) << (i % 64);
+    }
+}
+
+size_t AtomMask::size() const
+{
+    return m_size;
+}
+
+bool AtomMask::empty() const
+{
+    return m_size == 0;
+}
+
+void AtomMask::resize(const size_t nAtoms, const bool value)
+{
+    const size_t oldSize = m_size;
+
+    m_words.resize(wordCount(nAtoms), value ? ~uint64_t(0) : uint64_t(0));
+    m_size = nAtoms;
+
+    // the new bits in the last old word are not covered by the resize above:
+    if (value && nAtoms > oldSize && oldSize % 64 != 0)
+        m_words[oldSize / 64] |= ~uint64_t(0) << (oldSize % 64);
+
+    clearPadding();
+}
+
+bool AtomMask::test(const size_t index) const
+{
+    if (index >= m_size)
+        throw std::out_of_range("atom index out of range.\n");
+
+    return (m_words[index / 64] >> (index % 64)) & 1;
+}
+
+void AtomMask::set(const size_t index, const bool value)
+{
+    if (index >= m_size)
+        throw std::out_of_range("atom index out of range.\n");
+
+    if (value)
+        m_words[index / 64] |= uint64_t(1) << (index % 64);
+    else
+        m_words[index / 64] &= ~(uint64_t(1) << (index % 64));
+}
+
+///
+/// \brief AtomMask::count
+/// \return
+///
+/// the number of active atoms
+///
+size_t AtomMask::count() const
+{
+    size_t result = 0;
+
+    for (auto word : m_words)
+        result += size_t(__builtin_popcountll(word));
+
+    return result;
+}
+
+bool AtomMask::all() const
+{
+    return count() == m_size;
+}
+
+bool AtomMask::none() const
+{
+    for (auto word : m_words)
+    {
+        if (word != 0)
+            return false;
+    }
+
+    return true;
+}
+
+const std::vector<uint64_t> &AtomMask::words() const
+{
+    return m_words;
+}
+
+std::vector<bool> AtomMask::toVector() const
+{
+    std::vector<bool> list(m_size, false);
+    forEach([&](const size_t i) { list[i] = true; });
+
+    return list;
+}
+
+///
+/// \brief AtomMask::toHex
+/// \return
+///
+/// serialize the mask as a string of hex digits. The k-th digit holds the
+/// atoms 4k to 4k+3, with the lowest bit for the first of them.
+///
+std::string AtomMask::toHex() const
+{
+    static const char digits[] = "0123456789abcdef";
+
+    std::string hex((m_size + 3) / 4, '0');
+    for (size_t k = 0; k < hex.size(); k++)
+        hex[k] = digits[(m_words[k / 16] >> (4 * (k % 16))) & 0xf];
+
+    return hex;
+}
+
+///
+/// \brief AtomMask::fromHex
+/// \param hex
+/// \param nAtoms
+/// \return
+///
+/// the inverse of toHex for a molecule with \p nAtoms atoms. Missing digits
+/// are taken as inactive atoms, invalid digits throw an invalid_argument.
+///
+AtomMask AtomMask::fromHex(const std::string &hex, const size_t nAtoms)
+{
+    AtomMask mask(nAtoms, false);
+
+    for (size_t k = 0; k < hex.size() && 4 * k < nAtoms; k++)
+    {
+        const char c = hex[k];
+        uint64_t value;
+
+        if (c >= '0' && c <= '9')
+            value = uint64_t(c - '0');
+        else if (c >= 'a' && c <= 'f')
+            value = uint64_t(c - 'a' + 10);
+        else if (c >= 'A' && c <= 'F')
+            value = uint64_t(c - 'A' + 10);
+        else
+            throw std::invalid_argument("invalid digit in atom mask.\n");
+
+        mask.m_words[k / 16] |= value << (4 * (k % 16));
+    }
+
+    mask.clearPadding();
+
+    return mask;
+}
+
+///
+/// \brief AtomMask::fromWords
+/// \param words
+/// \param nAtoms
+/// \return
+///
+/// create a mask from the packed words as returned by words()
+///
+AtomMask AtomMask::fromWords(const uint64_t *words, const size_t nAtoms)
+{
+    AtomMask mask;
+    mask.m_size = nAtoms;
+    mask.m_words.assign(words, words + wordCount(nAtoms));
+    mask.clearPadding();
+
+    return mask;
+}
+
+bool AtomMask::operator==(const AtomMask &other) const
+{
+    return m_size == other.m_size && m_words == other.m_words;
+}
+
+bool AtomMask::operator!=(const AtomMask &other) const
+{
+    return !(*this == other);
+}
+
+// keep the unused bits of the last word at zero, so that
+// count() and the comparison can work on whole words
+void AtomMask::clearPadding()
+{
+    if (m_size % 64 != 0)
+        m_words.back() &= (uint64_t(1) << (m_size % 64)) - 1;
+}
+
+}
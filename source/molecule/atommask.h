@@ -0,0 +1,89 @@
+/*
+ * Copyright 2014 - 2019 Jan von Cosel & Sebastian Lenz
+ *
+ * This file is part of molconv.
+ *
+ * molconv is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * molconv is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have recieved a copy of the GNU General Public License
+ * along with molconv. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#ifndef ATOMMASK_H
+#define ATOMMASK_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace molconv {
+
+///
+/// \brief The AtomMask class
+///
+/// a compact set of atoms of a molecule, e.g. the atoms that define the origin
+/// or the basis. The atoms are stored as bits in 64 bit words, so that the
+/// number of active atoms is a popcount per word and loops over the active
+/// atoms can skip whole words of inactive ones.
+///
+class AtomMask
+{
+public:
+    AtomMask();
+    AtomMask(const size_t nAtoms, const bool value);
+    explicit AtomMask(const std::vector<bool> &list);
+
+    size_t size() const;
+    bool empty() const;
+    void resize(const size_t nAtoms, const bool value = false);
+
+    bool test(const size_t index) const;
+    void set(const size_t index, const bool value = true);
+
+    size_t count() const;
+    bool all() const;
+    bool none() const;
+
+    const std::vector<uint64_t> &words() const;
+    std::vector<bool> toVector() const;
+
+    std::string toHex() const;
+    static AtomMask fromHex(const std::string &hex, const size_t nAtoms);
+    static AtomMask fromWords(const uint64_t *words, const size_t nAtoms);
+
+    bool operator==(const AtomMask &other) const;
+    bool operator!=(const AtomMask &other) const;
+
+    ///
+    /// call \p function(i) for the index i of every active atom in ascending order
+    ///
+    template<typename Function>
+    void forEach(Function function) const
+    {
+        for (size_t w = 0; w < m_words.size(); w++)
+        {
+            for (uint64_t word = m_words[w]; word != 0; word &= word - 1)
+                function(w * 64 + size_t(__builtin_ctzll(word)));
+        }
+    }
+
+private:
+    void clearPadding();
+
+    size_t m_size;
+    std::vector<uint64_t> m_words;
+};
+
+}
+
+#endif // ATOMMASK_H
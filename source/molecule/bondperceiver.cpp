@@ -0,0 +1,89 @@
+/*
+ * Copyright 2014 - 2019 Jan von Cosel & Sebastian Lenz
+ *
+ * This file is part of molconv.
+ *
+ * molconv is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * molconv is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have recieved a copy of the GNU General Public License
+ * along with molconv. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include <algorithm>
+#include "cellgrid.h"
+#include "bondperceiver.h"
+
+namespace molconv {
+
+BondPerceiver::BondPerceiver(const double tolerance, const double minimumBondLength)
+    : m_tolerance(tolerance)
+    , m_minimumBondLength(minimumBondLength)
+{
+}
+
+double BondPerceiver::tolerance() const
+{
+    return m_tolerance;
+}
+
+double BondPerceiver::minimumBondLength() const
+{
+    return m_minimumBondLength;
+}
+
+///
+/// \brief BondPerceiver::perceive
+/// \param positions
+/// \param radii
+/// \return
+///
+/// the pairs of bonded atoms (i,j) with i < j, given the atomic \p positions
+/// (one column per atom) and the covalent \p radii of the atoms
+///
+std::vector<BondPerceiver::AtomPair> BondPerceiver::perceive(const Eigen::Matrix3Xd &positions, const Eigen::VectorXd &radii) const
+{
+    std::vector<AtomPair> bonds;
+    const size_t nAtoms = size_t(positions.cols());
+
+    if (nAtoms < 2)
+        return bonds;
+
+    // the cells must hold the longest possible bond, so that only the atoms
+    // in neighbouring cells have to be compared:
+    const double maximumRadius = radii.maxCoeff();
+    CellGrid grid;
+    grid.build(positions, 2.0 * maximumRadius + m_tolerance);
+
+    const double minimumSquared = m_minimumBondLength * m_minimumBondLength;
+
+    for (size_t i = 0; i < nAtoms; i++)
+    {
+        grid.forEachNear(positions.col(i), radii(i) + maximumRadius + m_tolerance, [&](const size_t j)
+        {
+            if (j <= i)
+                return;
+
+            const double maximum = radii(i) + radii(j) + m_tolerance;
+            const double distanceSquared = (positions.col(i) - positions.col(j)).squaredNorm();
+
+            if (distanceSquared >= minimumSquared && distanceSquared <= maximum * maximum)
+                bonds.push_back(AtomPair{{i, j}});
+        });
+    }
+
+    std::sort(bonds.begin(), bonds.end());
+
+    return bonds;
+}
+
+}
@@ -0,0 +1,60 @@
+/*
+ * Copyright 2014 - 2019 Jan von Cosel & Sebastian Lenz
+ *
+ * This file is part of molconv.
+ *
+ * molconv is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * molconv is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have recieved a copy of the GNU General Public License
+ * along with molconv. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#ifndef BONDPERCEIVER_H
+#define BONDPERCEIVER_H
+
+#include <array>
+#include <vector>
+#include <Eigen/Core>
+
+namespace molconv {
+
+///
+/// \brief The BondPerceiver class
+///
+/// find the bonds of a molecule from its atomic positions and the covalent
+/// radii of its atoms. Two atoms are bonded if their distance lies between
+/// the minimum bond length and the sum of their radii plus the tolerance
+/// (the same criterion as chemkit's BondPredictor). The atoms are sorted into
+/// a CellGrid with cells at least as wide as the largest possible bond, so
+/// that only atoms in neighbouring cells have to be compared.
+///
+class BondPerceiver
+{
+public:
+    typedef std::array<size_t,2> AtomPair;
+
+    BondPerceiver(const double tolerance = 0.45, const double minimumBondLength = 0.4);
+
+    double tolerance() const;
+    double minimumBondLength() const;
+
+    std::vector<AtomPair> perceive(const Eigen::Matrix3Xd &positions, const Eigen::VectorXd &radii) const;
+
+private:
+    double m_tolerance;
+    double m_minimumBondLength;
+};
+
+}
+
+#endif // BONDPERCEIVER_H
@@ -0,0 +1,113 @@
+/*
+ * Copyright 2014 - 2019 Jan von Cosel & Sebastian Lenz
+ *
+ * This file is part of molconv.
+ *
+ * molconv is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * molconv is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have recieved a copy of the GNU General Public License
+ * along with molconv. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include "cellgrid.h"
+
+namespace molconv {
+
+CellGrid::CellGrid()
+    : m_cellSize(1.0)
+    , m_lower(Eigen::Vector3d::Zero())
+{
+    m_size.fill(1);
+    m_cellStart.assign(2, 0);
+}
+
+///
+/// \brief CellGrid::build
+/// \param points
+/// \param minimumCellSize
+///
+/// sort the \p points (one column per point) into cells at least
+/// \p minimumCellSize wide, replacing the previous contents of the grid
+///
+void CellGrid::build(const Eigen::Matrix3Xd &points, const double minimumCellSize)
+{
+    const size_t nPoints = size_t(points.cols());
+    m_cellSize = std::max(minimumCellSize, 1.0e-3);
+    m_cellPoints.clear();
+
+    if (nPoints == 0)
+    {
+        m_lower.setZero();
+        m_size.fill(1);
+        m_cellStart.assign(2, 0);
+        return;
+    }
+
+    m_lower = points.rowwise().minCoeff();
+    const Eigen::Vector3d extent = points.rowwise().maxCoeff() - m_lower;
+
+    for (;;)
+    {
+        for (int k = 0; k < 3; k++)
+            m_size[k] = size_t(extent(k) / m_cellSize) + 1;
+
+        if (m_size[0] * m_size[1] * m_size[2] <= 8 * nPoints)
+            break;
+
+        m_cellSize *= 2.0;
+    }
+
+    // sort the points by cell (counting sort):
+    std::vector<uint32_t> cellOf(nPoints);
+    m_cellStart.assign(m_size[0] * m_size[1] * m_size[2] + 1, 0);
+
+    for (size_t i = 0; i < nPoints; i++)
+    {
+        std::array<size_t,3> c;
+        for (int k = 0; k < 3; k++)
+            c[k] = std::min(size_t((points(k, i) - m_lower(k)) / m_cellSize), m_size[k] - 1);
+
+        cellOf[i] = uint32_t((c[2] * m_size[1] + c[1]) * m_size[0] + c[0]);
+        m_cellStart[cellOf[i] + 1]++;
+    }
+
+    for (size_t c = 1; c < m_cellStart.size(); c++)
+        m_cellStart[c] += m_cellStart[c - 1];
+
+    m_cellPoints.resize(nPoints);
+    std::vector<uint32_t> fill(m_cellStart.begin(), m_cellStart.end() - 1);
+    for (size_t i = 0; i < nPoints; i++)
+        m_cellPoints[fill[cellOf[i]]++] = uint32_t(i);
+}
+
+bool CellGrid::empty() const
+{
+    return m_cellPoints.empty();
+}
+
+double CellGrid::cellSize() const
+{
+    return m_cellSize;
+}
+
+const Eigen::Vector3d &CellGrid::lower() const
+{
+    return m_lower;
+}
+
+const std::array<size_t,3> &CellGrid::size() const
+{
+    return m_size;
+}
+
+}
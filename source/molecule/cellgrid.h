@@ -0,0 +1,111 @@
+/*
+ * Copyright 2014 - 2019 Jan von Cosel & Sebastian Lenz
+ *
+ * This file is part of molconv.
+ *
+ * molconv is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * molconv is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have recieved a copy of the GNU General Public License
+ * along with molconv. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#ifndef CELLGRID_H
+#define CELLGRID_H
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include <Eigen/Core>
+
+namespace molconv {
+
+///
+/// \brief The CellGrid class
+///
+/// a uniform grid of cells over a set of points, with the points sorted by
+/// cell (a cell list). The cells are at least as wide as requested and are
+/// enlarged for sparse point sets, so that there are never many more cells
+/// than points. Searching near a position then only visits the points in the
+/// cells that overlap the search box.
+///
+class CellGrid
+{
+public:
+    CellGrid();
+
+    void build(const Eigen::Matrix3Xd &points, const double minimumCellSize);
+
+    bool empty() const;
+    double cellSize() const;
+    const Eigen::Vector3d &lower() const;
+    const std::array<size_t,3> &size() const;
+
+    template <typename Function>
+    void forEachNear(const Eigen::Vector3d &position, const double radius, Function function) const;
+
+private:
+    double m_cellSize;
+    Eigen::Vector3d m_lower;
+    std::array<size_t,3> m_size;
+    std::vector<uint32_t> m_cellStart;
+    std::vector<uint32_t> m_cellPoints;
+};
+
+///
+/// \brief CellGrid::forEachNear
+/// \param position
+/// \param radius
+/// \param function
+///
+/// call \p function with the index of every point in the cells that overlap
+/// the box of half width \p radius around \p position. This includes all
+/// points within \p radius, the caller has to check the actual distances.
+///
+template <typename Function>
+void CellGrid::forEachNear(const Eigen::Vector3d &position, const double radius, Function function) const
+{
+    if (m_cellPoints.empty())
+        return;
+
+    std::array<size_t,3> first, last;
+    for (int k = 0; k < 3; k++)
+    {
+        const double from = std::floor((position(k) - radius - m_lower(k)) / m_cellSize);
+        const double to = std::floor((position(k) + radius - m_lower(k)) / m_cellSize);
+        if (to < 0.0 || from > double(m_size[k] - 1))
+            return;
+
+        first[k] = from > 0.0 ? size_t(from) : 0;
+        last[k] = to < double(m_size[k] - 1) ? size_t(to) : m_size[k] - 1;
+    }
+
+    for (size_t z = first[2]; z <= last[2]; z++)
+    {
+        for (size_t y = first[1]; y <= last[1]; y++)
+        {
+            for (size_t x = first[0]; x <= last[0]; x++)
+            {
+                const size_t cell = (z * m_size[1] + y) * m_size[0] + x;
+
+                for (uint32_t k = m_cellStart[cell]; k < m_cellStart[cell + 1]; k++)
+                    function(size_t(m_cellPoints[k]));
+            }
+        }
+    }
+}
+
+}
+
+#endif // CELLGRID_H
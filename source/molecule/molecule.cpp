@@ -21,12 +21,15 @@
 
 #include<iostream>
 #include<array>
+#include<atomic>
+#include<algorithm>
+#include<cmath>
 #include<stdexcept>
 #include<iomanip>
-#include<random>
+#include<mutex>
+#include<vector>
 #include<Eigen/Geometry>
 #include<Eigen/Eigenvalues>
-#include<chemkit/bondpredictor.h>
 #include "molecule.h"
 #include "moleculeitem.h"
 #include "moleculeoriginonatom.h"
@@ -38,6 +41,8 @@
 #include "moleculebasisglobal.h"
 #include "moleculebasiscovariancematrix.h"
 #include "moleculebasisinertiatensor.h"
+#include "moleculemoments.h"
+#include "bondperceiver.h"
 
 
 namespace molconv
@@ -45,14 +50,123 @@ namespace molconv
     class MoleculePrivate
     {
     public:
+        enum Tensor {
+            kInertia = 0,
+            kCharge = 1,
+            kCovariance = 2
+        };
+
         MoleculePrivate()
         {
+            m_origin = 0;
+            m_basis = 0;
             m_originalOriginBasis.fill(0);
 
-            // generate the molecule's id:
-            int s1 = std::rand();
-            int s2 = std::rand();
-            m_id = (unsigned long) s1 << 32 | s2;
+            m_listItem = 0;
+
+            // the id is given by the system, once the molecule is added:
+            m_id = 0;
+
+            m_generation = 0;
+            m_shapeGeneration = 0;
+            m_cacheGeneration = 0;
+            m_cacheSize = 0;
+            m_cacheHits = 0;
+            m_cacheMisses = 0;
+            m_momentsValid = false;
+            m_eigenValid.fill(false);
+
+            m_atomsStale = false;
+            m_gatheredAtoms = 0;
+            m_bondsPerceived = false;
+        }
+
+        ///
+        /// \brief validateCache
+        /// \param nAtoms
+        ///
+        /// drop all cached properties if the coordinates have changed
+        /// since they were computed
+        ///
+        void validateCache(const Molecule &molecule)
+        {
+            // make sure the coordinate store is up to date first, since
+            // (re-)gathering it increments the generation:
+            size_t nAtoms = size_t(molecule.positions().cols());
+
+            if (m_cacheGeneration != m_generation || m_cacheSize != nAtoms)
+            {
+                m_momentsValid = false;
+                m_eigenValid.fill(false);
+                m_cacheGeneration = m_generation;
+                m_cacheSize = nAtoms;
+            }
+        }
+
+        const MoleculeMoments &moments(const Molecule &molecule)
+        {
+            std::lock_guard<std::recursive_mutex> lock(m_cacheMutex);
+            validateCache(molecule);
+
+            if (m_momentsValid)
+            {
+                m_cacheHits++;
+            }
+            else
+            {
+                m_cacheMisses++;
+                m_moments = MoleculeMoments(molecule);
+                m_momentsValid = true;
+            }
+
+            return m_moments;
+        }
+
+        void diagonalize(const Molecule &molecule, const Tensor tensor)
+        {
+            std::lock_guard<std::recursive_mutex> lock(m_cacheMutex);
+            validateCache(molecule);
+
+            if (m_eigenValid[tensor])
+            {
+                m_cacheHits++;
+                return;
+            }
+
+            m_cacheMisses++;
+
+            Eigen::Matrix3d matrix;
+            switch (tensor)
+            {
+            case kInertia:
+                matrix = moments(molecule).inertiaTensor();
+                break;
+            case kCharge:
+                matrix = moments(molecule).chargeTensor();
+                break;
+            case kCovariance:
+                matrix = moments(molecule).covarianceMatrix();
+                break;
+            }
+
+            Eigen::SelfAdjointEigenSolver<Eigen::Matrix3d> solver(matrix);
+
+            if (solver.info() != Eigen::Success)
+            {
+                switch (tensor)
+                {
+                case kInertia:
+                    throw std::runtime_error("The inertia tensor could not be diagonalized.\n");
+                case kCharge:
+                    throw std::runtime_error("The charge tensor could not be diagonalized.\n");
+                case kCovariance:
+                    throw std::runtime_error("The covariance matrix could not be diagonalized.\n");
+                }
+            }
+
+            m_eigenvalues[tensor] = solver.eigenvalues();
+            m_eigenvectors[tensor] = solver.eigenvectors();
+            m_eigenValid[tensor] = true;
         }
 
         MoleculeOrigin *m_origin;
@@ -60,11 +174,52 @@ namespace molconv
         std::array<double, 6> m_originalOriginBasis;
 
         groupPtr m_group;
-        std::vector<Eigen::Vector3d> m_intPos;
+        Eigen::Matrix3Xd m_intPos;
+
+        // the atomic positions in the global coordinate system (one column per
+        // atom) together with the atomic masses and nuclear charges. These are
+        // the authoritative coordinates, the chemkit atoms are only updated from
+        // them when needed (see Molecule::syncAtoms()).
+        Eigen::Matrix3Xd m_positions;
+        Eigen::VectorXd m_masses;
+        Eigen::VectorXd m_charges;
+        bool m_atomsStale;
+
+        // the number of atoms the store was last gathered for. It is read
+        // without a lock by positions(), the gathering itself is done under
+        // m_gatherMutex:
+        std::atomic<size_t> m_gatheredAtoms;
+        std::mutex m_gatherMutex;
+
+        // whether the bonds have been perceived from the current coordinates,
+        // and which bonds that added (the ones read from a file aren't listed):
+        bool m_bondsPerceived;
+        std::vector<BondPerceiver::AtomPair> m_perceivedBonds;
 
         MoleculeItem *m_listItem;
 
         unsigned long m_id;
+
+        // counter that is incremented whenever the coordinates change
+        unsigned long m_generation;
+
+        // counter that is incremented whenever the coordinates change other
+        // than by a rigid move of the internal basis
+        unsigned long m_shapeGeneration;
+
+        // cached properties, valid for generation m_cacheGeneration. They are
+        // filled under m_cacheMutex, so that several threads may read the same
+        // molecule at once (see the note in molecule.h):
+        std::recursive_mutex m_cacheMutex;
+        unsigned long m_cacheGeneration;
+        size_t m_cacheSize;
+        unsigned long m_cacheHits;
+        unsigned long m_cacheMisses;
+        bool m_momentsValid;
+        MoleculeMoments m_moments;
+        std::array<bool, 3> m_eigenValid;
+        std::array<Eigen::Vector3d, 3> m_eigenvalues;
+        std::array<Eigen::Matrix3d, 3> m_eigenvectors;
     };
 
     Molecule::Molecule()
@@ -77,9 +232,7 @@ namespace molconv
         : chemkit::Molecule(BaseMolecule)
         , d(new MoleculePrivate)
     {
-        chemkit::BondPredictor::predictBonds(this);
-
-        std::vector<bool> originBasisList(size(), true);
+        AtomMask originBasisList(size(), true);
         d->m_origin = new MoleculeOriginGeometricCenter(moleculePtr(this), originBasisList);
         d->m_basis = new MoleculeBasisCovarianceMatrix(moleculePtr(this), originBasisList);
 
@@ -90,9 +243,7 @@ namespace molconv
         : chemkit::Molecule(*BaseMolPtr)
         , d(new MoleculePrivate)
     {
-        chemkit::BondPredictor::predictBonds(this);
-
-        std::vector<bool> originBasisList(size(), true);
+        AtomMask originBasisList(size(), true);
         d->m_origin = new MoleculeOriginGeometricCenter(moleculePtr(this), originBasisList);
         d->m_basis = new MoleculeBasisCovarianceMatrix(moleculePtr(this), originBasisList);
 
@@ -107,6 +258,15 @@ namespace molconv
         d->m_basis = originalMolecule.basis();
         d->m_group = originalMolecule.group();
 
+        // the chemkit atoms were copied from the original molecule and
+        // are therefore just as up to date as its atoms are:
+        d->m_positions = originalMolecule.positions();
+        d->m_masses = originalMolecule.masses();
+        d->m_charges = originalMolecule.nuclearCharges();
+        d->m_atomsStale = originalMolecule.d->m_atomsStale;
+        d->m_bondsPerceived = originalMolecule.d->m_bondsPerceived;
+        d->m_perceivedBonds = originalMolecule.d->m_perceivedBonds;
+
         initIntPos();
     }
 
@@ -142,14 +302,16 @@ namespace molconv
         return d->m_basis ? d->m_basis->atoms() : std::array<int,3>();
     }
 
-    std::vector<bool> Molecule::originList() const
+    const AtomMask &Molecule::originList() const
     {
-        return d->m_origin ? d->m_origin->originList() : std::vector<bool>();
+        static const AtomMask noAtoms;
+        return d->m_origin ? d->m_origin->originList() : noAtoms;
     }
 
-    std::vector<bool> Molecule::basisList() const
+    const AtomMask &Molecule::basisList() const
     {
-        return d->m_basis ? d->m_basis->basisList() : std::vector<bool>();
+        static const AtomMask noAtoms;
+        return d->m_basis ? d->m_basis->basisList() : noAtoms;
     }
 
     double Molecule::originFactor() const
@@ -157,6 +319,11 @@ namespace molconv
         return d->m_origin ? d->m_origin->factor() : 0.0;
     }
 
+    Eigen::Quaterniond Molecule::orientation() const
+    {
+        return d->m_basis ? d->m_basis->orientation() : Eigen::Quaterniond::Identity();
+    }
+
     double Molecule::phi() const
     {
         return d->m_basis ? d->m_basis->phi() : 0.0;
@@ -177,192 +344,291 @@ namespace molconv
         return d->m_originalOriginBasis;
     }
 
-    std::vector<Eigen::Vector3d> Molecule::internalPositions() const
+    const Eigen::Matrix3Xd &Molecule::internalPositions() const
     {
         return d->m_intPos;
     }
 
-    Eigen::Vector3d Molecule::centerOfCharge() const
+    ///
+    /// \brief Molecule::positions
+    /// \return
+    ///
+    /// the atomic positions in the global coordinate system as a 3xN matrix.
+    /// If atoms have been added through the chemkit interface since the
+    /// positions were last gathered, the store is rebuilt from the atoms.
+    /// Atoms that were only moved through the chemkit interface are not
+    /// noticed, see updatePositions().
+    ///
+    const Eigen::Matrix3Xd &Molecule::positions() const
     {
-        Eigen::Vector3d coc = Eigen::Vector3d::Zero();
-        double totalCharge = 0.0;
-
-        for (int i = 0; i < int(size()); i++)
+        if (d->m_gatheredAtoms.load(std::memory_order_acquire) != size())
         {
-            coc += atom(i)->position() * double(atom(i)->atomicNumber());
-            totalCharge += double(atom(i)->atomicNumber());
+            std::lock_guard<std::mutex> lock(d->m_gatherMutex);
+
+            if (size_t(d->m_positions.cols()) != size())
+            {
+                syncAtoms();
+                gatherPositions();
+            }
+            else
+                d->m_gatheredAtoms.store(size(), std::memory_order_release);
         }
 
-        return coc / totalCharge;
+        return d->m_positions;
+    }
 
+    Eigen::Vector3d Molecule::atomPosition(const size_t index) const
+    {
+        return positions().col(index);
     }
 
-    Eigen::Matrix3d Molecule::inertiaTensor() const
+    const Eigen::VectorXd &Molecule::masses() const
     {
-        Eigen::Matrix3d inertiaTensor;
-        Eigen::Vector3d com = centerOfMass();
+        positions();
 
-        for (size_t alpha = 0; alpha < 3; alpha++)
-        {
-            for (size_t beta = 0; beta < 3; beta++)
-            {
-                inertiaTensor(alpha, beta) = 0.0;
+        return d->m_masses;
+    }
 
-                for (size_t atiter = 0; atiter < size(); atiter++)
-                {
-                    double factor = 0.0;
+    const Eigen::VectorXd &Molecule::nuclearCharges() const
+    {
+        positions();
 
-                    if (alpha == beta)
-                    {
-                        factor = (atom(atiter)->position() - com).squaredNorm();
-                    }
+        return d->m_charges;
+    }
 
-                    factor -= (atom(atiter)->position() - com)(alpha) * (atom(atiter)->position() - com)(beta);
+    ///
+    /// \brief Molecule::updatePositions
+    ///
+    /// rebuild the coordinate store from the chemkit atoms. This has to be
+    /// called after atoms have been moved through the chemkit interface.
+    ///
+    void Molecule::updatePositions()
+    {
+        d->m_atomsStale = false;
+        gatherPositions();
+    }
 
-                    inertiaTensor(alpha, beta) += atom(atiter)->mass() * factor;
+    ///
+    /// \brief Molecule::setPositions
+    /// \param newPositions
+    ///
+    /// replace all atomic positions at once, e.g. by the next frame of a
+    /// trajectory. The origin and the basis are determined anew from the new
+    /// geometry with their current settings, the connectivity is kept.
+    ///
+    void Molecule::setPositions(const Eigen::Matrix3Xd &newPositions)
+    {
+        if (size_t(newPositions.cols()) != size())
+            throw std::invalid_argument("the number of positions does not match the number of atoms.\n");
 
-                }
-            }
-        }
+        positions();
+        d->m_positions = newPositions;
+        d->m_atomsStale = true;
+        d->m_generation++;
 
-        return inertiaTensor;
+        if (d->m_origin)
+            d->m_origin->update();
+        if (d->m_basis)
+            d->m_basis->update();
+
+        initIntPos();
     }
 
-    Eigen::Matrix3d Molecule::chargeTensor() const
+    ///
+    /// \brief Molecule::syncAtoms
+    ///
+    /// copy the coordinates to the chemkit atoms, if they have changed since
+    /// the last synchronization. This is needed before the atoms are rendered,
+    /// copied or written by chemkit.
+    ///
+    void Molecule::syncAtoms() const
     {
-        Eigen::Matrix3d chargeTensor;
-        Eigen::Vector3d coc = centerOfCharge();
+        if (! d->m_atomsStale)
+            return;
+
+        size_t nAtoms = std::min(size(), size_t(d->m_positions.cols()));
 
-        for (size_t alpha = 0; alpha < 3; alpha++)
+        for (size_t i = 0; i < nAtoms; i++)
+            atom(i)->setPosition(d->m_positions.col(i));
+
+        d->m_atomsStale = false;
+    }
+
+    ///
+    /// \brief Molecule::perceiveBonds
+    ///
+    /// add the bonds between all atoms that are close enough to be bonded,
+    /// based on their covalent radii. The result only depends on the internal
+    /// geometry of the molecule, so it is kept until the coordinate store is
+    /// rebuilt from the atoms, but not redone for rigid-body moves.
+    ///
+    /// The bonds are not perceived when the molecule is created, since batch
+    /// jobs (alignment, RMSD, xyz export) never need them. Everything that does
+    /// (drawing the molecule, writing formats with connectivity) has to call
+    /// this first; calling it again is cheap.
+    ///
+    /// Bonds perceived from an earlier geometry are removed first, since the
+    /// atoms may have moved apart in the meantime. Bonds that were already
+    /// there when the bonds were perceived, e.g. from the file, are kept.
+    ///
+    void Molecule::perceiveBonds()
+    {
+        if (d->m_bondsPerceived)
+            return;
+
+        for (auto const& pair : d->m_perceivedBonds)
         {
-            for (size_t beta = 0; beta < 3; beta++)
-            {
-                chargeTensor(alpha, beta) = 0.0;
+            if (pair[1] >= size())
+                continue;
 
-                for (size_t atiter = 0; atiter < size(); atiter++)
-                {
-                    double factor = 0.0;
+            chemkit::Bond *staleBond = bond(atom(pair[0]), atom(pair[1]));
+            if (staleBond)
+                removeBond(staleBond);
+        }
+        d->m_perceivedBonds.clear();
 
-                    if (alpha == beta)
-                        factor = (atom(atiter)->position() - coc).squaredNorm();
+        const Eigen::Matrix3Xd &atomPositions = positions();
 
-                    factor -= (atom(atiter)->position() - coc)(alpha) * (atom(atiter)->position() - coc)(beta);
+        Eigen::VectorXd radii(size());
+        for (size_t i = 0; i < size(); i++)
+            radii(i) = atom(i)->element().covalentRadius();
 
-                    chargeTensor(alpha, beta) += double(atom(atiter)->atomicNumber()) * factor;
+        for (auto const& pair : BondPerceiver().perceive(atomPositions, radii))
+        {
+            chemkit::Atom *a = atom(pair[0]);
+            chemkit::Atom *b = atom(pair[1]);
 
-                }
+            if (! bond(a, b))
+            {
+                addBond(a, b);
+                d->m_perceivedBonds.push_back(pair);
             }
         }
 
-        return chargeTensor;
+        d->m_bondsPerceived = true;
     }
 
-    Eigen::Matrix3d Molecule::covarianceMatrix() const
+    bool Molecule::bondsPerceived() const
     {
-        Eigen::Matrix3d covarianceMatrix;
-        Eigen::Vector3d cog = center();
+        return d->m_bondsPerceived;
+    }
 
-        for (size_t alpha = 0; alpha < 3; alpha++)
-        {
-            for (size_t beta = 0; beta < 3; beta++)
-            {
-                covarianceMatrix(alpha, beta) = 0.0;
+    Eigen::Vector3d Molecule::center() const
+    {
+        return d->moments(*this).centerOfGeometry();
+    }
 
-                for (size_t atiter = 0; atiter < size(); atiter++)
-                {
-                    covarianceMatrix(alpha, beta) += (atom(atiter)->position()(alpha) - cog(alpha))
-                            * (atom(atiter)->position()(beta)  - cog(beta));
+    Eigen::Vector3d Molecule::centerOfMass() const
+    {
+        return d->moments(*this).centerOfMass();
+    }
 
-                }
-                covarianceMatrix(alpha, beta) /= double(size());
-            }
-        }
+    Eigen::Vector3d Molecule::centerOfCharge() const
+    {
+        return d->moments(*this).centerOfCharge();
+    }
 
-        return covarianceMatrix;
+    ///
+    /// \brief Molecule::inertiaTensor
+    /// \return
+    ///
+    /// the inertia tensor w.r.t. the center of mass. This and the charge
+    /// tensor and the covariance matrix below are all derived from the
+    /// moments of the atomic positions, which are gathered in a single pass
+    /// and cached until the coordinates change.
+    ///
+    Eigen::Matrix3d Molecule::inertiaTensor() const
+    {
+        return d->moments(*this).inertiaTensor();
+    }
+
+    Eigen::Matrix3d Molecule::chargeTensor() const
+    {
+        return d->moments(*this).chargeTensor();
+    }
+
+    Eigen::Matrix3d Molecule::covarianceMatrix() const
+    {
+        return d->moments(*this).covarianceMatrix();
     }
 
     Eigen::Vector3d Molecule::inertiaEigenvalues() const
     {
-        Eigen::SelfAdjointEigenSolver<Eigen::Matrix3d> solver(inertiaTensor());
+        d->diagonalize(*this, MoleculePrivate::kInertia);
 
-        if (solver.info() != Eigen::Success)
-        {
-            throw std::runtime_error("The inertia tensor could not be diagonalized.\n");
-        }
-        else
-        {
-            return solver.eigenvalues();
-        }
+        return d->m_eigenvalues[MoleculePrivate::kInertia];
     }
 
     Eigen::Vector3d Molecule::chargeEigenvalues() const
     {
-        Eigen::SelfAdjointEigenSolver<Eigen::Matrix3d> solver(chargeTensor());
+        d->diagonalize(*this, MoleculePrivate::kCharge);
 
-        if (solver.info() != Eigen::Success)
-        {
-            throw std::runtime_error("The charge tensor could not be diagonalized.\n");
-        }
-        else
-        {
-            return solver.eigenvalues();
-        }
+        return d->m_eigenvalues[MoleculePrivate::kCharge];
     }
 
     Eigen::Vector3d Molecule::covarianceEigenvalues() const
     {
-        Eigen::SelfAdjointEigenSolver<Eigen::Matrix3d> solver(covarianceMatrix());
+        d->diagonalize(*this, MoleculePrivate::kCovariance);
 
-        if (solver.info() != Eigen::Success)
-        {
-            throw std::runtime_error("The covariance matrix could not be diagonalized.\n");
-        }
-        else
-        {
-            return solver.eigenvalues();
-        }
+        return d->m_eigenvalues[MoleculePrivate::kCovariance];
     }
 
     Eigen::Matrix3d Molecule::inertiaEigenvectors() const
     {
-        Eigen::SelfAdjointEigenSolver<Eigen::Matrix3d> solver(inertiaTensor());
+        d->diagonalize(*this, MoleculePrivate::kInertia);
 
-        if (solver.info() != Eigen::Success)
-        {
-            throw std::runtime_error("The inertia tensor could not be diagonalized.\n");
-        }
-        else
-        {
-            return solver.eigenvectors();
-        }
+        return d->m_eigenvectors[MoleculePrivate::kInertia];
     }
 
     Eigen::Matrix3d Molecule::chargeEigenvectors() const
     {
-        Eigen::SelfAdjointEigenSolver<Eigen::Matrix3d> solver(chargeTensor());
+        d->diagonalize(*this, MoleculePrivate::kCharge);
 
-        if (solver.info() != Eigen::Success)
-        {
-            throw std::runtime_error("The charge tensor could not be diagonalized.\n");
-        }
-        else
-        {
-            return solver.eigenvectors();
-        }
+        return d->m_eigenvectors[MoleculePrivate::kCharge];
     }
 
     Eigen::Matrix3d Molecule::covarianceEigenvectors() const
     {
-        Eigen::SelfAdjointEigenSolver<Eigen::Matrix3d> solver(covarianceMatrix());
+        d->diagonalize(*this, MoleculePrivate::kCovariance);
 
-        if (solver.info() != Eigen::Success)
-        {
-            throw std::runtime_error("The covariance matrix could not be diagonalized.\n");
-        }
-        else
-        {
-            return solver.eigenvectors();
-        }
+        return d->m_eigenvectors[MoleculePrivate::kCovariance];
+    }
+
+    ///
+    /// \brief Molecule::coordinateGeneration
+    /// \return
+    ///
+    /// a counter that is incremented whenever the atomic coordinates or the
+    /// internal basis of the molecule change
+    ///
+    unsigned long Molecule::coordinateGeneration() const
+    {
+        return d->m_generation;
+    }
+
+    ///
+    /// \brief Molecule::shapeGeneration
+    /// \return
+    ///
+    /// a counter that is incremented whenever the internal positions of the atoms
+    /// change, i.e. on all changes of the coordinates except rigid moves with
+    /// moveFromParas or moveTo
+    ///
+    unsigned long Molecule::shapeGeneration() const
+    {
+        return d->m_shapeGeneration;
+    }
+
+    unsigned long Molecule::cacheHits() const
+    {
+        std::lock_guard<std::recursive_mutex> lock(d->m_cacheMutex);
+        return d->m_cacheHits;
+    }
+
+    unsigned long Molecule::cacheMisses() const
+    {
+        std::lock_guard<std::recursive_mutex> lock(d->m_cacheMutex);
+        return d->m_cacheMisses;
     }
 
     ///
@@ -383,24 +649,135 @@ namespace molconv
         Eigen::Vector3d pos(x, y, z);
 
         d->m_origin->setPosition(pos);
-        d->m_basis->setPsi(psi);
-        d->m_basis->setTheta(theta);
-        d->m_basis->setPhi(phi);
+        d->m_basis->setEulerAngles(psi, theta, phi);
+
+        transformPositions(pos, d->m_basis->axes());
+    }
+
+    ///
+    /// \brief Molecule::moveTo
+    /// \param position
+    /// \param rotation
+    ///
+    /// place the origin of the molecule at \p position and orient its internal
+    /// basis according to the rotation matrix \p rotation. This is the same as
+    /// moveFromParas, but skips the conversion from euler angles to the matrix.
+    /// Throws if \p rotation is not a proper rotation.
+    ///
+    void Molecule::moveTo(const Eigen::Vector3d &position, const Eigen::Matrix3d &rotation)
+    {
+        if (!isRotation(rotation))
+            throw std::invalid_argument("the matrix is not a proper rotation.\n");
+
+        moveTo(position, Eigen::Quaterniond(rotation));
+    }
+
+    ///
+    /// \brief Molecule::isRotation
+    /// \param matrix
+    /// \return
+    ///
+    /// whether \p matrix is orthonormal with a determinant of +1 (within a
+    /// tolerance for rounding errors), i.e. neither a reflection nor scaled
+    ///
+    bool Molecule::isRotation(const Eigen::Matrix3d &matrix)
+    {
+        const double tolerance = 1.0e-6;
+
+        return (matrix.transpose() * matrix - Eigen::Matrix3d::Identity()).cwiseAbs().maxCoeff() < tolerance
+                && std::abs(matrix.determinant() - 1.0) < tolerance;
+    }
+
+    ///
+    /// \brief Molecule::moveTo
+    /// \param position
+    /// \param orientation
+    ///
+    /// place the origin of the molecule at \p position and orient its internal
+    /// basis according to the unit quaternion \p orientation
+    ///
+    void Molecule::moveTo(const Eigen::Vector3d &position, const Eigen::Quaterniond &orientation)
+    {
+        d->m_origin->setPosition(position);
+        d->m_basis->setOrientation(orientation);
+
+        transformPositions(position, d->m_basis->axes());
+    }
+
+    ///
+    /// \brief Molecule::isValidOrigin
+    /// \param code
+    /// \param nAtoms
+    /// \param originVector
+    /// \param atom1
+    /// \param atom2
+    /// \return
+    ///
+    /// whether the origin \p code is implemented and can be determined for a
+    /// molecule of \p nAtoms atoms: the atoms it is placed on have to exist, and
+    /// the centers need a list of the molecule's size selecting at least one atom.
+    ///
+    bool Molecule::isValidOrigin(const OriginCode code, const size_t nAtoms, const AtomMask &originVector, const size_t atom1, const size_t atom2)
+    {
+        switch (code)
+        {
+        case kCenterOfMass:
+        case kCenterOfGeometry:
+            return originVector.size() == nAtoms && !originVector.none();
+        case kCenterOnAtom:
+            return atom1 < nAtoms;
+        case kCenterBetweenAtoms:
+            return atom1 < nAtoms && atom2 < nAtoms;
+        case kCenterOfCharge:
+            break;
+        }
 
-        Eigen::Matrix3d rot = d->m_basis->axes();
+        return false;
+    }
+
+    ///
+    /// \brief Molecule::isValidBasis
+    /// \param code
+    /// \param nAtoms
+    /// \param basisVector
+    /// \param atom1
+    /// \param atom2
+    /// \param atom3
+    /// \return
+    ///
+    /// whether the basis \p code is implemented and can be determined for a
+    /// molecule of \p nAtoms atoms, see isValidOrigin()
+    ///
+    bool Molecule::isValidBasis(const BasisCode code, const size_t nAtoms, const AtomMask &basisVector, const size_t atom1, const size_t atom2, const size_t atom3)
+    {
+        switch (code)
+        {
+        case kCovarianceVectors:
+        case kInertiaVectors:
+            return basisVector.size() == nAtoms && !basisVector.none();
+        case kVectorsFromAtoms:
+            return atom1 < nAtoms && atom2 < nAtoms && atom3 < nAtoms;
+        case kChargeVectors:
+        case kStandardOrientation:
+            break;
+        }
 
-        for (int i = 0; i < int(size()); i++)
-            atom(i)->setPosition(pos + rot * d->m_intPos.at(i));
+        return false;
     }
 
     ///
     /// \brief Molecule::setOrigin
     /// \param newOrigin
     ///
-    /// set the molecule's internal origin to \p newOrigin.
+    /// set the molecule's internal origin to \p newOrigin. Throws if the
+    /// origin isn't valid for this molecule (see isValidOrigin()), in which
+    /// case the current origin is kept.
     ///
-    void Molecule::setOrigin(const OriginCode &newOrigin, const std::vector<bool> originVector, const size_t atom1, const size_t atom2, const double originFactor)
+    void Molecule::setOrigin(const OriginCode &newOrigin, const AtomMask &originVector, const size_t atom1, const size_t atom2, const double originFactor)
     {
+        if (!isValidOrigin(newOrigin, size(), originVector, atom1, atom2))
+            throw std::invalid_argument("the origin is not implemented or refers to atoms the molecule does not have.\n");
+
         switch (newOrigin)
         {
         case kCenterOfMass:
@@ -419,6 +796,7 @@ namespace molconv
             break;
         }
 
+        d->m_generation++;
         initIntPos();
     }
 
@@ -426,10 +804,15 @@ namespace molconv
     /// \brief Molecule::setBasis
     /// \param newBasis
     ///
-    /// set the molecule's internal coordinate system to \p newBasis.
+    /// set the molecule's internal coordinate system to \p newBasis. Throws
+    /// if the basis isn't valid for this molecule (see isValidBasis()), in
+    /// which case the current basis is kept.
     ///
-    void Molecule::setBasis(const BasisCode &newBasis, const std::vector<bool> basisVector, const size_t atom1, const size_t atom2, const size_t atom3)
+    void Molecule::setBasis(const BasisCode &newBasis, const AtomMask &basisVector, const size_t atom1, const size_t atom2, const size_t atom3)
     {
+        if (!isValidBasis(newBasis, size(), basisVector, atom1, atom2, atom3))
+            throw std::invalid_argument("the basis is not implemented or refers to atoms the molecule does not have.\n");
+
         switch (newBasis)
         {
         case kCovarianceVectors:
@@ -446,6 +829,8 @@ namespace molconv
             d->m_basis = new MoleculeBasisOnAtoms(moleculePtr(this), atom1, atom2, atom3);
             break;
         }
+
+        d->m_generation++;
         initIntPos();
     }
 
@@ -479,9 +864,6 @@ namespace molconv
     ///
     void Molecule::initIntPos()
     {
-        // remove any internal coordinates that might already exist:
-        d->m_intPos.clear();
-
         // determine the internal atomic positions:
         Eigen::Vector3d shiftVec = Eigen::Vector3d::Zero();
         if (origin())
@@ -502,10 +884,53 @@ namespace molconv
         d->m_originalOriginBasis[4] = theta();
         d->m_originalOriginBasis[5] = psi();
 
-        for (int i = 0; i < int(size()); i++)
+        d->m_intPos.noalias() = rotMat.transpose() * (positions().colwise() - shiftVec);
+        d->m_shapeGeneration++;
+    }
+
+    ///
+    /// \brief Molecule::transformPositions
+    /// \param position
+    /// \param rotation
+    ///
+    /// write the internal positions, rotated by \p rotation and shifted by
+    /// \p position, into the coordinate store
+    ///
+    void Molecule::transformPositions(const Eigen::Vector3d &position, const Eigen::Matrix3d &rotation)
+    {
+        // transform all atoms at once: the 3x3 product is evaluated coefficient-wise
+        // and fused with the translation, so the store is written in a single pass
+        positions();
+        d->m_positions.noalias() = rotation.lazyProduct(d->m_intPos).colwise() + position;
+
+        d->m_atomsStale = true;
+        d->m_generation++;
+    }
+
+    ///
+    /// \brief Molecule::gatherPositions
+    ///
+    /// copy the positions, masses and nuclear charges of the chemkit atoms
+    /// into the contiguous coordinate store
+    ///
+    void Molecule::gatherPositions() const
+    {
+        d->m_positions.resize(3, size());
+        d->m_masses.resize(size());
+        d->m_charges.resize(size());
+
+        for (size_t i = 0; i < size(); i++)
         {
-            d->m_intPos.push_back(rotMat.transpose() * (atom(i)->position() - shiftVec));
+            d->m_positions.col(i) = atom(i)->position();
+            d->m_masses(i) = atom(i)->mass();
+            d->m_charges(i) = double(atom(i)->atomicNumber());
         }
+
+        d->m_atomsStale = false;
+        d->m_bondsPerceived = false;
+        d->m_generation++;
+        d->m_shapeGeneration++;
+        d->m_gatheredAtoms.store(size(), std::memory_order_release);
     }
 
     unsigned long Molecule::molId() const
@@ -513,9 +938,9 @@ namespace molconv
         return d->m_id;
     }
 
-    void Molecule::initRand()
+    void Molecule::setMolId(const unsigned long id)
     {
-        std::srand(std::time(0));
+        d->m_id = id;
     }
 
 } // namespace molconv
@@ -28,7 +28,9 @@
     #include<boost/scoped_ptr.hpp>
 #endif
 #include<Eigen/Core>
+#include<Eigen/Geometry>
 #include "types.h"
+#include "atommask.h"
 
 class MoleculeItem;
 
@@ -40,6 +42,21 @@ namespace molconv
     class MoleculeOrigin;
     class MoleculeBasis;
 
+    ///
+    /// \brief The Molecule class
+    ///
+    /// The coordinate store and the tensor properties (centers, tensors and
+    /// their eigensystems) are filled on first use. Filling them is serialized
+    /// internally, so any number of threads may call the const accessors of the
+    /// same molecule at once, as long as no thread modifies the molecule at the
+    /// same time.
+    ///
+    /// The coordinate store, not the chemkit atoms, holds the authoritative
+    /// positions. Atoms that are added through the chemkit interface are picked
+    /// up automatically, but after moving atoms through the chemkit interface
+    /// (chemkit::Atom::setPosition() and the like) updatePositions() must be
+    /// called, otherwise positions() and all properties derived from it are stale.
+    ///
     class Molecule : public chemkit::Molecule
     {
     public:
@@ -57,15 +74,31 @@ namespace molconv
         Eigen::Matrix3d basisVectors() const;
         std::array<int,2> originAtoms() const;
         std::array<int,3> basisAtoms() const;
-        std::vector<bool> originList() const;
-        std::vector<bool> basisList() const;
+        const AtomMask &originList() const;
+        const AtomMask &basisList() const;
         double originFactor() const;
+        Eigen::Quaterniond orientation() const;
         double phi() const;
         double theta() const;
         double psi() const;
         std::array<double,6> originalBasis() const;
-        std::vector<Eigen::Vector3d> internalPositions() const;
-
+        const Eigen::Matrix3Xd &internalPositions() const;
+
+        // the contiguous coordinate store:
+        const Eigen::Matrix3Xd &positions() const;
+        Eigen::Vector3d atomPosition(const size_t index) const;
+        const Eigen::VectorXd &masses() const;
+        const Eigen::VectorXd &nuclearCharges() const;
+        void updatePositions();
+        void setPositions(const Eigen::Matrix3Xd &newPositions);
+        void syncAtoms() const;
+
+        // bonds from the covalent radii, perceived once per geometry:
+        void perceiveBonds();
+        bool bondsPerceived() const;
+
+        Eigen::Vector3d center() const;
+        Eigen::Vector3d centerOfMass() const;
         Eigen::Vector3d centerOfCharge() const;
 
         // info about the inertia tensor and the covariance matrix:
@@ -79,23 +112,37 @@ namespace molconv
         Eigen::Matrix3d chargeEigenvectors() const;
         Eigen::Matrix3d covarianceEigenvectors() const;
 
+        // statistics of the cache for the properties above:
+        unsigned long coordinateGeneration() const;
+        unsigned long shapeGeneration() const;
+        unsigned long cacheHits() const;
+        unsigned long cacheMisses() const;
+
         void moveFromParas(const double x, const double y, const double z,
                            const double phi, const double theta, const double psi);
+        void moveTo(const Eigen::Vector3d &position, const Eigen::Matrix3d &rotation);
+        void moveTo(const Eigen::Vector3d &position, const Eigen::Quaterniond &orientation);
+        static bool isRotation(const Eigen::Matrix3d &matrix);
 
         // changing the internal basis:
-        void setOrigin(const OriginCode &newOrigin, const std::vector<bool> originVector, const size_t atom1 = 0, const size_t atom2 = 0, const double originFactor = 0.0);
-        void setBasis(const BasisCode &newBasis, const std::vector<bool> basisVector, const size_t atom1 = 0, const size_t atom2 = 0, const size_t atom3 = 0);
+        static bool isValidOrigin(const OriginCode code, const size_t nAtoms, const AtomMask &originVector, const size_t atom1 = 0, const size_t atom2 = 0);
+        static bool isValidBasis(const BasisCode code, const size_t nAtoms, const AtomMask &basisVector, const size_t atom1 = 0, const size_t atom2 = 0, const size_t atom3 = 0);
+        void setOrigin(const OriginCode &newOrigin, const AtomMask &originVector, const size_t atom1 = 0, const size_t atom2 = 0, const double originFactor = 0.0);
+        void setBasis(const BasisCode &newBasis, const AtomMask &basisVector, const size_t atom1 = 0, const size_t atom2 = 0, const size_t atom3 = 0);
 
         // manage groups
         void addToGroup(groupPtr newGroup);
         groupPtr group() const;
 
-        static void initRand();
-
         unsigned long molId() const;
 
     private:
+        friend class System;
+        void setMolId(const unsigned long id);
+
         void initIntPos();
+        void gatherPositions() const;
+        void transformPositions(const Eigen::Vector3d &position, const Eigen::Matrix3d &rotation);
 
         boost::scoped_ptr<MoleculePrivate> d;
     };
@@ -24,16 +24,29 @@
 namespace molconv {
 
 MoleculeBasis::MoleculeBasis()
+    : m_orientation(Eigen::Quaterniond::Identity())
+    , m_axes(Eigen::Matrix3d::Identity())
+    , m_eulerValid(false)
 {
 }
 
 MoleculeBasis::MoleculeBasis(moleculePtr molecule)
+    : m_orientation(Eigen::Quaterniond::Identity())
+    , m_axes(Eigen::Matrix3d::Identity())
+    , m_eulerValid(false)
 {
     m_molecule = molecule;
+}
 
-    m_psi = 0.0;
-    m_theta = 0.0;
-    m_phi = 0.0;
+MoleculeBasis::MoleculeBasis(const MoleculeBasis &basis)
+    : m_molecule(basis.m_molecule)
+    , m_orientation(basis.m_orientation)
+    , m_axes(basis.m_axes)
+    , m_eulerValid(false)
+{
+    std::lock_guard<std::mutex> lock(basis.m_eulerMutex);
+    m_euler = basis.m_euler;
+    m_eulerValid = basis.m_eulerValid.load();
 }
 
 moleculePtr MoleculeBasis::molecule() const
@@ -41,39 +54,67 @@ moleculePtr MoleculeBasis::molecule() const
     return m_molecule;
 }
 
-Eigen::Matrix3d MoleculeBasis::axes() const
+const Eigen::Matrix3d &MoleculeBasis::axes() const
+{
+    return m_axes;
+}
+
+Eigen::Quaterniond MoleculeBasis::orientation() const
 {
-    return euler2rot(m_psi, m_theta, m_phi);
+    return Eigen::Quaterniond(m_orientation);
+}
+
+/*
+ * Set the orientation from a quaternion. The quaternion is normalized
+ * and the rotation matrix is rebuilt from it without any trigonometry.
+ */
+void MoleculeBasis::setOrientation(const Eigen::Quaterniond &newOrientation)
+{
+    m_orientation = newOrientation.normalized();
+    m_axes = m_orientation.toRotationMatrix();
+    m_eulerValid = false;
 }
 
 double MoleculeBasis::phi() const
 {
-    return m_phi;
+    updateEulerAngles();
+    return m_euler[2];
 }
 
 double MoleculeBasis::theta() const
 {
-    return m_theta;
+    updateEulerAngles();
+    return m_euler[1];
 }
 
 double MoleculeBasis::psi() const
 {
-    return m_psi;
+    updateEulerAngles();
+    return m_euler[0];
 }
 
-void MoleculeBasis::setPhi(const double newPhi)
+void MoleculeBasis::setEulerAngles(const double newPsi, const double newTheta, const double newPhi)
 {
-    m_phi = newPhi;
-}
+    setOrientation(Eigen::Quaterniond(euler2rot(newPsi, newTheta, newPhi)));
 
-void MoleculeBasis::setTheta(const double newTheta)
-{
-    m_theta = newTheta;
+    // keep the angles as given instead of deriving them again:
+    m_euler[0] = newPsi;
+    m_euler[1] = newTheta;
+    m_euler[2] = newPhi;
+    m_eulerValid = true;
 }
 
-void MoleculeBasis::setPsi(const double newPsi)
+void MoleculeBasis::updateEulerAngles() const
 {
-    m_psi = newPsi;
+    if (m_eulerValid.load(std::memory_order_acquire))
+        return;
+
+    std::lock_guard<std::mutex> lock(m_eulerMutex);
+    if (m_eulerValid.load(std::memory_order_relaxed))
+        return;
+
+    m_euler = rot2euler(m_axes);
+    m_eulerValid.store(true, std::memory_order_release);
 }
 
 /*
@@ -142,7 +183,7 @@ Eigen::Matrix3d MoleculeBasis::euler2rot(const double psi, const double theta, c
     return rot;
 }
 
-void MoleculeBasis::setEulerAngles(Eigen::Matrix3d rot)
+void MoleculeBasis::setAxes(Eigen::Matrix3d rot)
 {
     // if the determinant of the internal basis is -1, invert the
     // sign of the middle basis vector to make the basis right-handed
@@ -151,11 +192,7 @@ void MoleculeBasis::setEulerAngles(Eigen::Matrix3d rot)
         rot.col(1) *= -1.0;
     }
 
-    std::array<double,3> eulers = rot2euler(rot);
-    m_psi = eulers[0];
-    m_theta = eulers[1];
-    m_phi = eulers[2];
+    setOrientation(Eigen::Quaterniond(rot));
 }
 
 }
-
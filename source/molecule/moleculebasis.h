@@ -22,48 +22,71 @@
 #ifndef MOLECULEBASIS_H
 #define MOLECULEBASIS_H
 
+#include <array>
+#include <atomic>
+#include <mutex>
 #include <Eigen/Core>
+#include <Eigen/Geometry>
 #include "types.h"
+#include "atommask.h"
 #include "molecule.h"
 
 namespace molconv {
 
+///
+/// \brief The MoleculeBasis class
+///
+/// the orientation of the internal basis of a molecule. It is stored as a
+/// unit quaternion together with the corresponding rotation matrix, the
+/// euler angles are only derived on demand for display and file output.
+///
 class MoleculeBasis
 {
 public:
     MoleculeBasis();
     MoleculeBasis(moleculePtr molecule);
+    MoleculeBasis(const MoleculeBasis &basis);
     virtual ~MoleculeBasis() {}
     virtual MoleculeBasis *clone() = 0;
 
     moleculePtr molecule() const;
 
-    // return the axes of the internal basis (aka the
-    // rotation matrix) as obtained from the euler angles
-    Eigen::Matrix3d axes() const;
+    // return the axes of the internal basis (aka the rotation matrix)
+    const Eigen::Matrix3d &axes() const;
+    Eigen::Quaterniond orientation() const;
+    void setOrientation(const Eigen::Quaterniond &newOrientation);
 
     double phi() const;
     double theta() const;
     double psi() const;
-    void setPhi(const double newPhi);
-    void setTheta(const double newTheta);
-    void setPsi(const double newPsi);
+    void setEulerAngles(const double newPsi, const double newTheta, const double newPhi);
 
     static std::array<double,3> rot2euler(Eigen::Matrix3d rot);
     static Eigen::Matrix3d euler2rot(const double psi, const double theta, const double phi);
 
-    virtual std::vector<bool> basisList() const = 0;
+    virtual const AtomMask &basisList() const = 0;
     virtual std::array<int,3> atoms() const = 0;
     virtual BasisCode code() const = 0;
 
+    // determine the axes anew from the current geometry of the molecule:
+    virtual void update() = 0;
+
 protected:
-    void setEulerAngles(Eigen::Matrix3d rot);
+    void setAxes(Eigen::Matrix3d rot);
 
     moleculePtr m_molecule;
 
-    double m_phi;
-    double m_theta;
-    double m_psi;
+    Eigen::Quaternion<double,Eigen::DontAlign> m_orientation;
+    Eigen::Matrix3d m_axes;
+
+private:
+    void updateEulerAngles() const;
+
+    // the euler angles are derived on the first call of a const accessor,
+    // which may come from several threads at once:
+    mutable std::atomic<bool> m_eulerValid;
+    mutable std::array<double,3> m_euler;
+    mutable std::mutex m_eulerMutex;
 };
 
 }
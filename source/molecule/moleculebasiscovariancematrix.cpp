@@ -21,37 +21,20 @@
 
 #include <Eigen/Eigenvalues>
 #include "moleculebasiscovariancematrix.h"
+#include "moleculemoments.h"
 
 namespace molconv {
 
-MoleculeBasisCovarianceMatrix::MoleculeBasisCovarianceMatrix(moleculePtr molecule, std::vector<bool> basisList)
+MoleculeBasisCovarianceMatrix::MoleculeBasisCovarianceMatrix(moleculePtr molecule, const AtomMask &basisList)
     : MoleculeBasisGlobal(molecule, basisList)
 {
-    Eigen::Matrix3d covarianceMatrix = calcCovarianceMatrix();
-
-    Eigen::SelfAdjointEigenSolver<Eigen::Matrix3d> solver(covarianceMatrix);
-    if (solver.info() != Eigen::Success)
-    {
-        throw std::runtime_error("The covariance matrix could not be diagonalized.\n");
-    }
-
-    // rearrange the basis vectors to align the z-axis with the vector of lowest variance
-    // (x and z axes are interchanged)
-    Eigen::Matrix3d rot;
-    rot.col(0) = solver.eigenvectors().col(2);
-    rot.col(1) = solver.eigenvectors().col(1);
-    rot.col(2) = solver.eigenvectors().col(0);
-
-    setEulerAngles(rot);
+    update();
 }
 
 MoleculeBasisCovarianceMatrix::MoleculeBasisCovarianceMatrix(const MoleculeBasisCovarianceMatrix &basis)
     : MoleculeBasisGlobal(basis)
 {
     m_molecule = basis.molecule();
-    m_phi = basis.phi();
-    m_theta = basis.theta();
-    m_psi = basis.psi();
     m_basisList = basis.basisList();
 }
 
@@ -65,37 +48,31 @@ BasisCode MoleculeBasisCovarianceMatrix::code() const
     return kCovarianceVectors;
 }
 
-Eigen::Matrix3d MoleculeBasisCovarianceMatrix::calcCovarianceMatrix()
+void MoleculeBasisCovarianceMatrix::update()
 {
-    Eigen::Matrix3d covarianceMatrix = Eigen::Matrix3d::Zero();
-    Eigen::Vector3d center = m_molecule->center();
+    Eigen::Matrix3d covarianceMatrix = calcCovarianceMatrix();
 
-    int nActive = 0;
-    for (int i = 0; i < int(m_molecule->size()); i++)
+    Eigen::SelfAdjointEigenSolver<Eigen::Matrix3d> solver(covarianceMatrix);
+    if (solver.info() != Eigen::Success)
     {
-        if (m_basisList.at(i))
-        {
-            nActive++;
-        }
+        throw std::runtime_error("The covariance matrix could not be diagonalized.\n");
     }
 
-    for (int a = 0; a < 3; a++)
-    {
-        for (int b = 0; b < 3; b++)
-        {
-            for (int i = 0; i < int(m_molecule->size()); i++)
-            {
-                if (m_basisList.at(i))
-                {
-                    covarianceMatrix(a, b) += (m_molecule->atom(i)->position()(a) - center(a))
-                                            * (m_molecule->atom(i)->position()(b) - center(b));
-                }
-            }
-            covarianceMatrix(a, b) /= double(nActive);
-        }
-    }
+    // rearrange the basis vectors to align the z-axis with the vector of lowest variance
+    // (x and z axes are interchanged)
+    Eigen::Matrix3d rot;
+    rot.col(0) = solver.eigenvectors().col(2);
+    rot.col(1) = solver.eigenvectors().col(1);
+    rot.col(2) = solver.eigenvectors().col(0);
+
+    setAxes(rot);
+}
+
+Eigen::Matrix3d MoleculeBasisCovarianceMatrix::calcCovarianceMatrix()
+{
+    MoleculeMoments moments(*m_molecule, m_basisList);
 
-    return covarianceMatrix;
+    return moments.covarianceMatrix(m_molecule->center());
 }
 
 }
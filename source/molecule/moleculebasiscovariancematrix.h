@@ -29,12 +29,13 @@ namespace molconv {
 class MoleculeBasisCovarianceMatrix : public MoleculeBasisGlobal
 {
 public:
-    MoleculeBasisCovarianceMatrix(moleculePtr molecule, std::vector<bool> basisList);
+    MoleculeBasisCovarianceMatrix(moleculePtr molecule, const AtomMask &basisList);
     MoleculeBasisCovarianceMatrix(const MoleculeBasisCovarianceMatrix &basis);
     ~MoleculeBasisCovarianceMatrix() {}
     MoleculeBasis *clone();
 
     BasisCode code() const;
+    void update();
 
 private:
     Eigen::Matrix3d calcCovarianceMatrix();
@@ -27,13 +27,13 @@ MoleculeBasisGlobal::MoleculeBasisGlobal()
 {
 }
 
-MoleculeBasisGlobal::MoleculeBasisGlobal(moleculePtr molecule, std::vector<bool> basisList)
+MoleculeBasisGlobal::MoleculeBasisGlobal(moleculePtr molecule, const AtomMask &basisList)
     : MoleculeBasis(molecule)
 {
     m_basisList = basisList;
 }
 
-std::vector<bool> MoleculeBasisGlobal::basisList() const
+const AtomMask &MoleculeBasisGlobal::basisList() const
 {
     return m_basisList;
 }
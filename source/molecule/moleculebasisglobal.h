@@ -30,13 +30,13 @@ class MoleculeBasisGlobal : public MoleculeBasis
 {
 public:
     MoleculeBasisGlobal();
-    MoleculeBasisGlobal(moleculePtr molecule, std::vector<bool> basisList);
+    MoleculeBasisGlobal(moleculePtr molecule, const AtomMask &basisList);
 
-    std::vector<bool> basisList() const;
+    const AtomMask &basisList() const;
     std::array<int,3> atoms() const;
 
 protected:
-    std::vector<bool> m_basisList;
+    AtomMask m_basisList;
 };
 
 }
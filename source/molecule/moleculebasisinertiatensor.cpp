@@ -21,30 +21,20 @@
 
 #include <Eigen/Eigenvalues>
 #include "moleculebasisinertiatensor.h"
+#include "moleculemoments.h"
 
 namespace molconv {
 
-MoleculeBasisInertiaTensor::MoleculeBasisInertiaTensor(moleculePtr molecule, std::vector<bool> basisList)
+MoleculeBasisInertiaTensor::MoleculeBasisInertiaTensor(moleculePtr molecule, const AtomMask &basisList)
     : MoleculeBasisGlobal(molecule, basisList)
 {
-    Eigen::Matrix3d inertiaTensor = calcInertiaTensor();
-
-    Eigen::SelfAdjointEigenSolver<Eigen::Matrix3d> solver(inertiaTensor);
-    if (solver.info() != Eigen::Success)
-    {
-        throw std::runtime_error("The inertia tensor could not be diagonalized.\n");
-    }
-
-    setEulerAngles(solver.eigenvectors());
+    update();
 }
 
 MoleculeBasisInertiaTensor::MoleculeBasisInertiaTensor(const MoleculeBasisInertiaTensor &basis)
     : MoleculeBasisGlobal(basis)
 {
     m_molecule = basis.molecule();
-    m_phi = basis.phi();
-    m_theta = basis.theta();
-    m_psi = basis.psi();
     m_basisList = basis.basisList();
 }
 
@@ -58,35 +48,24 @@ BasisCode MoleculeBasisInertiaTensor::code() const
     return kInertiaVectors;
 }
 
-Eigen::Matrix3d MoleculeBasisInertiaTensor::calcInertiaTensor()
+void MoleculeBasisInertiaTensor::update()
 {
-    Eigen::Matrix3d inertiaTensor = Eigen::Matrix3d::Zero();
-    Eigen::Vector3d com = m_molecule->centerOfMass();
+    Eigen::Matrix3d inertiaTensor = calcInertiaTensor();
 
-    for (int a = 0; a < 3; a++)
+    Eigen::SelfAdjointEigenSolver<Eigen::Matrix3d> solver(inertiaTensor);
+    if (solver.info() != Eigen::Success)
     {
-        for (int b = 0; b < 3; b++)
-        {
-            for (int i = 0; i < int(m_molecule->size()); i++)
-            {
-                if (m_basisList.at(i))
-                {
-                    Eigen::Vector3d distance = m_molecule->atom(i)->position() - com;
+        throw std::runtime_error("The inertia tensor could not be diagonalized.\n");
+    }
 
-                    double factor = 0.0;
-                    if (a == b)
-                    {
-                        factor = distance.squaredNorm();
-                    }
-                    factor -= distance(a) * distance(b);
+    setAxes(solver.eigenvectors());
+}
 
-                    inertiaTensor(a, b) += m_molecule->atom(i)->mass() * factor;
-                }
-            }
-        }
-    }
+Eigen::Matrix3d MoleculeBasisInertiaTensor::calcInertiaTensor()
+{
+    MoleculeMoments moments(*m_molecule, m_basisList);
 
-    return inertiaTensor;
+    return moments.inertiaTensor(m_molecule->centerOfMass());
 }
 
 }
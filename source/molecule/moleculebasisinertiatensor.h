@@ -29,12 +29,13 @@ namespace molconv {
 class MoleculeBasisInertiaTensor : public MoleculeBasisGlobal
 {
 public:
-    MoleculeBasisInertiaTensor(moleculePtr molecule, std::vector<bool> basisList);
+    MoleculeBasisInertiaTensor(moleculePtr molecule, const AtomMask &basisList);
     MoleculeBasisInertiaTensor(const MoleculeBasisInertiaTensor &basis);
     ~MoleculeBasisInertiaTensor() {}
     MoleculeBasis *clone();
 
     BasisCode code() const;
+    void update();
 private:
     Eigen::Matrix3d calcInertiaTensor();
 };
@@ -30,24 +30,7 @@ MoleculeBasisOnAtoms::MoleculeBasisOnAtoms(moleculePtr molecule, const int atom1
     m_atom2 = atom2;
     m_atom3 = atom3;
 
-    Eigen::Vector3d vector1, vector2, vector3;
-
-    vector1 = m_molecule->atom(atom2)->position() - m_molecule->atom(atom1)->position();
-    vector1.normalize();
-
-    vector2 = m_molecule->atom(atom3)->position() - m_molecule->atom(atom1)->position();
-    vector2 -= vector1 * vector1.dot(vector2);
-    vector2.normalize();
-
-    vector3 = vector1.cross(vector2);
-    vector3.normalize();
-
-    Eigen::Matrix3d rot;
-    rot.col(0) = vector1;
-    rot.col(1) = vector2;
-    rot.col(2) = vector3;
-
-    setEulerAngles(rot);
+    update();
 }
 
 MoleculeBasisOnAtoms::MoleculeBasisOnAtoms(const MoleculeBasisOnAtoms &basis)
@@ -63,9 +46,10 @@ MoleculeBasis *MoleculeBasisOnAtoms::clone()
     return new MoleculeBasisOnAtoms(*this);
 }
 
-std::vector<bool> MoleculeBasisOnAtoms::basisList() const
+const AtomMask &MoleculeBasisOnAtoms::basisList() const
 {
-    return std::vector<bool>();
+    static const AtomMask noAtoms;
+    return noAtoms;
 }
 
 std::array<int,3> MoleculeBasisOnAtoms::atoms() const
@@ -83,4 +67,26 @@ BasisCode MoleculeBasisOnAtoms::code() const
     return kVectorsFromAtoms;
 }
 
+void MoleculeBasisOnAtoms::update()
+{
+    Eigen::Vector3d vector1, vector2, vector3;
+
+    vector1 = m_molecule->atomPosition(m_atom2) - m_molecule->atomPosition(m_atom1);
+    vector1.normalize();
+
+    vector2 = m_molecule->atomPosition(m_atom3) - m_molecule->atomPosition(m_atom1);
+    vector2 -= vector1 * vector1.dot(vector2);
+    vector2.normalize();
+
+    vector3 = vector1.cross(vector2);
+    vector3.normalize();
+
+    Eigen::Matrix3d rot;
+    rot.col(0) = vector1;
+    rot.col(1) = vector2;
+    rot.col(2) = vector3;
+
+    setAxes(rot);
+}
+
 }
@@ -33,10 +33,11 @@ public:
     MoleculeBasisOnAtoms(const MoleculeBasisOnAtoms &basis);
     MoleculeBasis *clone();
 
-    std::vector<bool> basisList() const;
+    const AtomMask &basisList() const;
     std::array<int,3> atoms() const;
 
     BasisCode code() const;
+    void update();
 
 private:
     int m_atom1;
@@ -0,0 +1,237 @@
+/*
+ * Copyright 2014 - 2019 Jan von Cosel & Sebastian Lenz
+ *
+ * This file is part of molconv.
+ *
+ * molconv is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * molconv is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have recieved a copy of the GNU General Public License
+ * along with molconv. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include "molecule.h"
+#include "moleculemoments.h"
+
+namespace molconv {
+
+MoleculeMoments::MoleculeMoments()
+    : m_nAtoms(0)
+    , m_reference(Eigen::Vector3d::Zero())
+{
+    for (size_t k = 0; k < m_moments.size(); k++)
+        m_moments[k].setZero();
+}
+
+///
+/// \brief MoleculeMoments::MoleculeMoments
+/// \param molecule
+/// \param atomList
+///
+/// accumulate the moments of the atoms of \p molecule (or of the atoms selected
+/// by \p atomList, if it is not empty), taken from its coordinate store
+///
+MoleculeMoments::MoleculeMoments(const Molecule &molecule, const AtomMask &atomList)
+    : MoleculeMoments()
+{
+    const Eigen::Matrix3Xd &allPositions = molecule.positions();
+    const Eigen::VectorXd &allMasses = molecule.masses();
+    const Eigen::VectorXd &allCharges = molecule.nuclearCharges();
+
+    const size_t nActive = atomList.empty() ? size_t(allPositions.cols()) : atomList.count();
+
+    if (nActive == 0)
+        return;
+
+    Eigen::Matrix4Xd positions(4, nActive);
+    Eigen::Matrix<double, Eigen::Dynamic, 3> weights(nActive, 3);
+
+    if (nActive == size_t(allPositions.cols()))
+    {
+        positions.topRows<3>() = allPositions;
+        weights.col(kMass) = allMasses;
+        weights.col(kCharge) = allCharges;
+    }
+    else
+    {
+        size_t col = 0;
+        atomList.forEach([&](const size_t i)
+        {
+            positions.block<3,1>(0, col) = allPositions.col(i);
+            weights(col, kMass) = allMasses(i);
+            weights(col, kCharge) = allCharges(i);
+            col++;
+        });
+    }
+    positions.row(3).setOnes();
+
+    accumulate(positions, weights);
+}
+
+MoleculeMoments::MoleculeMoments(const Eigen::Matrix3Xd &positions, const Eigen::VectorXd &masses, const Eigen::VectorXd &charges)
+    : MoleculeMoments()
+{
+    if (positions.cols() == 0)
+        return;
+
+    Eigen::Matrix4Xd augmented(4, positions.cols());
+    augmented.topRows<3>() = positions;
+    augmented.row(3).setOnes();
+
+    Eigen::Matrix<double, Eigen::Dynamic, 3> weights(positions.cols(), 3);
+    weights.col(kMass) = masses;
+    weights.col(kCharge) = charges;
+
+    accumulate(augmented, weights);
+}
+
+size_t MoleculeMoments::nAtoms() const
+{
+    return m_nAtoms;
+}
+
+double MoleculeMoments::totalMass() const
+{
+    return m_moments[kMass](3,3);
+}
+
+double MoleculeMoments::totalCharge() const
+{
+    return m_moments[kCharge](3,3);
+}
+
+Eigen::Vector3d MoleculeMoments::centerOfMass() const
+{
+    return center(kMass);
+}
+
+Eigen::Vector3d MoleculeMoments::centerOfCharge() const
+{
+    return center(kCharge);
+}
+
+Eigen::Vector3d MoleculeMoments::centerOfGeometry() const
+{
+    return center(kUnit);
+}
+
+Eigen::Matrix3d MoleculeMoments::inertiaTensor() const
+{
+    return inertiaTensor(centerOfMass());
+}
+
+///
+/// \brief MoleculeMoments::inertiaTensor
+/// \param center
+/// \return
+///
+/// the inertia tensor w.r.t. the point \p center:
+///
+///   I_ab = sum_i m_i (|r_i - c|^2 delta_ab - (r_i - c)_a (r_i - c)_b)
+///
+Eigen::Matrix3d MoleculeMoments::inertiaTensor(const Eigen::Vector3d &center) const
+{
+    Eigen::Matrix3d second = centeredSecondMoment(kMass, center);
+
+    return second.trace() * Eigen::Matrix3d::Identity() - second;
+}
+
+Eigen::Matrix3d MoleculeMoments::chargeTensor() const
+{
+    return chargeTensor(centerOfCharge());
+}
+
+Eigen::Matrix3d MoleculeMoments::chargeTensor(const Eigen::Vector3d &center) const
+{
+    Eigen::Matrix3d second = centeredSecondMoment(kCharge, center);
+
+    return second.trace() * Eigen::Matrix3d::Identity() - second;
+}
+
+Eigen::Matrix3d MoleculeMoments::covarianceMatrix() const
+{
+    return covarianceMatrix(centerOfGeometry());
+}
+
+Eigen::Matrix3d MoleculeMoments::covarianceMatrix(const Eigen::Vector3d &center) const
+{
+    return centeredSecondMoment(kUnit, center) / double(m_nAtoms);
+}
+
+///
+/// \brief MoleculeMoments::accumulate
+/// \param positions
+/// \param weights
+///
+/// The positions are passed as a 4xN matrix Q, whose last row is one. With the
+/// diagonal matrix W_k of the k-th set of weights, the product Q W_k Q^T contains
+/// all moments for that weight at once:
+///
+///              | sum w r r^T   sum w r |
+///   Q W_k Q^T = |                       |
+///              | sum w r^T     sum w   |
+///
+/// The three weighted copies W_k Q^T are placed side by side in one Nx12 matrix,
+/// so that a single product with Q yields the moments of all weights.
+///
+/// The positions are shifted by the first atom beforehand to avoid the loss of
+/// precision when the second moments are centered afterwards.
+///
+void MoleculeMoments::accumulate(const Eigen::Matrix4Xd &positions, const Eigen::Matrix<double, Eigen::Dynamic, 3> &weights)
+{
+    m_nAtoms = size_t(positions.cols());
+    m_reference = positions.block<3,1>(0, 0);
+
+    Eigen::Matrix4Xd shifted = positions;
+    shifted.topRows<3>().colwise() -= m_reference;
+
+    Eigen::Matrix<double, Eigen::Dynamic, 12> weighted(positions.cols(), 12);
+    weighted.middleCols<4>(4 * kMass) = weights.col(kMass).asDiagonal() * shifted.transpose();
+    weighted.middleCols<4>(4 * kCharge) = weights.col(kCharge).asDiagonal() * shifted.transpose();
+    weighted.middleCols<4>(4 * kUnit) = shifted.transpose();
+
+    const Eigen::Matrix<double, 4, 12> moments = shifted * weighted;
+
+    for (size_t k = 0; k < m_moments.size(); k++)
+        m_moments[k] = moments.middleCols<4>(4 * k);
+}
+
+Eigen::Vector3d MoleculeMoments::center(const Weight weight) const
+{
+    if (m_nAtoms == 0)
+        return Eigen::Vector3d::Zero();
+
+    return m_reference + m_moments[weight].block<3,1>(0, 3) / m_moments[weight](3,3);
+}
+
+///
+/// \brief MoleculeMoments::centeredSecondMoment
+/// \param weight
+/// \param center
+/// \return
+///
+/// sum_i w_i (r_i - c) (r_i - c)^T, obtained from the moments w.r.t. the
+/// reference point by shifting them to \p center
+///
+Eigen::Matrix3d MoleculeMoments::centeredSecondMoment(const Weight weight, const Eigen::Vector3d &center) const
+{
+    const MomentMatrix &moments = m_moments[weight];
+    Eigen::Vector3d shift = center - m_reference;
+    Eigen::Vector3d first = moments.block<3,1>(0, 3);
+
+    return moments.block<3,3>(0, 0)
+         - first * shift.transpose()
+         - shift * first.transpose()
+         + moments(3,3) * shift * shift.transpose();
+}
+
+}
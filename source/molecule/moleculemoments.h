@@ -0,0 +1,84 @@
+/*
+ * Copyright 2014 - 2019 Jan von Cosel & Sebastian Lenz
+ *
+ * This file is part of molconv.
+ *
+ * molconv is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * molconv is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have recieved a copy of the GNU General Public License
+ * along with molconv. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#ifndef MOLECULEMOMENTS_H
+#define MOLECULEMOMENTS_H
+
+#include <array>
+#include <Eigen/Core>
+#include "atommask.h"
+
+namespace molconv {
+
+class Molecule;
+
+///
+/// \brief The MoleculeMoments class
+///
+/// zeroth, first and second moments of the atomic positions of a molecule,
+/// weighted with the atomic masses, the nuclear charges and unity. All three
+/// sets are accumulated in a single pass over the atoms, so that the inertia
+/// tensor, the charge tensor and the covariance matrix (and the corresponding
+/// centers) can be derived without touching the atoms again.
+///
+class MoleculeMoments
+{
+public:
+    MoleculeMoments();
+    MoleculeMoments(const Molecule &molecule, const AtomMask &atomList = AtomMask());
+    MoleculeMoments(const Eigen::Matrix3Xd &positions, const Eigen::VectorXd &masses, const Eigen::VectorXd &charges);
+
+    size_t nAtoms() const;
+    double totalMass() const;
+    double totalCharge() const;
+
+    Eigen::Vector3d centerOfMass() const;
+    Eigen::Vector3d centerOfCharge() const;
+    Eigen::Vector3d centerOfGeometry() const;
+
+    Eigen::Matrix3d inertiaTensor() const;
+    Eigen::Matrix3d inertiaTensor(const Eigen::Vector3d &center) const;
+    Eigen::Matrix3d chargeTensor() const;
+    Eigen::Matrix3d chargeTensor(const Eigen::Vector3d &center) const;
+    Eigen::Matrix3d covarianceMatrix() const;
+    Eigen::Matrix3d covarianceMatrix(const Eigen::Vector3d &center) const;
+
+private:
+    enum Weight {
+        kMass = 0,
+        kCharge = 1,
+        kUnit = 2
+    };
+
+    typedef Eigen::Matrix<double, 4, 4, Eigen::DontAlign> MomentMatrix;
+
+    void accumulate(const Eigen::Matrix4Xd &positions, const Eigen::Matrix<double, Eigen::Dynamic, 3> &weights);
+    Eigen::Vector3d center(const Weight weight) const;
+    Eigen::Matrix3d centeredSecondMoment(const Weight weight, const Eigen::Vector3d &center) const;
+
+    size_t m_nAtoms;
+    Eigen::Vector3d m_reference;
+    std::array<MomentMatrix, 3> m_moments;
+};
+
+}
+
+#endif // MOLECULEMOMENTS_H
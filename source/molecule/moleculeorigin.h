@@ -24,6 +24,7 @@
 
 #include <Eigen/Core>
 #include "types.h"
+#include "atommask.h"
 #include "molecule.h"
 
 namespace molconv {
@@ -40,11 +41,14 @@ public:
     Eigen::Vector3d position() const;
     void setPosition(const Eigen::Vector3d newPosition);
 
-    virtual std::vector<bool> originList() const = 0;
+    virtual const AtomMask &originList() const = 0;
     virtual std::array<int,2> atoms() const = 0;
     virtual double factor() const = 0;
     virtual OriginCode code() const = 0;
 
+    // determine the position anew from the current geometry of the molecule:
+    virtual void update() = 0;
+
 protected:
     moleculePtr m_molecule;
     Eigen::Vector3d m_position;
@@ -29,8 +29,7 @@ MoleculeOriginBetweenAtoms::MoleculeOriginBetweenAtoms(moleculePtr molecule, con
     m_atom2 = atom2;
     m_factor = factor;
 
-    m_position = m_factor * m_molecule->atom(m_atom1)->position()
-               + (1.0 - m_factor) * m_molecule->atom(m_atom2)->position();
+    update();
 }
 
 MoleculeOriginBetweenAtoms::MoleculeOriginBetweenAtoms(const MoleculeOriginBetweenAtoms &origin)
@@ -67,4 +66,10 @@ OriginCode MoleculeOriginBetweenAtoms::code() const
     return kCenterBetweenAtoms;
 }
 
+void MoleculeOriginBetweenAtoms::update()
+{
+    m_position = m_factor * m_molecule->atomPosition(m_atom1)
+               + (1.0 - m_factor) * m_molecule->atomPosition(m_atom2);
+}
+
 }
@@ -37,6 +37,7 @@ public:
     std::array<int,2> atoms() const;
     double factor() const;
     OriginCode code() const;
+    void update();
 
 private:
     int m_atom2;
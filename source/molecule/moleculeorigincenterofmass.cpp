@@ -23,22 +23,10 @@
 
 namespace molconv {
 
-MoleculeOriginCenterOfMass::MoleculeOriginCenterOfMass(moleculePtr molecule, std::vector<bool> originList)
+MoleculeOriginCenterOfMass::MoleculeOriginCenterOfMass(moleculePtr molecule, const AtomMask &originList)
     : MoleculeOriginGlobal(molecule, originList)
 {
-    Eigen::Vector3d centerOfMass = Eigen::Vector3d::Zero();
-    double totalMass = 0.0;
-
-    for (int i = 0; i < int(m_molecule->size()); i++)
-    {
-        if (m_originList.at(i))
-        {
-            centerOfMass += m_molecule->atom(i)->position() * m_molecule->atom(i)->mass();
-            totalMass += m_molecule->atom(i)->mass();
-        }
-    }
-
-    m_position = centerOfMass / totalMass;
+    update();
 }
 
 MoleculeOriginCenterOfMass::MoleculeOriginCenterOfMass(const MoleculeOriginCenterOfMass &origin)
@@ -59,4 +47,29 @@ OriginCode MoleculeOriginCenterOfMass::code() const
     return kCenterOfMass;
 }
 
+void MoleculeOriginCenterOfMass::update()
+{
+    Eigen::Vector3d centerOfMass = Eigen::Vector3d::Zero();
+    double totalMass = 0.0;
+
+    const Eigen::Matrix3Xd &positions = m_molecule->positions();
+    const Eigen::VectorXd &masses = m_molecule->masses();
+
+    if (m_originList.all())
+    {
+        centerOfMass = positions * masses;
+        totalMass = masses.sum();
+    }
+    else
+    {
+        m_originList.forEach([&](const size_t i)
+        {
+            centerOfMass += positions.col(i) * masses(i);
+            totalMass += masses(i);
+        });
+    }
+
+    m_position = centerOfMass / totalMass;
+}
+
 }
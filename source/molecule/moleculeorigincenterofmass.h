@@ -29,12 +29,13 @@ namespace molconv {
 class MoleculeOriginCenterOfMass : public MoleculeOriginGlobal
 {
 public:
-    MoleculeOriginCenterOfMass(moleculePtr molecule, std::vector<bool> originList);
+    MoleculeOriginCenterOfMass(moleculePtr molecule, const AtomMask &originList);
     MoleculeOriginCenterOfMass(const MoleculeOriginCenterOfMass &origin);
     ~MoleculeOriginCenterOfMass() {}
     MoleculeOrigin *clone();
 
     OriginCode code() const;
+    void update();
 };
 
 }
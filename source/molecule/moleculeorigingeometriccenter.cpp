@@ -23,22 +23,10 @@
 
 namespace molconv {
 
-MoleculeOriginGeometricCenter::MoleculeOriginGeometricCenter(moleculePtr molecule, std::vector<bool> originList)
+MoleculeOriginGeometricCenter::MoleculeOriginGeometricCenter(moleculePtr molecule, const AtomMask &originList)
     : MoleculeOriginGlobal(molecule, originList)
 {
-    Eigen::Vector3d center = Eigen::Vector3d::Zero();
-    int Nactive = 0;
-
-    for (int i = 0; i < int(m_molecule->size()); i++)
-    {
-        if (m_originList.at(i))
-        {
-            center += m_molecule->atom(i)->position();
-            Nactive++;
-        }
-    }
-
-    m_position = center / double(Nactive);
+    update();
 }
 
 MoleculeOriginGeometricCenter::MoleculeOriginGeometricCenter(const MoleculeOriginGeometricCenter &origin)
@@ -59,5 +47,20 @@ OriginCode MoleculeOriginGeometricCenter::code() const
     return kCenterOfGeometry;
 }
 
+void MoleculeOriginGeometricCenter::update()
+{
+    Eigen::Vector3d center = Eigen::Vector3d::Zero();
+    const size_t Nactive = m_originList.count();
+
+    const Eigen::Matrix3Xd &positions = m_molecule->positions();
+
+    if (Nactive == size_t(positions.cols()))
+        center = positions.rowwise().sum();
+    else
+        m_originList.forEach([&](const size_t i) { center += positions.col(i); });
+
+    m_position = center / double(Nactive);
+}
+
 }
 
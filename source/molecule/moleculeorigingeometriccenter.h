@@ -29,12 +29,13 @@ namespace molconv {
 class MoleculeOriginGeometricCenter : public MoleculeOriginGlobal
 {
 public:
-    MoleculeOriginGeometricCenter(moleculePtr molecule, std::vector<bool> originList);
+    MoleculeOriginGeometricCenter(moleculePtr molecule, const AtomMask &originList);
     MoleculeOriginGeometricCenter(const MoleculeOriginGeometricCenter &origin);
     ~MoleculeOriginGeometricCenter() {}
     MoleculeOrigin *clone();
 
     OriginCode code() const;
+    void update();
 };
 
 }
@@ -27,13 +27,13 @@ MoleculeOriginGlobal::MoleculeOriginGlobal()
 {
 }
 
-MoleculeOriginGlobal::MoleculeOriginGlobal(moleculePtr molecule, std::vector<bool> originList)
+MoleculeOriginGlobal::MoleculeOriginGlobal(moleculePtr molecule, const AtomMask &originList)
     : MoleculeOrigin(molecule)
 {
     m_originList = originList;
 }
 
-std::vector<bool> MoleculeOriginGlobal::originList() const
+const AtomMask &MoleculeOriginGlobal::originList() const
 {
     return m_originList;
 }
@@ -30,14 +30,14 @@ class MoleculeOriginGlobal : public MoleculeOrigin
 {
 public:
     MoleculeOriginGlobal();
-    MoleculeOriginGlobal(moleculePtr molecule, std::vector<bool> originList);
+    MoleculeOriginGlobal(moleculePtr molecule, const AtomMask &originList);
 
-    std::vector<bool> originList() const;
+    const AtomMask &originList() const;
     std::array<int,2> atoms() const;
     double factor() const;
 
 protected:
-    std::vector<bool> m_originList;
+    AtomMask m_originList;
 };
 
 }
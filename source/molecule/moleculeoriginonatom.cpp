@@ -32,7 +32,7 @@ MoleculeOriginOnAtom::MoleculeOriginOnAtom(moleculePtr molecule, const int atom1
 {
     m_atom1 = atom1;
 
-    m_position = m_molecule->atom(m_atom1)->position();
+    update();
 }
 
 MoleculeOriginOnAtom::MoleculeOriginOnAtom(const MoleculeOriginOnAtom &origin)
@@ -48,9 +48,10 @@ MoleculeOrigin *MoleculeOriginOnAtom::clone()
     return new MoleculeOriginOnAtom(*this);
 }
 
-std::vector<bool> MoleculeOriginOnAtom::originList() const
+const AtomMask &MoleculeOriginOnAtom::originList() const
 {
-    return std::vector<bool>();
+    static const AtomMask noAtoms;
+    return noAtoms;
 }
 
 std::array<int,2> MoleculeOriginOnAtom::atoms() const
@@ -72,4 +73,9 @@ OriginCode MoleculeOriginOnAtom::code() const
     return kCenterOnAtom;
 }
 
+void MoleculeOriginOnAtom::update()
+{
+    m_position = m_molecule->atomPosition(m_atom1);
+}
+
 }
@@ -35,10 +35,11 @@ public:
     ~MoleculeOriginOnAtom() {}
     virtual MoleculeOrigin *clone();
 
-    std::vector<bool> originList() const;
+    const AtomMask &originList() const;
     virtual std::array<int,2> atoms() const;
     virtual double factor() const;
     virtual OriginCode code() const;
+    virtual void update();
 
 protected:
     int m_atom1;
@@ -0,0 +1,378 @@
+/*
+ * Copyright 2014 - 2019 Jan von Cosel & Sebastian Lenz
+ *
+ * This file is part of molconv.
+ *
+ * molconv is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * molconv is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have recieved a copy of the GNU General Public License
+ * along with molconv. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include <algorithm>
+#include <chrono>
+#include "molecule.h"
+#include "system.h"
+#include "contactmonitor.h"
+
+
+namespace molconv
+{
+    ContactMonitor::ContactMonitor(const double contactCutoff, const double clashTolerance)
+        : m_contactCutoff(contactCutoff)
+        , m_clashTolerance(clashTolerance)
+        , m_timeBudget(10.0)
+        , m_maxRadius(0.0)
+    {
+    }
+
+    ///
+    /// \brief ContactMonitor::setContactCutoff
+    /// \param cutoff
+    ///
+    /// only atom pairs closer than \p cutoff are reported as contacts
+    ///
+    void ContactMonitor::setContactCutoff(const double cutoff)
+    {
+        m_contactCutoff = cutoff;
+        reset();
+    }
+
+    double ContactMonitor::contactCutoff() const
+    {
+        return m_contactCutoff;
+    }
+
+    void ContactMonitor::setClashTolerance(const double tolerance)
+    {
+        m_clashTolerance = tolerance;
+        reset();
+    }
+
+    double ContactMonitor::clashTolerance() const
+    {
+        return m_clashTolerance;
+    }
+
+    ///
+    /// \brief ContactMonitor::setTimeBudget
+    /// \param milliseconds
+    ///
+    /// the time after which an update stops checking atoms
+    ///
+    void ContactMonitor::setTimeBudget(const double milliseconds)
+    {
+        m_timeBudget = milliseconds;
+    }
+
+    double ContactMonitor::timeBudget() const
+    {
+        return m_timeBudget;
+    }
+
+    ///
+    /// \brief ContactMonitor::reset
+    ///
+    /// forget all results, the next updates check all molecules again
+    ///
+    void ContactMonitor::reset()
+    {
+        m_index.clear();
+        m_generations.clear();
+        m_radii.clear();
+        m_maxRadius = 0.0;
+        m_pending.clear();
+        m_results.clear();
+        m_partners.clear();
+    }
+
+    ///
+    /// \brief ContactMonitor::update
+    /// \return
+    ///
+    /// find the molecules that were added, removed or moved since the last update
+    /// and check the pairs of molecules that they might touch. Returns true if
+    /// all pairs have been checked, false if the time budget ran out first.
+    ///
+    bool ContactMonitor::update()
+    {
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        const System &system = System::get();
+
+        // drop the molecules that are gone:
+        for (auto generation = m_generations.begin(); generation != m_generations.end(); )
+        {
+            if (system.hasMolecule(generation->first))
+            {
+                ++generation;
+                continue;
+            }
+
+            erasePairs(generation->first);
+            m_radii.erase(generation->first);
+            generation = m_generations.erase(generation);
+        }
+
+        // the molecules that changed, in the order of the system:
+        std::vector<unsigned long> changed;
+        for (auto const& molecule : system.molecules())
+        {
+            molecule->positions();
+            auto generation = m_generations.find(molecule->molId());
+
+            if (generation == m_generations.end() || generation->second != molecule->coordinateGeneration())
+            {
+                m_generations[molecule->molId()] = molecule->coordinateGeneration();
+                vdwRadii(*molecule);
+                changed.push_back(molecule->molId());
+            }
+        }
+
+        m_index.update();
+
+        // broad phase, the bounding spheres of the changed molecules:
+        const double reach = searchRadius();
+        for (auto const& id : changed)
+        {
+            erasePairs(id);
+
+            for (auto const& other : m_index.moleculesWithin(m_index.sphereCenter(id), m_index.sphereRadius(id) + reach, id))
+                m_pending.insert(std::make_pair(std::min(id, other), std::max(id, other)));
+        }
+
+        // narrow phase, as long as the time budget lasts:
+        while (!m_pending.empty())
+        {
+            const MoleculePair pair = *m_pending.begin();
+            m_pending.erase(m_pending.begin());
+            checkPair(pair);
+
+            const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+            if (elapsed.count() >= m_timeBudget)
+                break;
+        }
+
+        return m_pending.empty();
+    }
+
+    bool ContactMonitor::isComplete() const
+    {
+        return m_pending.empty();
+    }
+
+    ///
+    /// \brief ContactMonitor::closestContacts
+    /// \param n
+    /// \param molId
+    /// \return
+    ///
+    /// the \p n shortest contacts between pairs of molecules, sorted by their
+    /// distance. Every pair of molecules contributes its closest atoms only. If
+    /// \p molId is given, only the contacts of this molecule are considered.
+    ///
+    std::vector<ContactMonitor::Contact> ContactMonitor::closestContacts(const size_t n, const unsigned long molId) const
+    {
+        std::vector<Contact> result;
+
+        if (molId != MoleculeIdAllocator::kInvalidId)
+        {
+            auto partners = m_partners.find(molId);
+            if (partners != m_partners.end())
+            {
+                for (auto const& other : partners->second)
+                    result.push_back(m_results.at(std::make_pair(std::min(molId, other), std::max(molId, other))).closest);
+            }
+        }
+        else
+        {
+            for (auto const& pair : m_results)
+                result.push_back(pair.second.closest);
+        }
+
+        auto closer = [](const Contact &a, const Contact &b) { return a.distance < b.distance; };
+        if (result.size() > n)
+        {
+            std::partial_sort(result.begin(), result.begin() + std::ptrdiff_t(n), result.end(), closer);
+            result.resize(n);
+        }
+        else
+            std::sort(result.begin(), result.end(), closer);
+
+        return result;
+    }
+
+    std::vector<ContactMonitor::Contact> ContactMonitor::clashes() const
+    {
+        std::vector<Contact> result;
+        for (auto const& pair : m_results)
+            result.insert(result.end(), pair.second.clashes.begin(), pair.second.clashes.end());
+
+        return result;
+    }
+
+    ///
+    /// \brief ContactMonitor::clashingAtoms
+    /// \return
+    ///
+    /// all atoms that take part in a clash, as pairs of molecule ID and atom index
+    ///
+    std::vector<std::pair<unsigned long,size_t>> ContactMonitor::clashingAtoms() const
+    {
+        std::vector<std::pair<unsigned long,size_t>> result;
+        for (auto const& pair : m_results)
+        {
+            for (auto const& clash : pair.second.clashes)
+            {
+                result.push_back(std::make_pair(clash.molId1, clash.atom1));
+                result.push_back(std::make_pair(clash.molId2, clash.atom2));
+            }
+        }
+
+        std::sort(result.begin(), result.end());
+        result.erase(std::unique(result.begin(), result.end()), result.end());
+
+        return result;
+    }
+
+    size_t ContactMonitor::nClashes() const
+    {
+        size_t count = 0;
+        for (auto const& pair : m_results)
+            count += pair.second.clashes.size();
+
+        return count;
+    }
+
+    void ContactMonitor::erasePairs(const unsigned long molId)
+    {
+        auto partners = m_partners.find(molId);
+        if (partners == m_partners.end())
+            return;
+
+        for (auto const& other : partners->second)
+        {
+            m_results.erase(std::make_pair(std::min(molId, other), std::max(molId, other)));
+
+            auto otherPartners = m_partners.find(other);
+            if (otherPartners != m_partners.end())
+            {
+                otherPartners->second.erase(molId);
+                if (otherPartners->second.empty())
+                    m_partners.erase(otherPartners);
+            }
+        }
+
+        m_partners.erase(molId);
+    }
+
+    ///
+    /// \brief ContactMonitor::checkPair
+    /// \param pair
+    ///
+    /// compare the atoms of the smaller molecule of the pair with the nearby atoms
+    /// of the larger one and store the closest contact and all clashes
+    ///
+    void ContactMonitor::checkPair(const MoleculePair &pair)
+    {
+        const System &system = System::get();
+        if (!system.hasMolecule(pair.first) || !system.hasMolecule(pair.second) || !m_index.hasMolecule(pair.first) || !m_index.hasMolecule(pair.second))
+            return;
+
+        moleculePtr first = system.getMolecule(pair.first);
+        moleculePtr second = system.getMolecule(pair.second);
+        const bool swapped = first->size() > second->size();
+        const Molecule &small = swapped ? *second : *first;
+        const Molecule &large = swapped ? *first : *second;
+
+        const Eigen::VectorXd &smallRadii = m_radii.at(small.molId());
+        const Eigen::VectorXd &largeRadii = m_radii.at(large.molId());
+        const double largeMaxRadius = largeRadii.size() > 0 ? largeRadii.maxCoeff() : 0.0;
+        const Eigen::Vector3d largeCenter = m_index.sphereCenter(large.molId());
+        const double largeSphere = m_index.sphereRadius(large.molId());
+
+        PairResult result;
+        result.closest.distance = -1.0;
+
+        const Eigen::Matrix3Xd &positions = small.positions();
+        for (size_t i = 0; i < small.size(); i++)
+        {
+            const double radius = std::max(m_contactCutoff, smallRadii(i) + largeMaxRadius - m_clashTolerance);
+            const Eigen::Vector3d position = positions.col(i);
+
+            if ((position - largeCenter).norm() > largeSphere + radius)
+                continue;
+
+            for (auto const& neighbor : m_index.searchMolecule(large.molId(), position, radius))
+            {
+                Contact contact;
+                contact.molId1 = small.molId();
+                contact.atom1 = i;
+                contact.molId2 = large.molId();
+                contact.atom2 = neighbor.atom;
+                contact.distance = neighbor.distance;
+                contact.vdwDistance = smallRadii(i) + largeRadii(neighbor.atom);
+                contact.clash = contact.distance < contact.vdwDistance - m_clashTolerance;
+
+                // the contacts are stored in the order of the pair:
+                if (swapped)
+                {
+                    std::swap(contact.molId1, contact.molId2);
+                    std::swap(contact.atom1, contact.atom2);
+                }
+
+                if (contact.clash)
+                    result.clashes.push_back(contact);
+
+                if ((contact.distance <= m_contactCutoff || contact.clash)
+                        && (result.closest.distance < 0.0 || contact.distance < result.closest.distance))
+                    result.closest = contact;
+            }
+        }
+
+        if (result.closest.distance < 0.0)
+            return;
+
+        m_results[pair] = result;
+        m_partners[pair.first].insert(pair.second);
+        m_partners[pair.second].insert(pair.first);
+    }
+
+    const Eigen::VectorXd &ContactMonitor::vdwRadii(const Molecule &molecule)
+    {
+        Eigen::VectorXd &radii = m_radii[molecule.molId()];
+
+        if (size_t(radii.size()) != molecule.size())
+        {
+            radii.resize(molecule.size());
+            for (size_t i = 0; i < molecule.size(); i++)
+                radii(i) = molecule.atom(i)->element().vanDerWaalsRadius();
+
+            if (radii.size() > 0)
+                m_maxRadius = std::max(m_maxRadius, radii.maxCoeff());
+        }
+
+        return radii;
+    }
+
+    ///
+    /// \brief ContactMonitor::searchRadius
+    /// \return
+    ///
+    /// the largest distance at which two atoms can be in contact or clash
+    ///
+    double ContactMonitor::searchRadius() const
+    {
+        return std::max(m_contactCutoff, 2.0 * m_maxRadius - m_clashTolerance);
+    }
+
+} // namespace molconv
@@ -0,0 +1,115 @@
+/*
+ * Copyright 2014 - 2019 Jan von Cosel & Sebastian Lenz
+ *
+ * This file is part of molconv.
+ *
+ * molconv is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * molconv is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have recieved a copy of the GNU General Public License
+ * along with molconv. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#ifndef CONTACTMONITOR_H
+#define CONTACTMONITOR_H
+
+#include<map>
+#include<set>
+#include<unordered_map>
+#include<utility>
+#include<vector>
+#include<Eigen/Core>
+#include "spatialindex.h"
+#include "types.h"
+
+namespace molconv
+{
+    ///
+    /// \brief The ContactMonitor class
+    ///
+    /// keeps track of the shortest distances and the steric clashes between the
+    /// molecules of the system while they are moved. Two atoms of different
+    /// molecules clash if their distance is below the sum of their van der Waals
+    /// radii minus the clash tolerance.
+    ///
+    /// Only the molecules that changed since the last update are checked again:
+    /// their bounding spheres are compared with those of all other molecules in
+    /// the spatial index, and only the pairs of molecules whose spheres come close
+    /// are checked atom by atom. The atom checks of one update stop once the time
+    /// budget is used up, the remaining pairs are checked by the next update.
+    ///
+    class ContactMonitor
+    {
+    public:
+        struct Contact
+        {
+            unsigned long molId1;
+            size_t atom1;
+            unsigned long molId2;
+            size_t atom2;
+            double distance;
+            double vdwDistance;
+            bool clash;
+        };
+
+        ContactMonitor(const double contactCutoff = 4.0, const double clashTolerance = 0.0);
+
+        void setContactCutoff(const double cutoff);
+        double contactCutoff() const;
+        void setClashTolerance(const double tolerance);
+        double clashTolerance() const;
+        void setTimeBudget(const double milliseconds);
+        double timeBudget() const;
+
+        void reset();
+        bool update();
+        bool isComplete() const;
+
+        std::vector<Contact> closestContacts(const size_t n, const unsigned long molId = MoleculeIdAllocator::kInvalidId) const;
+        std::vector<Contact> clashes() const;
+        std::vector<std::pair<unsigned long,size_t>> clashingAtoms() const;
+        size_t nClashes() const;
+
+    private:
+        typedef std::pair<unsigned long,unsigned long> MoleculePair;
+
+        struct PairResult
+        {
+            Contact closest;
+            std::vector<Contact> clashes;
+        };
+
+        void erasePairs(const unsigned long molId);
+        void checkPair(const MoleculePair &pair);
+        const Eigen::VectorXd &vdwRadii(const Molecule &molecule);
+        double searchRadius() const;
+
+        SpatialIndex m_index;
+        double m_contactCutoff;
+        double m_clashTolerance;
+        double m_timeBudget;
+
+        // the coordinate generation of every molecule at the last update:
+        std::unordered_map<unsigned long, unsigned long> m_generations;
+        std::unordered_map<unsigned long, Eigen::VectorXd> m_radii;
+        double m_maxRadius;
+
+        // the pairs of molecules that still have to be checked, the results of
+        // all pairs that are in contact and the partners of every molecule:
+        std::set<MoleculePair> m_pending;
+        std::map<MoleculePair, PairResult> m_results;
+        std::unordered_map<unsigned long, std::set<unsigned long>> m_partners;
+    };
+
+} // namespace molconv
+
+#endif // CONTACTMONITOR_H
@@ -0,0 +1,110 @@
+/*
+ * Copyright 2014 - 2019 Jan von Cosel & Sebastian Lenz
+ *
+ * This file is part of molconv.
+ *
+ * molconv is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * molconv is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have recieved a copy of the GNU General Public License
+ * along with molconv. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include <stdexcept>
+#include "moleculeidallocator.h"
+
+
+namespace molconv
+{
+    static_assert(sizeof(unsigned long) >= 8, "molecule IDs need 64 bit");
+
+    MoleculeIdAllocator::MoleculeIdAllocator()
+    {
+    }
+
+    ///
+    /// \brief MoleculeIdAllocator::allocate
+    /// \return
+    ///
+    /// returns a new ID. The most recently released slot is reused first.
+    ///
+    unsigned long MoleculeIdAllocator::allocate()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        uint32_t slot;
+        if (!m_freeSlots.empty())
+        {
+            slot = m_freeSlots.back();
+            m_freeSlots.pop_back();
+            m_generations[slot]++;
+            m_inUse[slot] = true;
+        }
+        else
+        {
+            if (m_generations.size() > 0xffffffffUL)
+                throw std::length_error("no more molecule IDs available.\n");
+
+            slot = uint32_t(m_generations.size());
+            m_generations.push_back(1);
+            m_inUse.push_back(true);
+        }
+
+        return (unsigned long)(m_generations[slot]) << 32 | slot;
+    }
+
+    ///
+    /// \brief MoleculeIdAllocator::release
+    /// \param id
+    /// \return
+    ///
+    /// give the ID \p id back. Its slot is reused with the next generation, so
+    /// that the old ID stays invalid. Returns false if \p id was not allocated.
+    ///
+    bool MoleculeIdAllocator::release(const unsigned long id)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        const size_t index = slot(id);
+        if (index >= m_generations.size() || !m_inUse[index] || m_generations[index] != generation(id))
+            return false;
+
+        m_inUse[index] = false;
+
+        // a slot whose generation would wrap around is not used again:
+        if (m_generations[index] != 0xffffffffU)
+            m_freeSlots.push_back(uint32_t(index));
+
+        return true;
+    }
+
+    bool MoleculeIdAllocator::isAllocated(const unsigned long id) const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        const size_t index = slot(id);
+        return index < m_generations.size() && m_inUse[index] && m_generations[index] == generation(id);
+    }
+
+    ///
+    /// \brief MoleculeIdAllocator::slotCount
+    /// \return
+    ///
+    /// the number of slots that have been used so far, all slot indices are below it
+    ///
+    size_t MoleculeIdAllocator::slotCount() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_generations.size();
+    }
+
+} // namespace molconv
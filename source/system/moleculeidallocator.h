@@ -0,0 +1,77 @@
+/*
+ * Copyright 2014 - 2019 Jan von Cosel & Sebastian Lenz
+ *
+ * This file is part of molconv.
+ *
+ * molconv is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * molconv is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have recieved a copy of the GNU General Public License
+ * along with molconv. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#ifndef MOLECULEIDALLOCATOR_H
+#define MOLECULEIDALLOCATOR_H
+
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace molconv
+{
+    ///
+    /// \brief The MoleculeIdAllocator class
+    ///
+    /// hands out the IDs of the molecules in the system. An ID consists of a slot
+    /// index in its lower 32 bits and the generation of that slot in the upper
+    /// 32 bits. Released slots are reused with the next generation, so that an
+    /// ID is never handed out twice, and the slot index can be used directly as
+    /// an index into the storage of the system. The IDs only depend on the order
+    /// of the allocations and releases, so that runs are reproducible. All
+    /// methods may be called from several threads at once.
+    ///
+    class MoleculeIdAllocator
+    {
+    public:
+        // no valid ID has generation zero:
+        static const unsigned long kInvalidId = 0;
+
+        MoleculeIdAllocator();
+
+        unsigned long allocate();
+        bool release(const unsigned long id);
+        bool isAllocated(const unsigned long id) const;
+        size_t slotCount() const;
+
+        static size_t slot(const unsigned long id)
+        {
+            return size_t(id & 0xffffffffUL);
+        }
+
+        static uint32_t generation(const unsigned long id)
+        {
+            return uint32_t(id >> 32);
+        }
+
+    private:
+        mutable std::mutex m_mutex;
+
+        // the generation of the last ID of every slot, whether that ID is in use
+        // and the slots that can be reused:
+        std::vector<uint32_t> m_generations;
+        std::vector<bool> m_inUse;
+        std::vector<uint32_t> m_freeSlots;
+    };
+
+} // namespace molconv
+
+#endif // MOLECULEIDALLOCATOR_H
@@ -0,0 +1,97 @@
+/*
+ * Copyright 2014 - 2019 Jan von Cosel & Sebastian Lenz
+ *
+ * This file is part of molconv.
+ *
+ * molconv is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * molconv is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have recieved a copy of the GNU General Public License
+ * along with molconv. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#ifndef PARALLELFOR_H
+#define PARALLELFOR_H
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include "threadpool.h"
+
+namespace molconv {
+
+///
+/// \brief parallelFor
+/// \param count
+/// \param body
+/// \param grain
+///
+/// call \p body(i) for every i in [0, count) on the calling thread and the
+/// workers of the global ThreadPool, which are started once and reused by
+/// every call. The indices are handed out in chunks of \p grain, so that
+/// cheap bodies don't spend their time fighting over the counter. Small
+/// ranges are run on the calling thread. The first exception thrown by
+/// \p body is rethrown after all workers have finished.
+///
+template<typename Function>
+void parallelFor(const size_t count, Function body, const size_t grain = 1)
+{
+    const size_t chunk = std::max(grain, size_t(1));
+    const size_t nChunks = (count + chunk - 1) / chunk;
+
+    // the calling thread works as well, so a single chunk needs no workers:
+    const size_t nWorkers = nChunks > 1 ? std::min(ThreadPool::global().size(), nChunks - 1) : 0;
+
+    if (nWorkers == 0)
+    {
+        for (size_t i = 0; i < count; i++)
+            body(i);
+
+        return;
+    }
+
+    std::atomic<size_t> next(0);
+    std::exception_ptr error;
+    std::mutex errorMutex;
+
+    auto worker = [&]()
+    {
+        try
+        {
+            for (size_t begin = next.fetch_add(chunk); begin < count; begin = next.fetch_add(chunk))
+            {
+                const size_t end = std::min(begin + chunk, count);
+                for (size_t i = begin; i < end; i++)
+                    body(i);
+            }
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> lock(errorMutex);
+            if (!error)
+                error = std::current_exception();
+
+            // stop handing out further work:
+            next.store(count);
+        }
+    };
+
+    ThreadPool::global().run(worker, nWorkers);
+
+    if (error)
+        std::rethrow_exception(error);
+}
+
+} // namespace molconv
+
+#endif // PARALLELFOR_H
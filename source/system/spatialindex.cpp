@@ -0,0 +1,447 @@
+/*
+ * Copyright 2014 - 2019 Jan von Cosel & Sebastian Lenz
+ *
+ * This file is part of molconv.
+ *
+ * molconv is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * molconv is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have recieved a copy of the GNU General Public License
+ * along with molconv. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include "molecule.h"
+#include "moleculebasis.h"
+#include "system.h"
+#include "spatialindex.h"
+
+
+namespace molconv
+{
+    SpatialIndex::SpatialIndex(const double atomCellSize, const double moleculeCellSize)
+        : m_atomCellSize(atomCellSize)
+        , m_moleculeCellSize(moleculeCellSize)
+        , m_maxRadius(0.0)
+        , m_nAtoms(0)
+    {
+    }
+
+    ///
+    /// \brief SpatialIndex::update
+    ///
+    /// bring the index up to date with the molecules in the system: new molecules
+    /// are added, removed ones are dropped and changed ones are updated. Molecules
+    /// that did not change since the last update cost almost nothing.
+    ///
+    void SpatialIndex::update()
+    {
+        const System &system = System::get();
+
+        for (size_t i = m_entries.size(); i > 0; i--)
+        {
+            if (!system.hasMolecule(m_entries[i - 1].molId))
+                removeMolecule(m_entries[i - 1].molId);
+        }
+
+        for (auto const& molecule : system.molecules())
+            updateMolecule(molecule);
+    }
+
+    ///
+    /// \brief SpatialIndex::updateMolecule
+    /// \param molecule
+    ///
+    /// add \p molecule to the index or update it. If it was only moved rigidly,
+    /// only its pose is updated, otherwise its atom grid is rebuilt.
+    ///
+    void SpatialIndex::updateMolecule(const moleculePtr &molecule)
+    {
+        const unsigned long id = molecule->molId();
+
+        // the coordinates are gathered first, this may start a new generation:
+        molecule->positions();
+
+        if (!hasMolecule(id))
+        {
+            const size_t slot = MoleculeIdAllocator::slot(id);
+            if (slot >= m_slots.size())
+                m_slots.resize(slot + 1, size_t(-1));
+
+            m_slots[slot] = m_entries.size();
+            m_entries.push_back(Entry());
+
+            Entry &newEntry = m_entries.back();
+            newEntry.molId = id;
+            buildShape(newEntry, *molecule);
+            updatePose(newEntry, *molecule);
+            m_nAtoms += size_t(newEntry.local.cols());
+
+            newEntry.moleculeCell = moleculeCellKey(newEntry.center);
+            insertIntoCell(m_entries.size() - 1);
+            return;
+        }
+
+        const size_t index = m_slots[MoleculeIdAllocator::slot(id)];
+        Entry &current = m_entries[index];
+
+        if (current.shapeGeneration != molecule->shapeGeneration())
+        {
+            m_nAtoms -= size_t(current.local.cols());
+            buildShape(current, *molecule);
+            m_nAtoms += size_t(current.local.cols());
+        }
+        else if (current.coordinateGeneration == molecule->coordinateGeneration())
+            return;
+
+        updatePose(current, *molecule);
+        moveToCell(index);
+    }
+
+    void SpatialIndex::removeMolecule(const unsigned long molId)
+    {
+        if (!hasMolecule(molId))
+            return;
+
+        const size_t index = m_slots[MoleculeIdAllocator::slot(molId)];
+        removeFromCell(index);
+        m_nAtoms -= size_t(m_entries[index].local.cols());
+        m_slots[MoleculeIdAllocator::slot(molId)] = size_t(-1);
+
+        // the last entry takes the place of the removed one:
+        const size_t last = m_entries.size() - 1;
+        if (index != last)
+        {
+            removeFromCell(last);
+            m_entries[index] = std::move(m_entries[last]);
+            m_slots[MoleculeIdAllocator::slot(m_entries[index].molId)] = index;
+            m_entries.pop_back();
+            insertIntoCell(index);
+        }
+        else
+            m_entries.pop_back();
+    }
+
+    void SpatialIndex::clear()
+    {
+        m_entries.clear();
+        m_slots.clear();
+        m_moleculeCells.clear();
+        m_maxRadius = 0.0;
+        m_nAtoms = 0;
+    }
+
+    size_t SpatialIndex::nMolecules() const
+    {
+        return m_entries.size();
+    }
+
+    size_t SpatialIndex::nAtoms() const
+    {
+        return m_nAtoms;
+    }
+
+    bool SpatialIndex::hasMolecule(const unsigned long molId) const
+    {
+        const size_t slot = MoleculeIdAllocator::slot(molId);
+        return slot < m_slots.size() && m_slots[slot] < m_entries.size() && m_entries[m_slots[slot]].molId == molId;
+    }
+
+    Eigen::Vector3d SpatialIndex::sphereCenter(const unsigned long molId) const
+    {
+        return entry(molId)->center;
+    }
+
+    double SpatialIndex::sphereRadius(const unsigned long molId) const
+    {
+        return entry(molId)->radius;
+    }
+
+    Eigen::Vector3d SpatialIndex::atomPosition(const unsigned long molId, const size_t atom) const
+    {
+        const Entry *current = entry(molId);
+        return current->rotation * current->local.col(atom) + current->translation;
+    }
+
+    ///
+    /// \brief SpatialIndex::moleculesWithin
+    /// \param point
+    /// \param radius
+    /// \param excludeMolId
+    /// \return
+    ///
+    /// the molecules whose bounding spheres reach within \p radius of \p point
+    ///
+    std::vector<unsigned long> SpatialIndex::moleculesWithin(const Eigen::Vector3d &point, const double radius, const unsigned long excludeMolId) const
+    {
+        std::vector<unsigned long> result;
+
+        auto test = [&](const size_t index)
+        {
+            const Entry &current = m_entries[index];
+            const double reach = radius + current.radius;
+
+            if (current.molId != excludeMolId && (current.center - point).squaredNorm() <= reach * reach)
+                result.push_back(current.molId);
+        };
+
+        // every sphere that can reach the point has its center within this range:
+        const double range = radius + m_maxRadius;
+        std::array<int64_t,3> lower, upper;
+        int64_t nCells = 1;
+        for (int k = 0; k < 3; k++)
+        {
+            lower[k] = int64_t(std::floor((point(k) - range) / m_moleculeCellSize));
+            upper[k] = int64_t(std::floor((point(k) + range) / m_moleculeCellSize));
+            nCells *= upper[k] - lower[k] + 1;
+        }
+
+        // for large ranges it is cheaper to look at all occupied cells:
+        if (nCells > int64_t(m_moleculeCells.size()))
+        {
+            for (size_t i = 0; i < m_entries.size(); i++)
+                test(i);
+
+            return result;
+        }
+
+        for (int64_t z = lower[2]; z <= upper[2]; z++)
+        {
+            for (int64_t y = lower[1]; y <= upper[1]; y++)
+            {
+                for (int64_t x = lower[0]; x <= upper[0]; x++)
+                {
+                    const Eigen::Vector3d cellPoint = (Eigen::Vector3d(double(x), double(y), double(z)).array() + 0.5).matrix() * m_moleculeCellSize;
+                    auto cell = m_moleculeCells.find(moleculeCellKey(cellPoint));
+                    if (cell == m_moleculeCells.end())
+                        continue;
+
+                    for (auto index : cell->second)
+                        test(index);
+                }
+            }
+        }
+
+        return result;
+    }
+
+    ///
+    /// \brief SpatialIndex::radiusSearch
+    /// \param point
+    /// \param radius
+    /// \param excludeMolId
+    /// \return
+    ///
+    /// all atoms within \p radius of \p point, in no particular order. The atoms of
+    /// the molecule \p excludeMolId are skipped.
+    ///
+    std::vector<SpatialIndex::Neighbor> SpatialIndex::radiusSearch(const Eigen::Vector3d &point, const double radius, const unsigned long excludeMolId) const
+    {
+        std::vector<Neighbor> result;
+
+        for (auto const& id : moleculesWithin(point, radius, excludeMolId))
+            searchEntry(*entry(id), point, radius, result);
+
+        return result;
+    }
+
+    ///
+    /// \brief SpatialIndex::searchMolecule
+    /// \param molId
+    /// \param point
+    /// \param radius
+    /// \return
+    ///
+    /// the atoms of the molecule \p molId within \p radius of \p point
+    ///
+    std::vector<SpatialIndex::Neighbor> SpatialIndex::searchMolecule(const unsigned long molId, const Eigen::Vector3d &point, const double radius) const
+    {
+        std::vector<Neighbor> result;
+        searchEntry(*entry(molId), point, radius, result);
+
+        return result;
+    }
+
+    ///
+    /// \brief SpatialIndex::nearest
+    /// \param point
+    /// \param k
+    /// \param excludeMolId
+    /// \return
+    ///
+    /// the \p k atoms nearest to \p point, sorted by their distance. The search
+    /// radius is doubled until enough atoms are found.
+    ///
+    std::vector<SpatialIndex::Neighbor> SpatialIndex::nearest(const Eigen::Vector3d &point, const size_t k, const unsigned long excludeMolId) const
+    {
+        std::vector<Neighbor> result;
+        if (k == 0 || m_entries.empty())
+            return result;
+
+        // no atom is farther away than this:
+        double maximum = 0.0;
+        for (auto const& current : m_entries)
+            maximum = std::max(maximum, (current.center - point).norm() + current.radius);
+
+        for (double radius = m_atomCellSize; ; radius *= 2.0)
+        {
+            result = radiusSearch(point, std::min(radius, maximum), excludeMolId);
+            if (result.size() >= k || radius >= maximum)
+                break;
+        }
+
+        auto closer = [](const Neighbor &a, const Neighbor &b) { return a.distance < b.distance; };
+        if (result.size() > k)
+        {
+            std::partial_sort(result.begin(), result.begin() + std::ptrdiff_t(k), result.end(), closer);
+            result.resize(k);
+        }
+        else
+            std::sort(result.begin(), result.end(), closer);
+
+        return result;
+    }
+
+    const SpatialIndex::Entry *SpatialIndex::entry(const unsigned long molId) const
+    {
+        if (!hasMolecule(molId))
+            throw std::out_of_range("molecule not in the spatial index.\n");
+
+        return &m_entries[m_slots[MoleculeIdAllocator::slot(molId)]];
+    }
+
+    ///
+    /// \brief SpatialIndex::buildShape
+    /// \param entry
+    /// \param molecule
+    ///
+    /// take the atoms into the internal frame of the molecule and sort them into
+    /// cells. The cells are enlarged for sparse molecules, so that there are
+    /// never many more cells than atoms.
+    ///
+    void SpatialIndex::buildShape(Entry &entry, const Molecule &molecule) const
+    {
+        const Eigen::Matrix3d rotation = molecule.basis() ? molecule.basisVectors() : Eigen::Matrix3d::Identity();
+        const Eigen::Vector3d translation = molecule.origin() ? molecule.originPosition() : Eigen::Vector3d::Zero();
+        const size_t nAtoms = molecule.size();
+
+        entry.shapeGeneration = molecule.shapeGeneration();
+        entry.local.noalias() = rotation.transpose() * (molecule.positions().colwise() - translation);
+        entry.grid.build(entry.local, m_atomCellSize);
+
+        if (nAtoms == 0)
+        {
+            entry.localCenter.setZero();
+            entry.radius = 0.0;
+            return;
+        }
+
+        const Eigen::Vector3d lower = entry.local.rowwise().minCoeff();
+        const Eigen::Vector3d upper = entry.local.rowwise().maxCoeff();
+        entry.localCenter = 0.5 * (lower + upper);
+        entry.radius = (entry.local.colwise() - entry.localCenter).colwise().norm().maxCoeff();
+    }
+
+    ///
+    /// \brief SpatialIndex::updatePose
+    /// \param entry
+    /// \param molecule
+    ///
+    /// take the current position and orientation of the internal frame of the
+    /// molecule and move its bounding sphere along. The largest sphere radius is
+    /// only reset by clear().
+    ///
+    void SpatialIndex::updatePose(Entry &entry, const Molecule &molecule)
+    {
+        entry.coordinateGeneration = molecule.coordinateGeneration();
+        entry.rotation = molecule.basis() ? molecule.basisVectors() : Eigen::Matrix3d::Identity();
+        entry.translation = molecule.origin() ? molecule.originPosition() : Eigen::Vector3d::Zero();
+        entry.center = entry.rotation * entry.localCenter + entry.translation;
+        m_maxRadius = std::max(m_maxRadius, entry.radius);
+    }
+
+    void SpatialIndex::moveToCell(const size_t index)
+    {
+        const uint64_t key = moleculeCellKey(m_entries[index].center);
+        if (key == m_entries[index].moleculeCell)
+            return;
+
+        removeFromCell(index);
+        m_entries[index].moleculeCell = key;
+        insertIntoCell(index);
+    }
+
+    uint64_t SpatialIndex::moleculeCellKey(const Eigen::Vector3d &position) const
+    {
+        // 21 bits per dimension, centered at zero:
+        uint64_t key = 0;
+        for (int k = 0; k < 3; k++)
+        {
+            const int64_t cell = int64_t(std::floor(position(k) / m_moleculeCellSize)) + (int64_t(1) << 20);
+            key = (key << 21) | (uint64_t(std::min(std::max(cell, int64_t(0)), (int64_t(1) << 21) - 1)));
+        }
+
+        return key;
+    }
+
+    void SpatialIndex::insertIntoCell(const size_t index)
+    {
+        m_moleculeCells[m_entries[index].moleculeCell].push_back(index);
+    }
+
+    void SpatialIndex::removeFromCell(const size_t index)
+    {
+        auto cell = m_moleculeCells.find(m_entries[index].moleculeCell);
+        if (cell == m_moleculeCells.end())
+            return;
+
+        std::vector<size_t> &members = cell->second;
+        auto member = std::find(members.begin(), members.end(), index);
+        if (member != members.end())
+        {
+            *member = members.back();
+            members.pop_back();
+        }
+
+        if (members.empty())
+            m_moleculeCells.erase(cell);
+    }
+
+    ///
+    /// \brief SpatialIndex::searchEntry
+    /// \param entry
+    /// \param point
+    /// \param radius
+    /// \param result
+    ///
+    /// add the atoms of a single molecule within \p radius of \p point to \p result
+    ///
+    void SpatialIndex::searchEntry(const Entry &entry, const Eigen::Vector3d &point, const double radius, std::vector<Neighbor> &result) const
+    {
+        const Eigen::Vector3d local = entry.rotation.transpose() * (point - entry.translation);
+        const double radiusSquared = radius * radius;
+
+        entry.grid.forEachNear(local, radius, [&](const size_t atom)
+        {
+            const double distanceSquared = (entry.local.col(atom) - local).squaredNorm();
+
+            if (distanceSquared <= radiusSquared)
+            {
+                Neighbor neighbor = {entry.molId, atom, std::sqrt(distanceSquared)};
+                result.push_back(neighbor);
+            }
+        });
+    }
+
+} // namespace molconv
@@ -0,0 +1,123 @@
+/*
+ * Copyright 2014 - 2019 Jan von Cosel & Sebastian Lenz
+ *
+ * This file is part of molconv.
+ *
+ * molconv is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * molconv is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have recieved a copy of the GNU General Public License
+ * along with molconv. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#ifndef SPATIALINDEX_H
+#define SPATIALINDEX_H
+
+#include<array>
+#include<cstdint>
+#include<unordered_map>
+#include<vector>
+#include<Eigen/Core>
+#include "cellgrid.h"
+#include "moleculeidallocator.h"
+#include "types.h"
+
+namespace molconv
+{
+    ///
+    /// \brief The SpatialIndex class
+    ///
+    /// finds the atoms of all molecules in the system that lie near a given point.
+    /// It has two levels: every molecule keeps its atoms in a uniform grid of cells
+    /// in its own internal frame, together with a bounding sphere, and the centers
+    /// of the bounding spheres are kept in a hashed grid in the global frame. A
+    /// rigid move of a molecule therefore only updates its pose and the cell of its
+    /// sphere, the atom grid is only rebuilt when the shape of the molecule changes.
+    /// Distances are calculated in the frame of each molecule, which works because
+    /// the internal bases are orthonormal.
+    ///
+    class SpatialIndex
+    {
+    public:
+        struct Neighbor
+        {
+            unsigned long molId;
+            size_t atom;
+            double distance;
+        };
+
+        SpatialIndex(const double atomCellSize = 3.0, const double moleculeCellSize = 12.0);
+
+        void update();
+        void updateMolecule(const moleculePtr &molecule);
+        void removeMolecule(const unsigned long molId);
+        void clear();
+
+        size_t nMolecules() const;
+        size_t nAtoms() const;
+        bool hasMolecule(const unsigned long molId) const;
+        Eigen::Vector3d sphereCenter(const unsigned long molId) const;
+        double sphereRadius(const unsigned long molId) const;
+        Eigen::Vector3d atomPosition(const unsigned long molId, const size_t atom) const;
+
+        std::vector<unsigned long> moleculesWithin(const Eigen::Vector3d &point, const double radius, const unsigned long excludeMolId = MoleculeIdAllocator::kInvalidId) const;
+        std::vector<Neighbor> radiusSearch(const Eigen::Vector3d &point, const double radius, const unsigned long excludeMolId = MoleculeIdAllocator::kInvalidId) const;
+        std::vector<Neighbor> searchMolecule(const unsigned long molId, const Eigen::Vector3d &point, const double radius) const;
+        std::vector<Neighbor> nearest(const Eigen::Vector3d &point, const size_t k, const unsigned long excludeMolId = MoleculeIdAllocator::kInvalidId) const;
+
+    private:
+        struct Entry
+        {
+            unsigned long molId;
+            unsigned long shapeGeneration;
+            unsigned long coordinateGeneration;
+
+            // the pose of the internal frame and the atoms in this frame:
+            Eigen::Matrix3d rotation;
+            Eigen::Vector3d translation;
+            Eigen::Matrix3Xd local;
+
+            // the bounding sphere, in the internal and in the global frame:
+            Eigen::Vector3d localCenter;
+            Eigen::Vector3d center;
+            double radius;
+            uint64_t moleculeCell;
+
+            // the atoms sorted into cells of the internal frame:
+            CellGrid grid;
+        };
+
+        const Entry *entry(const unsigned long molId) const;
+        void buildShape(Entry &entry, const Molecule &molecule) const;
+        void updatePose(Entry &entry, const Molecule &molecule);
+        void moveToCell(const size_t index);
+        uint64_t moleculeCellKey(const Eigen::Vector3d &position) const;
+        void insertIntoCell(const size_t index);
+        void removeFromCell(const size_t index);
+        void searchEntry(const Entry &entry, const Eigen::Vector3d &point, const double radius, std::vector<Neighbor> &result) const;
+
+        double m_atomCellSize;
+        double m_moleculeCellSize;
+
+        // the entries are stored densely, m_slots gives their position from the slot of the ID:
+        std::vector<Entry> m_entries;
+        std::vector<size_t> m_slots;
+
+        // the entries whose sphere centers lie in each cell, and the largest sphere:
+        std::unordered_map<uint64_t, std::vector<size_t>> m_moleculeCells;
+        double m_maxRadius;
+        size_t m_nAtoms;
+    };
+
+} // namespace molconv
+
+#endif // SPATIALINDEX_H
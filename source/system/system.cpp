@@ -19,16 +19,202 @@
  */
 
 
+#include <cmath>
 #include <stdexcept>
 #include <algorithm>
+#include <utility>
 #include <Eigen/Eigenvalues>
 #include <boost/make_shared.hpp>
 #include "moleculebasis.h"
+#include "parallelfor.h"
 #include "system.h"
 
 
 namespace molconv
 {
+    namespace
+    {
+        ///
+        /// \brief quaternionMatrix
+        /// \param corr
+        /// \return
+        ///
+        /// construct the symmetric 4x4 quaternion matrix from the correlation matrix
+        /// \p corr of two centered sets of coordinates. Its largest eigenvalue and
+        /// the corresponding eigenvector give the optimal superposition.
+        ///
+        Eigen::Matrix4d quaternionMatrix(const Eigen::Matrix3d &corr)
+        {
+            Eigen::Matrix4d F = Eigen::Matrix4d::Zero();
+            F(0,0) =  corr(0,0) + corr(1,1) + corr(2,2);
+            F(1,1) =  corr(0,0) - corr(1,1) - corr(2,2);
+            F(2,2) = -corr(0,0) + corr(1,1) - corr(2,2);
+            F(3,3) = -corr(0,0) - corr(1,1) + corr(2,2);
+            F(0,1) =  corr(1,2) - corr(2,1);
+            F(0,2) =  corr(2,0) - corr(0,2);
+            F(0,3) =  corr(0,1) - corr(1,0);
+            F(1,2) =  corr(0,1) + corr(1,0);
+            F(1,3) =  corr(0,2) + corr(2,0);
+            F(2,3) =  corr(1,2) + corr(2,1);
+            F(1,0) = F(0,1);
+            F(2,0) = F(0,2);
+            F(3,0) = F(0,3);
+            F(2,1) = F(1,2);
+            F(3,1) = F(1,3);
+            F(3,2) = F(2,3);
+
+            return F;
+        }
+
+        ///
+        /// \brief superposedRMSD
+        /// \param corr
+        /// \param innerProducts
+        /// \param nAtoms
+        /// \return
+        ///
+        /// calculate the RMSD after optimal superposition with the QCP method given in
+        /// Acta Cryst. A61, 478 (2005). Only the largest eigenvalue of the quaternion
+        /// matrix is needed, and it is found by Newton iteration on the characteristic
+        /// polynomial, starting from its upper bound, half the sum of the inner products.
+        ///
+        double superposedRMSD(const Eigen::Matrix3d &corr, const double innerProducts, const size_t nAtoms)
+        {
+            // the quaternion matrix is traceless, so the cubic term of the polynomial vanishes
+            const double c2 = -2.0 * corr.squaredNorm();
+            const double c1 = -8.0 * corr.determinant();
+            const double c0 = quaternionMatrix(corr).determinant();
+
+            double lambda = 0.5 * innerProducts;
+            for (int i = 0; i < 50; i++)
+            {
+                const double lambda2 = lambda * lambda;
+                const double P = (lambda2 + c2) * lambda2 + c1 * lambda + c0;
+                const double dP = (4.0 * lambda2 + 2.0 * c2) * lambda + c1;
+
+                if (dP == 0.0)
+                    break;
+
+                const double step = P / dP;
+                lambda -= step;
+
+                if (std::abs(step) < 1.0e-11 * std::abs(lambda))
+                    break;
+            }
+
+            return std::sqrt(std::max(0.0, (innerProducts - 2.0 * lambda) / double(nAtoms)));
+        }
+
+        ///
+        /// \brief superposedRMSDMatrix
+        /// \param centered
+        /// \return
+        ///
+        /// the RMSD after optimal superposition between all pairs of the coordinate
+        /// sets in \p centered, which have to be relative to their center of geometry.
+        /// Pairs with different numbers of atoms are set to -1. The matrix is split
+        /// into square tiles which are distributed over all cores.
+        ///
+        Eigen::MatrixXd superposedRMSDMatrix(const std::vector<Eigen::Matrix3Xd> &centered)
+        {
+            const size_t nMols = centered.size();
+            const size_t tileSize = 32;
+
+            std::vector<double> innerProducts(nMols);
+            for (size_t i = 0; i < nMols; i++)
+                innerProducts[i] = centered[i].squaredNorm();
+
+            std::vector<std::pair<size_t,size_t>> tiles;
+            const size_t nTiles = (nMols + tileSize - 1) / tileSize;
+            for (size_t i = 0; i < nTiles; i++)
+                for (size_t j = i; j < nTiles; j++)
+                    tiles.push_back(std::make_pair(i, j));
+
+            Eigen::MatrixXd result = Eigen::MatrixXd::Zero(nMols, nMols);
+
+            parallelFor(tiles.size(), [&](const size_t t)
+            {
+                const size_t rowBegin = tiles[t].first * tileSize;
+                const size_t colBegin = tiles[t].second * tileSize;
+                const size_t rowEnd = std::min(rowBegin + tileSize, nMols);
+                const size_t colEnd = std::min(colBegin + tileSize, nMols);
+
+                for (size_t i = rowBegin; i < rowEnd; i++)
+                {
+                    for (size_t j = std::max(colBegin, i + 1); j < colEnd; j++)
+                    {
+                        double rmsd = -1.0;
+
+                        if (centered[i].cols() == centered[j].cols())
+                        {
+                            Eigen::Matrix3d corr = centered[j] * centered[i].transpose();
+                            rmsd = superposedRMSD(corr, innerProducts[i] + innerProducts[j], size_t(centered[i].cols()));
+                        }
+
+                        result(i,j) = rmsd;
+                        result(j,i) = rmsd;
+                    }
+                }
+            });
+
+            return result;
+        }
+
+        ///
+        /// \brief The AlignmentSnapshot struct
+        ///
+        /// a read-only copy of the data of a molecule that is needed to align it:
+        /// the coordinates relative to the center of geometry, that center itself
+        /// and the current position and orientation of the internal basis
+        ///
+        struct AlignmentSnapshot
+        {
+            AlignmentSnapshot()
+            {
+            }
+
+            AlignmentSnapshot(const Molecule &molecule)
+                : center(molecule.center())
+                , origin(molecule.originPosition())
+                , axes(molecule.basisVectors())
+            {
+                positions = molecule.positions().colwise() - center;
+            }
+
+            Eigen::Matrix3Xd positions;
+            Eigen::Vector3d center;
+            Eigen::Vector3d origin;
+            Eigen::Matrix3d axes;
+        };
+
+        ///
+        /// \brief alignmentPose
+        /// \param reference
+        /// \param other
+        /// \param pose
+        /// \return
+        ///
+        /// calculate the pose that superimposes \p other onto \p reference and store it
+        /// in \p pose. The optimal rotation is the eigenvector to the largest eigenvalue
+        /// of the quaternion matrix. Returns the residual RMSD after the superposition.
+        ///
+        double alignmentPose(const AlignmentSnapshot &reference, const AlignmentSnapshot &other, MoleculePose &pose)
+        {
+            Eigen::Matrix3d corr = other.positions * reference.positions.transpose();
+
+            Eigen::SelfAdjointEigenSolver<Eigen::Matrix4d> Feig(quaternionMatrix(corr));
+            Eigen::Vector4d lQuart = Feig.eigenvectors().col(3);
+            Eigen::Matrix3d rotation = Eigen::Quaterniond(lQuart(0), lQuart(1), lQuart(2), lQuart(3)).toRotationMatrix();
+
+            // rotate the molecule about its center and move that center onto the reference:
+            pose.position = rotation * (other.origin - other.center) + reference.center;
+            pose.rotation = rotation * other.axes;
+
+            double innerProducts = reference.positions.squaredNorm() + other.positions.squaredNorm();
+            return std::sqrt(std::max(0.0, (innerProducts - 2.0 * double(Feig.eigenvalues()(3))) / double(other.positions.cols())));
+        }
+    }
+
     ///
     /// \brief System::System
     ///
@@ -71,7 +257,13 @@ namespace molconv
     ///
     moleculePtr System::getMolecule(const unsigned long index) const
     {
-        return m_molecules.at(index);
+        return m_molecules[denseIndex(index)];
+    }
+
+    bool System::hasMolecule(const unsigned long key) const
+    {
+        const size_t slot = MoleculeIdAllocator::slot(key);
+        return slot < m_slots.size() && m_slots[slot] < m_molIDs.size() && m_molIDs[m_slots[slot]] == key;
     }
 
     ///
@@ -96,17 +288,14 @@ namespace molconv
     ///
     /// returns the position of the molecule in the vector
     ///
-    size_t System::MoleculeIndex(const moleculePtr theMolecule)
+    size_t System::MoleculeIndex(const moleculePtr theMolecule) const
     {
-        size_t index = 0;
-
-        for (size_t i = 0; i < nMolecules(); i++)
-        {
-            if (getMolecule(i) == theMolecule)
-                index = i;
-        }
+        return MoleculeIndex(theMolecule->molId());
+    }
 
-        return index;
+    size_t System::MoleculeIndex(const unsigned long key) const
+    {
+        return denseIndex(key);
     }
 
     ///
@@ -133,22 +322,51 @@ namespace molconv
     /// \brief System::addMolecule
     /// \param newMolecule
     ///
-    /// adds a new molecule \p newMolecule to the system
+    /// adds a new molecule \p newMolecule to the system and gives it a new ID.
+    /// Adding a molecule that is already in the system does nothing.
     ///
     void System::addMolecule(const moleculePtr newMolecule)
     {
-        m_molecules.insert(std::make_pair(newMolecule->molId(), newMolecule));
+        if (hasMolecule(newMolecule->molId()))
+            return;
+
+        const unsigned long id = m_idAllocator.allocate();
+        const size_t slot = MoleculeIdAllocator::slot(id);
+        newMolecule->setMolId(id);
+
+        if (slot >= m_slots.size())
+            m_slots.resize(slot + 1, size_t(-1));
+
+        m_slots[slot] = m_molecules.size();
+        m_molecules.push_back(newMolecule);
+        m_molIDs.push_back(id);
     }
 
     ///
     /// \brief System::removeMolecule
     /// \param index
     ///
-    /// removes the molecule at index \p index
+    /// removes the molecule at index \p index. The last molecule takes its
+    /// place, so that the storage stays dense.
     ///
     void System::removeMolecule(const unsigned long key)
     {
-        m_molecules.erase(key);
+        if (!hasMolecule(key))
+            return;
+
+        const size_t index = m_slots[MoleculeIdAllocator::slot(key)];
+        m_slots[MoleculeIdAllocator::slot(key)] = size_t(-1);
+        m_idAllocator.release(key);
+
+        if (index + 1 < m_molecules.size())
+        {
+            m_molecules[index] = std::move(m_molecules.back());
+            m_molIDs[index] = m_molIDs.back();
+            m_slots[MoleculeIdAllocator::slot(m_molIDs[index])] = index;
+        }
+
+        m_molecules.pop_back();
+        m_molIDs.pop_back();
     }
 
     ///
@@ -176,16 +394,35 @@ namespace molconv
 //        m_groups.erase(m_groups.begin() + index);
 //    }
 
-    std::vector<unsigned long> System::getMolIDs() const
+    ///
+    /// \brief System::denseIndex
+    /// \param key
+    /// \return
+    ///
+    /// the position of the molecule with the ID \p key in the dense storage
+    ///
+    size_t System::denseIndex(const unsigned long key) const
     {
-        std::vector<unsigned long> result;
+        if (!hasMolecule(key))
+            throw std::out_of_range("no molecule with this ID.\n");
 
-        for (auto const& element : m_molecules)
-        {
-            result.push_back(element.first);
-        }
+        return m_slots[MoleculeIdAllocator::slot(key)];
+    }
 
-        return result;
+    ///
+    /// \brief System::getMolIDs
+    /// \return
+    ///
+    /// the IDs of all molecules, in the same order as molecules()
+    ///
+    const std::vector<unsigned long> &System::getMolIDs() const
+    {
+        return m_molIDs;
+    }
+
+    const std::vector<moleculePtr> &System::molecules() const
+    {
+        return m_molecules;
     }
 
     ///
@@ -216,24 +453,65 @@ namespace molconv
             return -1.0;
         }
 
-        double rmsd = 0.0;
-
-        for (int i = 0; i < int(refMolPtr->size()); i++)
-        {
-            for (int j = 0; j < 3; j++)
-            {
-                rmsd += std::abs(double(otherMolPtr->atom(i)->position()(j))
-                                 - double(refMolPtr->atom(i)->position()(j)))
-                      * std::abs(double(otherMolPtr->atom(i)->position()(j))
-                                 - double(refMolPtr->atom(i)->position()(j)));
-            }
-        }
+        double rmsd = (otherMolPtr->positions() - refMolPtr->positions()).squaredNorm();
         rmsd /= double(refMolPtr->size());
         rmsd = std::sqrt(rmsd);
 
         return rmsd;
     }
 
+    ///
+    /// \brief System::rmsdMatrix
+    /// \param molIDs
+    /// \return
+    ///
+    /// calculate the RMSD between all pairs of the molecules in \p molIDs after optimal
+    /// superposition of their centers of geometry and orientations. The molecules are
+    /// not moved. Element (i,j) of the symmetric result belongs to the molecules
+    /// molIDs[i] and molIDs[j], pairs with different numbers of atoms are set to -1.
+    ///
+    Eigen::MatrixXd System::rmsdMatrix(const std::vector<unsigned long> &molIDs) const
+    {
+        const size_t nMols = molIDs.size();
+
+        std::vector<Molecule *> molecules;
+        molecules.reserve(nMols);
+        for (auto const& id : molIDs)
+            molecules.push_back(getMolecule(id).get());
+
+        // take centered copies of the coordinates once, so that each pair only
+        // needs one 3xN by Nx3 product:
+        std::vector<Eigen::Matrix3Xd> centered(nMols);
+        parallelFor(nMols, [&](const size_t i)
+        {
+            centered[i] = molecules[i]->positions().colwise() - molecules[i]->center();
+        });
+
+        return superposedRMSDMatrix(centered);
+    }
+
+    ///
+    /// \brief System::rmsdMatrix
+    /// \param snapshot
+    /// \param molIDs
+    /// \return
+    ///
+    /// the same as above, but for the molecules as they were when \p snapshot was
+    /// published. Only the snapshot is read, so this can be called from any thread.
+    ///
+    Eigen::MatrixXd System::rmsdMatrix(const SystemSnapshot &snapshot, const std::vector<unsigned long> &molIDs)
+    {
+        std::vector<Eigen::Matrix3Xd> centered(molIDs.size());
+        for (size_t i = 0; i < molIDs.size(); i++)
+        {
+            const Eigen::Matrix3Xd &positions = *snapshot.molecule(molIDs[i]).positions;
+            if (positions.cols() > 0)
+                centered[i] = positions.colwise() - positions.rowwise().mean();
+        }
+
+        return superposedRMSDMatrix(centered);
+    }
+
     ///
     /// \brief System::alignMolecules
     /// \param refMol
@@ -253,69 +531,184 @@ namespace molconv
             return false;
         }
 
-        int Natoms = refMolPtr->size();
+        AlignmentSnapshot reference(*refMolPtr);
+        MoleculePose pose;
+        alignmentPose(reference, AlignmentSnapshot(*otherMolPtr), pose);
+
+        otherMolPtr->moveTo(pose.position, pose.rotation);
+
+        return true;
+    }
+
+    ///
+    /// \brief System::alignMoleculesTo
+    /// \param refMol
+    /// \param otherMols
+    /// \return
+    ///
+    /// align all molecules in \p otherMols to the reference molecule \p refMol.
+    /// The optimal rotations are calculated in parallel from copies of the
+    /// coordinates, and the molecules are only moved afterwards in a single
+    /// call of moveMolecules. The residual RMSD of each molecule is returned
+    /// in the order of \p otherMols. Molecules whose number of atoms differs
+    /// from the reference are not moved, and their RMSD is set to -1.
+    ///
+    std::vector<double> System::alignMoleculesTo(const unsigned long refMol, const std::vector<unsigned long> &otherMols)
+    {
+        const size_t nOthers = otherMols.size();
+        AlignmentSnapshot reference(*getMolecule(refMol));
+
+        std::vector<Molecule *> others;
+        others.reserve(nOthers);
+        for (auto const& id : otherMols)
+            others.push_back(getMolecule(id).get());
+
+        std::vector<AlignmentSnapshot> snapshots(nOthers);
+        parallelFor(nOthers, [&](const size_t i)
+        {
+            snapshots[i] = AlignmentSnapshot(*others[i]);
+        });
 
-        Eigen::Vector3d center = refMolPtr->center();
-        Eigen::Vector3d shift = center - otherMolPtr->center();
-        Eigen::Vector3d newOrigin = otherMolPtr->originPosition() + shift;
+        std::vector<MoleculePose> poses(nOthers);
+        std::vector<double> rmsds(nOthers, -1.0);
 
-        otherMolPtr->moveFromParas(double(newOrigin(0)), double(newOrigin(1)), double(newOrigin(2)), 0.0, 0.0, 0.0);
+        parallelFor(nOthers, [&](const size_t i)
+        {
+            if (snapshots[i].positions.cols() == reference.positions.cols())
+            {
+                poses[i].molId = otherMols[i];
+                rmsds[i] = alignmentPose(reference, snapshots[i], poses[i]);
+            }
+        }, 4);
 
-        Eigen::MatrixXd Xr = Eigen::MatrixXd::Zero(3,Natoms);
-        Eigen::MatrixXd Xo = Eigen::MatrixXd::Zero(3,Natoms);
-        for (int i = 0; i < Natoms; i++)
+        std::vector<MoleculePose> validPoses;
+        validPoses.reserve(nOthers);
+        for (size_t i = 0; i < nOthers; i++)
         {
-            Xr.col(i) = refMolPtr->atom(i)->position() - center;
-            Xo.col(i) = otherMolPtr->atom(i)->position() - center;
+            if (rmsds[i] >= 0.0)
+                validPoses.push_back(poses[i]);
         }
 
-        Eigen::Matrix3d corr = Xo * Xr.transpose();
-
-        // construct the quaternion matrix
-        Eigen::Matrix4d F = Eigen::Matrix4d::Zero();
-        F(0,0) =  corr(0,0) + corr(1,1) + corr(2,2);
-        F(1,1) =  corr(0,0) - corr(1,1) - corr(2,2);
-        F(2,2) = -corr(0,0) + corr(1,1) - corr(2,2);
-        F(3,3) = -corr(0,0) - corr(1,1) + corr(2,2);
-        F(0,1) =  corr(1,2) - corr(2,1);
-        F(0,2) =  corr(2,0) - corr(0,2);
-        F(0,3) =  corr(0,1) - corr(1,0);
-        F(1,2) =  corr(0,1) + corr(1,0);
-        F(1,3) =  corr(0,2) + corr(2,0);
-        F(2,3) =  corr(1,2) + corr(2,1);
-        F(1,0) = F(0,1);
-        F(2,0) = F(0,2);
-        F(3,0) = F(0,3);
-        F(2,1) = F(1,2);
-        F(3,1) = F(1,3);
-        F(3,2) = F(2,3);
-
-        Eigen::SelfAdjointEigenSolver<Eigen::Matrix4d> Feig(F);
-        Eigen::Vector4d Feval = Feig.eigenvalues();
-        Eigen::Matrix4d Fevec = Feig.eigenvectors();
-
-        // the optimal rotation corresponds to either the first or the last eigenvector, depending on which eigenvalue is larger
-        Eigen::Vector4d lQuart = std::abs(double(Feval(0))) > std::abs(double(Feval(3))) ? Fevec.block(0, 0, 4, 1) : Fevec.block(0, 3, 4, 1);
-
-        Eigen::Matrix3d rotmat = Eigen::Matrix3d::Zero();
-        rotmat(0,0) = lQuart(0) * lQuart(0) + lQuart(1) * lQuart(1) - lQuart(2) * lQuart(2) - lQuart(3) * lQuart(3);
-        rotmat(1,1) = lQuart(0) * lQuart(0) - lQuart(1) * lQuart(1) + lQuart(2) * lQuart(2) - lQuart(3) * lQuart(3);
-        rotmat(2,2) = lQuart(0) * lQuart(0) - lQuart(1) * lQuart(1) - lQuart(2) * lQuart(2) + lQuart(3) * lQuart(3);
-        rotmat(0,1) = 2.0 * (lQuart(1) * lQuart(2) - lQuart(0) * lQuart(3));
-        rotmat(0,2) = 2.0 * (lQuart(1) * lQuart(3) + lQuart(0) * lQuart(2));
-        rotmat(1,2) = 2.0 * (lQuart(2) * lQuart(3) - lQuart(0) * lQuart(1));
-        rotmat(1,0) = 2.0 * (lQuart(1) * lQuart(2) + lQuart(0) * lQuart(3));
-        rotmat(2,0) = 2.0 * (lQuart(1) * lQuart(3) - lQuart(0) * lQuart(2));
-        rotmat(2,1) = 2.0 * (lQuart(2) * lQuart(3) + lQuart(0) * lQuart(1));
-
-        std::array<double,3> newEulers = molconv::MoleculeBasis::rot2euler(rotmat);
-        double newPhi = newEulers[2];
-        double newTheta = newEulers[1];
-        double newPsi = newEulers[0];
-
-        otherMolPtr->moveFromParas(double(newOrigin(0)), double(newOrigin(1)), double(newOrigin(2)), newPhi, newTheta, newPsi);
+        moveMolecules(validPoses);
 
-        return true;
+        return rmsds;
+    }
+
+    ///
+    /// \brief System::moveMolecules
+    /// \param poses
+    ///
+    /// move all molecules listed in \p poses to their new position and orientation.
+    /// The molecules are transformed in parallel, so each of them may appear only
+    /// once. All IDs and rotations are checked before anything is moved. The move callback is
+    /// invoked once with the IDs of all moved molecules after the batch is complete.
+    ///
+    void System::moveMolecules(const std::vector<MoleculePose> &poses)
+    {
+        std::vector<Molecule *> targets;
+        std::vector<unsigned long> movedIDs;
+        targets.reserve(poses.size());
+        movedIDs.reserve(poses.size());
+
+        for (auto const& pose : poses)
+        {
+            if (!Molecule::isRotation(pose.rotation))
+                throw std::invalid_argument("the rotation of a pose is not a proper rotation.\n");
+
+            targets.push_back(getMolecule(pose.molId).get());
+            movedIDs.push_back(pose.molId);
+        }
+
+        std::vector<unsigned long> sortedIDs = movedIDs;
+        std::sort(sortedIDs.begin(), sortedIDs.end());
+        if (std::adjacent_find(sortedIDs.begin(), sortedIDs.end()) != sortedIDs.end())
+            throw std::invalid_argument("molecule appears more than once in the list of poses.\n");
+
+        parallelFor(poses.size(), [&](const size_t i)
+        {
+            targets[i]->moveTo(poses[i].position, poses[i].rotation);
+        }, 8);
+
+        if (m_moveCallback && !movedIDs.empty())
+            m_moveCallback(movedIDs);
+    }
+
+    ///
+    /// \brief System::setMoveCallback
+    /// \param callback
+    ///
+    /// set the function that is notified after molecules have been moved by moveMolecules
+    ///
+    void System::setMoveCallback(const MoveCallback &callback)
+    {
+        m_moveCallback = callback;
+    }
+
+    ///
+    /// \brief System::publish
+    ///
+    /// make the current state of all molecules available to snapshot() as a new
+    /// version. Only molecules whose coordinates or basis changed since the last
+    /// version are copied, all others share the coordinate blocks of the last
+    /// version. Nothing is published if nothing changed. Like all changes to the
+    /// system, this must only be called from the thread that owns the molecules.
+    ///
+    void System::publish()
+    {
+        snapshotPtr previous = boost::atomic_load(&m_snapshot);
+
+        std::vector<MoleculeSnapshot> entries;
+        entries.reserve(m_molecules.size());
+
+        bool changed = !previous || previous->nMolecules() != m_molecules.size();
+
+        for (size_t i = 0; i < m_molecules.size(); i++)
+        {
+            const Molecule &molecule = *m_molecules[i];
+
+            // the coordinates are gathered first, this may start a new generation:
+            const Eigen::Matrix3Xd &positions = molecule.positions();
+            const unsigned long generation = molecule.coordinateGeneration();
+
+            if (previous && previous->hasMolecule(m_molIDs[i]) && previous->molecule(m_molIDs[i]).generation == generation)
+            {
+                entries.push_back(previous->molecule(m_molIDs[i]));
+                changed = changed || previous->molecules()[i].molId != m_molIDs[i];
+                continue;
+            }
+
+            MoleculeSnapshot entry;
+            entry.molId = m_molIDs[i];
+            entry.generation = generation;
+            entry.positions = boost::make_shared<const Eigen::Matrix3Xd>(positions);
+            entry.origin = molecule.originPosition();
+            entry.basis = molecule.basisVectors();
+            entries.push_back(entry);
+
+            changed = true;
+        }
+
+        if (!changed)
+            return;
+
+        snapshotPtr next = boost::make_shared<const SystemSnapshot>(++m_version, entries);
+        boost::atomic_store(&m_snapshot, next);
+    }
+
+    ///
+    /// \brief System::snapshot
+    /// \return
+    ///
+    /// the last published version of the system. It stays valid and unchanged
+    /// as long as it is held, and may be taken from any thread.
+    ///
+    snapshotPtr System::snapshot() const
+    {
+        snapshotPtr current = boost::atomic_load(&m_snapshot);
+        if (!current)
+            return boost::make_shared<const SystemSnapshot>();
+
+        return current;
     }
 
 } // namespace molconv
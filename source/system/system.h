@@ -23,18 +23,36 @@
 #define SYSTEM_H
 
 #include<vector>
+#include<functional>
 #include<QAbstractItemModel>
 #include<boost/shared_ptr.hpp>
 #include<boost/scoped_ptr.hpp>
 #include "molecule.h"
+#include "moleculeidallocator.h"
+#include "systemsnapshot.h"
 
 namespace molconv
 {
     class SystemPrivate;
 
+    ///
+    /// \brief The MoleculePose struct
+    ///
+    /// the position of the origin and the orientation of the internal
+    /// basis of a single molecule, as used by System::moveMolecules
+    ///
+    struct MoleculePose
+    {
+        unsigned long molId;
+        Eigen::Vector3d position;
+        Eigen::Matrix3d rotation;
+    };
+
     class System
     {
     public:
+        typedef std::function<void(const std::vector<unsigned long> &)> MoveCallback;
+
         static System& get()
         {
             static System instance;
@@ -45,23 +63,47 @@ namespace molconv
         size_t nMolecules() const;
 //        size_t nGroups() const;
         moleculePtr getMolecule(const unsigned long index) const;
+        bool hasMolecule(const unsigned long key) const;
 //        groupPtr getGroup(const size_t index) const;
-        size_t MoleculeIndex(const moleculePtr theMolecule);
+        size_t MoleculeIndex(const moleculePtr theMolecule) const;
+        size_t MoleculeIndex(const unsigned long key) const;
 //        size_t GroupIndex(const groupPtr &theGroup) const;
-        std::vector<unsigned long> getMolIDs() const;
+        const std::vector<unsigned long> &getMolIDs() const;
+        const std::vector<moleculePtr> &molecules() const;
 
         void addMolecule(const moleculePtr newMolecule);
         void removeMolecule(const unsigned long key);
 //        void addGroup(const groupPtr &newGroup);
 //        void removeGroup(const size_t index);
         double calculateRMSDbetween(const unsigned long refMol, const unsigned long otherMol) const;
+        Eigen::MatrixXd rmsdMatrix(const std::vector<unsigned long> &molIDs) const;
+        static Eigen::MatrixXd rmsdMatrix(const SystemSnapshot &snapshot, const std::vector<unsigned long> &molIDs);
         bool alignMolecules(const unsigned long refMol, const unsigned long otherMol) const;
+        std::vector<double> alignMoleculesTo(const unsigned long refMol, const std::vector<unsigned long> &otherMols);
+
+        void moveMolecules(const std::vector<MoleculePose> &poses);
+        void setMoveCallback(const MoveCallback &callback);
+
+        void publish();
+        snapshotPtr snapshot() const;
 
     private:
-        System(){}
+        System() : m_version(0) {}
         System(const System&);
         System& operator=(const System&);
-        std::map<unsigned long, moleculePtr> m_molecules;
+        size_t denseIndex(const unsigned long key) const;
+
+        // the molecules and their IDs are stored densely, m_slots gives the
+        // position of a molecule in both vectors from the slot index of its ID:
+        std::vector<moleculePtr> m_molecules;
+        std::vector<unsigned long> m_molIDs;
+        std::vector<size_t> m_slots;
+        MoleculeIdAllocator m_idAllocator;
+
+        // the last published state, replaced atomically by publish():
+        unsigned long m_version;
+        snapshotPtr m_snapshot;
+        MoveCallback m_moveCallback;
 //        std::vector<groupPtr> m_groups;
     };
 
@@ -0,0 +1,83 @@
+/*
+ * Copyright 2014 - 2019 Jan von Cosel & Sebastian Lenz
+ *
+ * This file is part of molconv.
+ *
+ * molconv is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * molconv is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have recieved a copy of the GNU General Public License
+ * along with molconv. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include <stdexcept>
+#include "moleculeidallocator.h"
+#include "systemsnapshot.h"
+
+
+namespace molconv
+{
+    SystemSnapshot::SystemSnapshot()
+        : m_version(0)
+    {
+    }
+
+    SystemSnapshot::SystemSnapshot(const unsigned long version, const std::vector<MoleculeSnapshot> &molecules)
+        : m_version(version)
+        , m_molecules(molecules)
+    {
+        for (size_t i = 0; i < m_molecules.size(); i++)
+        {
+            const size_t slot = MoleculeIdAllocator::slot(m_molecules[i].molId);
+            if (slot >= m_slots.size())
+                m_slots.resize(slot + 1, size_t(-1));
+
+            m_slots[slot] = i;
+        }
+    }
+
+    ///
+    /// \brief SystemSnapshot::version
+    /// \return
+    ///
+    /// the number of the published version, later snapshots have larger numbers
+    ///
+    unsigned long SystemSnapshot::version() const
+    {
+        return m_version;
+    }
+
+    size_t SystemSnapshot::nMolecules() const
+    {
+        return m_molecules.size();
+    }
+
+    const std::vector<MoleculeSnapshot> &SystemSnapshot::molecules() const
+    {
+        return m_molecules;
+    }
+
+    bool SystemSnapshot::hasMolecule(const unsigned long molId) const
+    {
+        const size_t slot = MoleculeIdAllocator::slot(molId);
+        return slot < m_slots.size() && m_slots[slot] < m_molecules.size() && m_molecules[m_slots[slot]].molId == molId;
+    }
+
+    const MoleculeSnapshot &SystemSnapshot::molecule(const unsigned long molId) const
+    {
+        if (!hasMolecule(molId))
+            throw std::out_of_range("no molecule with this ID in the snapshot.\n");
+
+        return m_molecules[m_slots[MoleculeIdAllocator::slot(molId)]];
+    }
+
+} // namespace molconv
@@ -0,0 +1,78 @@
+/*
+ * Copyright 2014 - 2019 Jan von Cosel & Sebastian Lenz
+ *
+ * This file is part of molconv.
+ *
+ * molconv is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * molconv is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have recieved a copy of the GNU General Public License
+ * along with molconv. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#ifndef SYSTEMSNAPSHOT_H
+#define SYSTEMSNAPSHOT_H
+
+#include<vector>
+#include<boost/shared_ptr.hpp>
+#include<Eigen/Core>
+
+namespace molconv
+{
+    ///
+    /// \brief The MoleculeSnapshot struct
+    ///
+    /// the coordinates, origin and basis of a single molecule at the time a
+    /// SystemSnapshot was published. The coordinate block is shared between
+    /// all snapshots in which the molecule did not change.
+    ///
+    struct MoleculeSnapshot
+    {
+        unsigned long molId;
+        unsigned long generation;
+        boost::shared_ptr<const Eigen::Matrix3Xd> positions;
+        Eigen::Vector3d origin;
+        Eigen::Matrix3d basis;
+    };
+
+    ///
+    /// \brief The SystemSnapshot class
+    ///
+    /// an immutable copy of the state of all molecules in the system, as published
+    /// by System::publish. It can be read from any thread while the system itself
+    /// is changed, e.g. to calculate RMSD matrices in the background.
+    ///
+    class SystemSnapshot
+    {
+    public:
+        SystemSnapshot();
+        SystemSnapshot(const unsigned long version, const std::vector<MoleculeSnapshot> &molecules);
+
+        unsigned long version() const;
+        size_t nMolecules() const;
+        const std::vector<MoleculeSnapshot> &molecules() const;
+        bool hasMolecule(const unsigned long molId) const;
+        const MoleculeSnapshot &molecule(const unsigned long molId) const;
+
+    private:
+        unsigned long m_version;
+        std::vector<MoleculeSnapshot> m_molecules;
+
+        // the position of a molecule in m_molecules from the slot index of its ID:
+        std::vector<size_t> m_slots;
+    };
+
+    typedef boost::shared_ptr<const SystemSnapshot> snapshotPtr;
+
+} // namespace molconv
+
+#endif // SYSTEMSNAPSHOT_H
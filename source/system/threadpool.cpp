@@ -0,0 +1,140 @@
+/*
+ * Copyright 2014 - 2019 Jan von Cosel & Sebastian Lenz
+ *
+ * This file is part of molconv.
+ *
+ * molconv is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * molconv is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have recieved a copy of the GNU General Public License
+ * along with molconv. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include <algorithm>
+#include "threadpool.h"
+
+namespace molconv
+{
+    namespace
+    {
+        // set on the worker threads, so that nested jobs run serially instead
+        // of waiting for the workers they are running on:
+        thread_local bool t_isWorker = false;
+    }
+
+    struct ThreadPool::Batch
+    {
+        const std::function<void()> *job;
+        size_t running;
+    };
+
+    ThreadPool::ThreadPool(const size_t nThreads)
+        : m_stop(false)
+    {
+        for (size_t i = 0; i < nThreads; i++)
+            m_threads.emplace_back(&ThreadPool::work, this);
+    }
+
+    ThreadPool::~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_wakeup.notify_all();
+
+        for (auto &thread : m_threads)
+            thread.join();
+    }
+
+    ///
+    /// \brief ThreadPool::global
+    /// \return
+    ///
+    /// the pool shared by the whole program, with one worker less than there are
+    /// hardware threads, since the caller of a job works as well. It is started
+    /// on first use.
+    ///
+    ThreadPool &ThreadPool::global()
+    {
+        static ThreadPool pool(std::max(std::thread::hardware_concurrency(), 1u) - 1);
+        return pool;
+    }
+
+    size_t ThreadPool::size() const
+    {
+        return m_threads.size();
+    }
+
+    ///
+    /// \brief ThreadPool::run
+    /// \param job
+    /// \param nWorkers
+    ///
+    /// run \p job on the calling thread and on up to \p nWorkers workers and
+    /// return when all of them have finished it. Workers that have not picked up
+    /// the job by the time the caller is done are not waited for. \p job must not
+    /// throw.
+    ///
+    void ThreadPool::run(const std::function<void()> &job, const size_t nWorkers)
+    {
+        const size_t nQueued = std::min(nWorkers, m_threads.size());
+
+        if (nQueued == 0 || t_isWorker)
+        {
+            job();
+            return;
+        }
+
+        Batch batch;
+        batch.job = &job;
+        batch.running = 0;
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_queue.insert(m_queue.end(), nQueued, &batch);
+        }
+        m_wakeup.notify_all();
+
+        job();
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_queue.erase(std::remove(m_queue.begin(), m_queue.end(), &batch), m_queue.end());
+        m_finished.wait(lock, [&batch]() { return batch.running == 0; });
+    }
+
+    void ThreadPool::work()
+    {
+        t_isWorker = true;
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        for (;;)
+        {
+            m_wakeup.wait(lock, [this]() { return m_stop || !m_queue.empty(); });
+
+            if (m_queue.empty())
+                return;
+
+            Batch *batch = m_queue.front();
+            m_queue.pop_front();
+            batch->running++;
+
+            lock.unlock();
+            (*batch->job)();
+            lock.lock();
+
+            if (--batch->running == 0)
+                m_finished.notify_all();
+        }
+    }
+
+} // namespace molconv
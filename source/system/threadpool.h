@@ -0,0 +1,72 @@
+/*
+ * Copyright 2014 - 2019 Jan von Cosel & Sebastian Lenz
+ *
+ * This file is part of molconv.
+ *
+ * molconv is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * molconv is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have recieved a copy of the GNU General Public License
+ * along with molconv. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace molconv
+{
+    ///
+    /// \brief The ThreadPool class
+    ///
+    /// a fixed set of worker threads that are started once and then wait for
+    /// jobs. A job is run on the calling thread and on up to the requested
+    /// number of idle workers at the same time, so it has to distribute its
+    /// work itself (see parallelFor()). Workers that are busy with the job of
+    /// another caller are not waited for, the caller then does the work alone.
+    ///
+    class ThreadPool
+    {
+    public:
+        explicit ThreadPool(const size_t nThreads);
+        ~ThreadPool();
+
+        static ThreadPool &global();
+
+        size_t size() const;
+        void run(const std::function<void()> &job, const size_t nWorkers);
+
+    private:
+        struct Batch;
+
+        ThreadPool(const ThreadPool &) = delete;
+        ThreadPool &operator=(const ThreadPool &) = delete;
+
+        void work();
+
+        std::vector<std::thread> m_threads;
+        std::mutex m_mutex;
+        std::condition_variable m_wakeup;
+        std::condition_variable m_finished;
+        std::deque<Batch *> m_queue;
+        bool m_stop;
+    };
+
+} // namespace molconv
+
+#endif // THREADPOOL_H
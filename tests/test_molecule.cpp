@@ -19,7 +19,40 @@
  */
 
 
+#include <array>
+#include <atomic>
+#include <clocale>
+#include <cstring>
+#include <ctime>
 #include <iostream>
+#include <limits>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <QBuffer>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <boost/filesystem/operations.hpp>
+#include <boost/make_shared.hpp>
+#include <chemkit/moleculefile.h>
+#include <Eigen/Geometry>
+#include "atommask.h"
+#include "bondperceiver.h"
+#include "compresseddevice.h"
+#include "contactmonitor.h"
+#include "moleculebasis.h"
+#include "moleculeexporter.h"
+#include "moleculefileprobe.h"
+#include "moleculeimporter.h"
+#include "molconvbinaryfile.h"
+#include "molconvfile.h"
+#include "moleculeorigin.h"
+#include "parallelfor.h"
+#include "spatialindex.h"
+#include "system.h"
+#include "threadpool.h"
+#include "xyztrajectory.h"
 #include "test_molecule.h"
 
 void TestMolecule::initTestCase()
@@ -36,11 +69,96 @@ void TestMolecule::initTestCase()
     mol.atom(4)->setPosition(1.0, -1.0, -1.0);
 }
 
+void TestMolecule::cleanup()
+{
+    // remove what a test left in the system, even if it failed halfway:
+    molconv::System &system = molconv::System::get();
+    system.setMoveCallback(molconv::System::MoveCallback());
+
+    while (system.nMolecules() > 0)
+        system.removeMolecule(system.getMolIDs().back());
+
+    std::setlocale(LC_NUMERIC, "C");
+}
+
+// a copy of the test molecule that has been added to the system:
+molconv::moleculePtr TestMolecule::addMolecule()
+{
+    molconv::moleculePtr copy = boost::make_shared<molconv::Molecule>(static_cast<const chemkit::Molecule &>(mol));
+    molconv::System::get().addMolecule(copy);
+
+    return copy;
+}
+
+// a copy of the test molecule with the origin and the basis on some of its
+// atoms, moved away from its initial pose and added to the system:
+molconv::moleculePtr TestMolecule::addSessionMolecule()
+{
+    molconv::moleculePtr molecule = addMolecule();
+    molecule->setName("methane");
+
+    molconv::AtomMask originList(molecule->size(), false);
+    originList.set(1);
+    originList.set(2);
+    molecule->setOrigin(molconv::kCenterOfGeometry, originList);
+    molecule->setBasis(molconv::kVectorsFromAtoms, molconv::AtomMask(molecule->size(), true), 0, 1, 3);
+    molecule->moveTo(Eigen::Vector3d(1.0, -2.0, 0.5), Eigen::Quaterniond(Eigen::AngleAxisd(0.4, Eigen::Vector3d(1.0, 2.0, 3.0).normalized())));
+
+    return molecule;
+}
+
+bool TestMolecule::sameMolecule(const molconv::Molecule &first, const molconv::Molecule &second)
+{
+    if (first.size() != second.size() || first.name() != second.name())
+        return false;
+
+    for (size_t i = 0; i < first.size(); i++)
+        if (first.atom(i)->atomicNumber() != second.atom(i)->atomicNumber())
+            return false;
+
+    const double tolerance = 1.0e-10;
+
+    return first.origin()->code() == second.origin()->code()
+            && first.basis()->code() == second.basis()->code()
+            && first.originAtoms() == second.originAtoms()
+            && first.basisAtoms() == second.basisAtoms()
+            && first.originList() == second.originList()
+            && first.basisList() == second.basisList()
+            && first.positions().isApprox(second.positions(), tolerance)
+            && first.internalPositions().isApprox(second.internalPositions(), tolerance)
+            && first.originPosition().isApprox(second.originPosition(), tolerance)
+            && first.basisVectors().isApprox(second.basisVectors(), tolerance)
+            && std::abs(first.phi() - second.phi()) < tolerance
+            && std::abs(first.theta() - second.theta()) < tolerance
+            && std::abs(first.psi() - second.psi()) < tolerance;
+}
+
+// switch to a numeric locale with a decimal comma, if one is installed.
+// cleanup() goes back to the C locale the tests run in otherwise:
+bool TestMolecule::useCommaLocale()
+{
+    for (const char *name : {"de_DE.UTF-8", "de_DE.utf8", "de_DE", "fr_FR.UTF-8", "fr_FR.utf8", "fr_FR"})
+    {
+        if (std::setlocale(LC_NUMERIC, name) && std::localeconv()->decimal_point[0] == ',')
+            return true;
+    }
+
+    std::setlocale(LC_NUMERIC, "C");
+    return false;
+}
+
 void TestMolecule::test_size()
 {
     unsigned long expected = 5;
 
     QCOMPARE(mol.size(), expected);
+
+    // a molecule without atoms has no origin and basis yet:
+    molconv::Molecule empty;
+    QCOMPARE(empty.size(), size_t(0));
+    QVERIFY(!empty.origin());
+    QVERIFY(!empty.basis());
+    QCOMPARE(empty.phi(), 0.0);
 }
 
 void TestMolecule::test_center()
@@ -51,4 +169,1049 @@ void TestMolecule::test_center()
     QCOMPARE(c, d);
 }
 
+void TestMolecule::test_positions()
+{
+    Eigen::Vector3d p = mol.positions().col(4);
+    Eigen::Vector3d q(1.0, -1.0, -1.0);
+
+    QCOMPARE(int(mol.positions().cols()), 5);
+    QCOMPARE(p, q);
+}
+
+void TestMolecule::test_covarianceMatrix()
+{
+    Eigen::Matrix3d c = mol.covarianceMatrix();
+    Eigen::Matrix3d d = 0.8 * Eigen::Matrix3d::Identity();
+
+    QVERIFY(c.isApprox(d));
+}
+
+void TestMolecule::test_propertyCache()
+{
+    mol.inertiaEigenvalues();
+    unsigned long misses = mol.cacheMisses();
+    unsigned long hits = mol.cacheHits();
+
+    mol.inertiaEigenvectors();
+    mol.inertiaTensor();
+
+    QCOMPARE(mol.cacheMisses(), misses);
+    QCOMPARE(mol.cacheHits(), hits + 2);
+}
+
+void TestMolecule::test_concurrentReaders()
+{
+    molconv::Molecule expected(static_cast<const chemkit::Molecule &>(mol));
+    molconv::Molecule shared(static_cast<const chemkit::Molecule &>(mol));
+
+    // an atom added through chemkit is gathered by the first reader:
+    expected.addAtom("O")->setPosition(0.5, 0.5, 2.0);
+    shared.addAtom("O")->setPosition(0.5, 0.5, 2.0);
+    const Eigen::Matrix3Xd positions = expected.positions();
+    const Eigen::Vector3d eigenvalues = expected.inertiaEigenvalues();
+    const std::array<double,3> angles = {{expected.psi(), expected.theta(), expected.phi()}};
+
+    std::array<bool, 4> correct;
+    std::vector<std::thread> readers;
+    for (size_t t = 0; t < correct.size(); t++)
+        readers.push_back(std::thread([&, t]()
+        {
+            correct[t] = shared.positions().isApprox(positions) && shared.inertiaEigenvalues().isApprox(eigenvalues)
+                    && shared.psi() == angles[0] && shared.theta() == angles[1] && shared.phi() == angles[2];
+        }));
+
+    for (auto &reader : readers)
+        reader.join();
+
+    for (auto const& ok : correct)
+        QVERIFY(ok);
+}
+
+void TestMolecule::test_moveMolecules()
+{
+    molconv::System &system = molconv::System::get();
+    molconv::moleculePtr movable = addMolecule();
+
+    std::vector<unsigned long> moved;
+    int notifications = 0;
+    system.setMoveCallback([&](const std::vector<unsigned long> &molIDs) { moved = molIDs; notifications++; });
+
+    molconv::MoleculePose pose;
+    pose.molId = movable->molId();
+    pose.position = Eigen::Vector3d(1.0, 2.0, 3.0);
+    pose.rotation = Eigen::AngleAxisd(0.3, Eigen::Vector3d(1.0, 1.0, 0.0).normalized()).toRotationMatrix();
+    system.moveMolecules(std::vector<molconv::MoleculePose>(1, pose));
+
+    Eigen::Matrix3Xd expected = (pose.rotation * movable->internalPositions()).colwise() + pose.position;
+
+    QCOMPARE(notifications, 1);
+    QVERIFY(moved == std::vector<unsigned long>(1, movable->molId()));
+    QVERIFY(movable->positions().isApprox(expected));
+    QVERIFY(movable->basisVectors().isApprox(pose.rotation));
+
+    // reflections and scaled matrices are rejected before anything is moved:
+    pose.rotation = -pose.rotation;
+    QVERIFY_EXCEPTION_THROWN(system.moveMolecules(std::vector<molconv::MoleculePose>(1, pose)), std::invalid_argument);
+    QVERIFY_EXCEPTION_THROWN(movable->moveTo(pose.position, Eigen::Matrix3d(2.0 * Eigen::Matrix3d::Identity())), std::invalid_argument);
+    QCOMPARE(notifications, 1);
+    QVERIFY(movable->positions().isApprox(expected));
+}
+
+void TestMolecule::test_threadPool()
+{
+    // the same pool serves repeated, nested and concurrent calls:
+    molconv::ThreadPool pool(3);
+    QCOMPARE(pool.size(), size_t(3));
+
+    std::atomic<size_t> count(0);
+    for (int i = 0; i < 100; i++)
+        pool.run([&count]() { count++; }, 3);
+    QVERIFY(count >= 100 && count <= 400);
+
+    std::vector<size_t> sums(64, 0);
+    std::thread other([&]() { molconv::parallelFor(1000, [](const size_t) {}); });
+    molconv::parallelFor(sums.size(), [&sums](const size_t i)
+    {
+        std::atomic<size_t> sum(0);
+        molconv::parallelFor(100, [&sum](const size_t j) { sum += j; });
+        sums[i] = sum;
+    });
+    other.join();
+
+    for (auto const& sum : sums)
+        QCOMPARE(sum, size_t(4950));
+
+    bool thrown = false;
+    try
+    {
+        molconv::parallelFor(1000, [](const size_t i) { if (i == 500) throw std::runtime_error("stop"); });
+    }
+    catch (const std::runtime_error &)
+    {
+        thrown = true;
+    }
+    QVERIFY(thrown);
+}
+
+void TestMolecule::test_orientation()
+{
+    molconv::moleculePtr movable = addMolecule();
+
+    Eigen::Quaterniond orientation(Eigen::AngleAxisd(1.2, Eigen::Vector3d(0.0, 1.0, 1.0).normalized()));
+    movable->moveTo(Eigen::Vector3d::Zero(), orientation);
+
+    Eigen::Matrix3d fromEulers = molconv::MoleculeBasis::euler2rot(movable->psi(), movable->theta(), movable->phi());
+
+    QVERIFY(movable->basisVectors().isApprox(orientation.toRotationMatrix()));
+    QVERIFY(fromEulers.isApprox(movable->basisVectors()));
+    QVERIFY(std::abs(movable->orientation().dot(orientation)) > 1.0 - 1.0e-12);
+}
+
+void TestMolecule::test_rmsdMatrix()
+{
+    molconv::System &system = molconv::System::get();
+    molconv::moleculePtr first = addMolecule();
+    molconv::moleculePtr second = addMolecule();
+    molconv::moleculePtr distorted = addMolecule();
+
+    second->moveTo(Eigen::Vector3d(2.0, -1.0, 0.5), Eigen::Quaterniond(Eigen::AngleAxisd(0.8, Eigen::Vector3d::UnitZ())));
+
+    // stretching all C-H bonds by 10 % keeps the centers and the orientation,
+    // so the superposed RMSD is that of the unmoved copy: 0.1 * sqrt(4 * 3 / 5)
+    distorted->setPositions(1.1 * distorted->positions());
+    const double expected = 0.1 * std::sqrt(12.0 / 5.0);
+    QVERIFY(std::abs(system.calculateRMSDbetween(first->molId(), distorted->molId()) - expected) < 1.0e-12);
+
+    distorted->moveTo(Eigen::Vector3d(-1.0, 3.0, 2.0), Eigen::Quaterniond(Eigen::AngleAxisd(2.1, Eigen::Vector3d(1.0, -2.0, 0.5).normalized())));
+
+    std::vector<unsigned long> ids;
+    ids.push_back(first->molId());
+    ids.push_back(second->molId());
+    ids.push_back(distorted->molId());
+    Eigen::MatrixXd rmsd = system.rmsdMatrix(ids);
+
+    QCOMPARE(int(rmsd.rows()), 3);
+    QVERIFY(rmsd.isApprox(rmsd.transpose()));
+    QVERIFY(rmsd(0,1) < 1.0e-6);
+    QVERIFY(std::abs(rmsd(0,2) - expected) < 1.0e-6);
+    QVERIFY(std::abs(rmsd(1,2) - expected) < 1.0e-6);
+}
+
+void TestMolecule::test_alignMoleculesTo()
+{
+    molconv::System &system = molconv::System::get();
+    molconv::moleculePtr reference = addMolecule();
+
+    std::vector<unsigned long> others;
+    for (int i = 0; i < 3; i++)
+    {
+        molconv::moleculePtr other = addMolecule();
+        other->moveTo(Eigen::Vector3d(double(i), 1.0, -2.0), Eigen::Quaterniond(Eigen::AngleAxisd(0.5 * double(i + 1), Eigen::Vector3d::UnitY())));
+        others.push_back(other->molId());
+    }
+
+    std::vector<double> rmsds = system.alignMoleculesTo(reference->molId(), others);
+
+    QCOMPARE(int(rmsds.size()), 3);
+    for (size_t i = 0; i < others.size(); i++)
+    {
+        QVERIFY(rmsds[i] >= 0.0 && rmsds[i] < 1.0e-6);
+        QVERIFY(system.getMolecule(others[i])->positions().isApprox(reference->positions(), 1.0e-6));
+    }
+}
+
+void TestMolecule::test_atomMask()
+{
+    molconv::AtomMask mask(130, false);
+    for (size_t i = 0; i < mask.size(); i += 3)
+        mask.set(i);
+
+    QCOMPARE(mask.count(), size_t(44));
+    QVERIFY(mask.test(129) && !mask.test(128));
+
+    size_t sum = 0;
+    mask.forEach([&](const size_t i) { sum += i; });
+    QCOMPARE(sum, size_t(2838));
+
+    QVERIFY(molconv::AtomMask::fromHex(mask.toHex(), mask.size()) == mask);
+    QVERIFY(molconv::AtomMask(mask.toVector()) == mask);
+
+    mask.resize(200, true);
+    QCOMPARE(mask.count(), size_t(44 + 70));
+    QVERIFY(molconv::AtomMask(5, true).all());
+    QVERIFY(mol.originList().all());
+}
+
+void TestMolecule::test_bondPerceiver()
+{
+    // a chain of atoms 1.0 apart along x, with a second chain far away:
+    Eigen::Matrix3Xd positions = Eigen::Matrix3Xd::Zero(3, 20);
+    for (int i = 0; i < 10; i++)
+    {
+        positions(0, i) = double(i);
+        positions(0, i + 10) = double(i);
+        positions(1, i + 10) = 50.0;
+    }
+    Eigen::VectorXd radii = Eigen::VectorXd::Constant(20, 0.5);
+
+    std::vector<molconv::BondPerceiver::AtomPair> bonds = molconv::BondPerceiver().perceive(positions, radii);
+
+    QCOMPARE(int(bonds.size()), 18);
+    for (auto const& bond : bonds)
+        QCOMPARE(bond[1], bond[0] + 1);
+
+    // rigid moves of the molecule keep the perceived bonds:
+    molconv::Molecule water;
+    water.addAtom("O");
+    water.addAtom("H")->setPosition(0.96, 0.0, 0.0);
+    water.addAtom("H")->setPosition(-0.24, 0.93, 0.0);
+    water.setOrigin(molconv::kCenterOfGeometry, molconv::AtomMask(3, true));
+    water.setBasis(molconv::kCovarianceVectors, molconv::AtomMask(3, true));
+
+    // bonds are perceived on demand only:
+    QVERIFY(!water.bondsPerceived());
+    QCOMPARE(int(water.bondCount()), 0);
+    water.perceiveBonds();
+
+    QCOMPARE(int(water.bondCount()), 2);
+    QVERIFY(water.bondsPerceived());
+
+    water.moveTo(Eigen::Vector3d(1.0, 2.0, 3.0), Eigen::Quaterniond(Eigen::AngleAxisd(1.0, Eigen::Vector3d::UnitZ())));
+    QVERIFY(water.bondsPerceived());
+
+    // stretching a bond removes it when the bonds are perceived again,
+    // but a bond that wasn't perceived (e.g. from the file) is kept:
+    water.syncAtoms();
+    water.addBond(water.atom(1), water.atom(2));
+    water.atom(1)->setPosition(water.atom(0)->position() + Eigen::Vector3d(3.0, 0.0, 0.0));
+    water.updatePositions();
+    QVERIFY(!water.bondsPerceived());
+    water.perceiveBonds();
+
+    QCOMPARE(int(water.bondCount()), 2);
+    QVERIFY(!water.bond(water.atom(0), water.atom(1)));
+    QVERIFY(water.bond(water.atom(0), water.atom(2)));
+    QVERIFY(water.bond(water.atom(1), water.atom(2)));
+}
+
+void TestMolecule::test_setPositions()
+{
+    molconv::Molecule water;
+    water.addAtom("O");
+    water.addAtom("H")->setPosition(0.96, 0.0, 0.0);
+    water.addAtom("H")->setPosition(-0.24, 0.93, 0.0);
+    water.setOrigin(molconv::kCenterOfGeometry, molconv::AtomMask(3, true));
+    water.setBasis(molconv::kCovarianceVectors, molconv::AtomMask(3, true));
+    water.perceiveBonds();
+
+    // a new frame: the same geometry, shifted along z
+    Eigen::Matrix3Xd frame = water.positions();
+    frame.row(2).array() += 5.0;
+    const Eigen::Vector3d oldOrigin = water.originPosition();
+    const Eigen::Matrix3d oldBasis = water.basisVectors();
+
+    water.setPositions(frame);
+
+    QVERIFY(water.positions().isApprox(frame));
+    QVERIFY(water.originPosition().isApprox(oldOrigin + Eigen::Vector3d(0.0, 0.0, 5.0)));
+    QVERIFY(water.basisVectors().isApprox(oldBasis));
+    QCOMPARE(int(water.bondCount()), 2);
+
+    // the atoms follow once they are synchronized:
+    water.syncAtoms();
+    QVERIFY(std::abs(water.atom(1)->position()(2) - 5.0) < 1.0e-12);
+
+    QVERIFY_EXCEPTION_THROWN(water.setPositions(Eigen::Matrix3Xd::Zero(3, 2)), std::invalid_argument);
+}
+
+void TestMolecule::test_moleculeExporter()
+{
+    molconv::moleculePtr water(new molconv::Molecule);
+    water->addAtom("O");
+    water->addAtom("H")->setPosition(0.96, 0.0, 0.0);
+    water->addAtom("H")->setPosition(-0.24, 0.93, 0.0);
+    water->setName("water");
+
+    QCOMPARE(MoleculeExporter::formatFromFileName("out.SDF"), MoleculeExporter::kSdfFormat);
+    QVERIFY(!MoleculeExporter::canExport("out.cml"));
+
+    MoleculeExporter exporter;
+    exporter.addMolecule(water);
+    exporter.addMolecule(water);
+
+    // two records, the bonds are perceived on the way:
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+    QVERIFY(exporter.write(&buffer, MoleculeExporter::kSdfFormat));
+    QStringList lines = QString(buffer.data()).split("\n");
+    QCOMPARE(lines.at(3), QString("  3  2  0  0  0  0  0  0  0  0999 V2000"));
+    QCOMPARE(lines.count("$$$$"), 2);
+
+    // merged into one structure:
+    exporter.setMerged(true, "dimer");
+    buffer.close();
+    buffer.setData(QByteArray());
+    buffer.open(QIODevice::WriteOnly);
+    QVERIFY(exporter.write(&buffer, MoleculeExporter::kXyzFormat));
+    lines = QString(buffer.data()).split("\n");
+    QCOMPARE(lines.at(0), QString("6"));
+    QCOMPARE(lines.at(1), QString("dimer"));
+    QVERIFY(lines.at(3).startsWith("H "));
+
+    // the numbers are written with a decimal point in any locale:
+    if (!useCommaLocale())
+        QSKIP("no locale with a decimal comma is installed");
+
+    buffer.close();
+    buffer.setData(QByteArray());
+    buffer.open(QIODevice::WriteOnly);
+    QVERIFY(exporter.write(&buffer, MoleculeExporter::kXyzFormat));
+    lines = QString(buffer.data()).split("\n");
+    QCOMPARE(lines.at(3), QString("H        0.96000000      0.00000000      0.00000000"));
+    QVERIFY(!buffer.data().contains(','));
+
+    // and the locale of the application is left as it was:
+    QCOMPARE(std::localeconv()->decimal_point[0], ',');
+}
+
+void TestMolecule::test_moleculeIndex()
+{
+    molconv::System &system = molconv::System::get();
+    const size_t nBefore = system.nMolecules();
+
+    std::vector<molconv::moleculePtr> molecules;
+    for (int i = 0; i < 4; i++)
+        molecules.push_back(addMolecule());
+
+    // the last molecule fills the gap of a removed one:
+    system.removeMolecule(molecules[1]->molId());
+    QVERIFY(!system.hasMolecule(molecules[1]->molId()));
+    QCOMPARE(system.nMolecules(), nBefore + 3);
+    QCOMPARE(system.MoleculeIndex(molecules[3]), nBefore + 1);
+
+    for (size_t i = 0; i < system.nMolecules(); i++)
+    {
+        QCOMPARE(system.MoleculeIndex(system.getMolIDs()[i]), i);
+        QVERIFY(system.getMolecule(system.getMolIDs()[i]) == system.molecules()[i]);
+    }
+
+    for (auto const& molecule : molecules)
+        system.removeMolecule(molecule->molId());
+
+    QCOMPARE(system.nMolecules(), nBefore);
+}
+
+void TestMolecule::test_moleculeIds()
+{
+    molconv::MoleculeIdAllocator allocator;
+    const unsigned long first = allocator.allocate();
+    const unsigned long second = allocator.allocate();
+    QCOMPARE(molconv::MoleculeIdAllocator::slot(second), size_t(1));
+
+    // a released slot is reused with a new generation:
+    QVERIFY(allocator.release(first));
+    QVERIFY(!allocator.release(first));
+    const unsigned long third = allocator.allocate();
+    QCOMPARE(molconv::MoleculeIdAllocator::slot(third), size_t(0));
+    QVERIFY(third != first);
+    QVERIFY(allocator.isAllocated(third) && !allocator.isAllocated(first));
+    QVERIFY(!allocator.isAllocated(molconv::MoleculeIdAllocator::kInvalidId));
+
+    // the system gives new IDs to added molecules, copies included:
+    molconv::System &system = molconv::System::get();
+    molconv::moleculePtr original = addMolecule();
+    molconv::moleculePtr copy = boost::make_shared<molconv::Molecule>(*original);
+    system.addMolecule(copy);
+    QVERIFY(copy->molId() != original->molId());
+
+    // adding a molecule twice keeps its ID, a removed ID is not found again:
+    const unsigned long copyId = copy->molId();
+    system.addMolecule(copy);
+    QCOMPARE(copy->molId(), copyId);
+    system.removeMolecule(copyId);
+    QVERIFY(!system.hasMolecule(copyId));
+    QVERIFY_EXCEPTION_THROWN(system.getMolecule(copyId), std::out_of_range);
+
+    system.addMolecule(copy);
+    QVERIFY(copy->molId() != copyId);
+    QCOMPARE(molconv::MoleculeIdAllocator::slot(copy->molId()), molconv::MoleculeIdAllocator::slot(copyId));
+}
+
+void TestMolecule::test_systemSnapshot()
+{
+    molconv::System &system = molconv::System::get();
+    molconv::moleculePtr fixed = addMolecule();
+    molconv::moleculePtr movable = addMolecule();
+
+    system.publish();
+    molconv::snapshotPtr before = system.snapshot();
+    QVERIFY(before->hasMolecule(fixed->molId()) && before->hasMolecule(movable->molId()));
+
+    // nothing changed, so no new version:
+    system.publish();
+    QCOMPARE(system.snapshot()->version(), before->version());
+
+    const Eigen::Matrix3Xd oldPositions = movable->positions();
+    movable->moveTo(Eigen::Vector3d(3.0, 0.0, 0.0), Eigen::Quaterniond(Eigen::AngleAxisd(1.0, Eigen::Vector3d::UnitX())));
+    system.publish();
+    molconv::snapshotPtr after = system.snapshot();
+
+    // the old snapshot is unchanged, the unmoved molecule shares its coordinates:
+    QVERIFY(after->version() > before->version());
+    QVERIFY(before->molecule(movable->molId()).positions->isApprox(oldPositions));
+    QVERIFY(after->molecule(movable->molId()).positions->isApprox(movable->positions()));
+    QVERIFY(after->molecule(fixed->molId()).positions == before->molecule(fixed->molId()).positions);
+
+    // the snapshot can be read on another thread:
+    std::vector<unsigned long> ids;
+    ids.push_back(fixed->molId());
+    ids.push_back(movable->molId());
+    Eigen::MatrixXd rmsd;
+    std::thread worker([&]() { rmsd = molconv::System::rmsdMatrix(*after, ids); });
+    worker.join();
+    QVERIFY(rmsd.isApprox(system.rmsdMatrix(ids)));
+}
+
+void TestMolecule::test_spatialIndex()
+{
+    molconv::System &system = molconv::System::get();
+    molconv::moleculePtr fixed = addMolecule();
+    molconv::moleculePtr movable = addMolecule();
+
+    molconv::SpatialIndex index;
+    index.update();
+    QCOMPARE(index.nAtoms(), fixed->size() + movable->size());
+
+    // a rigid move only changes the pose:
+    movable->moveTo(fixed->originPosition() + Eigen::Vector3d(1.5, 0.5, 0.0), Eigen::Quaterniond(Eigen::AngleAxisd(0.7, Eigen::Vector3d::UnitZ())));
+    index.update();
+
+    const double radius = 2.0;
+    for (size_t i = 0; i < fixed->size(); i++)
+    {
+        const Eigen::Vector3d point = fixed->positions().col(i);
+
+        size_t expected = 0;
+        for (size_t j = 0; j < movable->size(); j++)
+            if ((movable->positions().col(j) - point).norm() <= radius)
+                expected++;
+
+        std::vector<molconv::SpatialIndex::Neighbor> found = index.radiusSearch(point, radius, fixed->molId());
+        QCOMPARE(found.size(), expected);
+        for (auto const& neighbor : found)
+            QVERIFY(index.atomPosition(neighbor.molId, neighbor.atom).isApprox(movable->positions().col(neighbor.atom)));
+    }
+
+    // the nearest atom to an atom of the fixed molecule is the atom itself:
+    std::vector<molconv::SpatialIndex::Neighbor> nearest = index.nearest(fixed->positions().col(0), 2);
+    QCOMPARE(nearest.size(), size_t(2));
+    QCOMPARE(nearest[0].molId, fixed->molId());
+    QVERIFY(nearest[0].distance < 1.0e-12 && nearest[1].distance >= nearest[0].distance);
+
+    system.removeMolecule(movable->molId());
+    index.update();
+    QCOMPARE(index.nMolecules(), system.nMolecules());
+    QVERIFY(!index.hasMolecule(movable->molId()));
+}
+
+void TestMolecule::test_contactMonitor()
+{
+    molconv::System &system = molconv::System::get();
+    molconv::moleculePtr fixed = addMolecule();
+    molconv::moleculePtr movable = addMolecule();
+
+    molconv::ContactMonitor monitor(4.0);
+    const Eigen::Quaterniond rotation(Eigen::AngleAxisd(0.3, Eigen::Vector3d::UnitX()));
+
+    // far apart, neither contacts nor clashes:
+    movable->moveTo(fixed->originPosition() + Eigen::Vector3d(20.0, 0.0, 0.0), rotation);
+    QVERIFY(monitor.update());
+    QVERIFY(monitor.closestContacts(1).empty());
+    QCOMPARE(monitor.nClashes(), size_t(0));
+
+    // overlapping, the shortest contact is the closest pair of atoms:
+    movable->moveTo(fixed->originPosition() + Eigen::Vector3d(1.0, 0.5, 0.0), rotation);
+    QVERIFY(monitor.update());
+
+    double shortest = std::numeric_limits<double>::max();
+    for (size_t i = 0; i < fixed->size(); i++)
+        for (size_t j = 0; j < movable->size(); j++)
+            shortest = std::min(shortest, (fixed->positions().col(i) - movable->positions().col(j)).norm());
+
+    std::vector<molconv::ContactMonitor::Contact> closest = monitor.closestContacts(1);
+    QCOMPARE(closest.size(), size_t(1));
+    QVERIFY(std::abs(closest[0].distance - shortest) < 1.0e-10);
+    QVERIFY(closest[0].clash);
+    QVERIFY(monitor.nClashes() > 0);
+    QVERIFY(!monitor.clashingAtoms().empty());
+
+    // the clashes disappear when the molecule is moved away again, or removed:
+    movable->moveTo(fixed->originPosition() + Eigen::Vector3d(5.0, 0.0, 0.0), rotation);
+    QVERIFY(monitor.update());
+    QCOMPARE(monitor.nClashes(), size_t(0));
+
+    movable->moveTo(fixed->originPosition() + Eigen::Vector3d(1.0, 0.5, 0.0), rotation);
+    monitor.update();
+    system.removeMolecule(movable->molId());
+    QVERIFY(monitor.update());
+    QVERIFY(monitor.closestContacts(1).empty());
+    QCOMPARE(monitor.nClashes(), size_t(0));
+}
+
+void TestMolecule::test_readLegacySession()
+{
+    molconv::moleculePtr original = addSessionMolecule();
+
+    // a session as written by the DOM based writer of earlier versions,
+    // with the atom lists as "T,F,..." strings:
+    auto atomList = [](const molconv::AtomMask &mask)
+    {
+        QStringList items;
+        for (size_t i = 0; i < mask.size(); i++)
+            items << (mask.test(i) ? "T" : "F");
+        return items.join(",");
+    };
+    auto number = [](const double value) { return QString::number(value, 'e', 16); };
+
+    QString session = "<System>\n <Molecule Name=\"" + QString::fromStdString(original->name()) + "\">\n";
+    session += QString("  <Origin Type=\"%1\" Factor=\"%2\" Atoms=\"%3,%4\" originList=\"%5\" vecX=\"%6\" vecY=\"%7\" vecZ=\"%8\"/>\n")
+            .arg(original->origin()->code()).arg(original->originFactor())
+            .arg(original->originAtoms()[0]).arg(original->originAtoms()[1]).arg(atomList(original->originList()))
+            .arg(number(original->originPosition()(0))).arg(number(original->originPosition()(1))).arg(number(original->originPosition()(2)));
+    session += QString("  <Basis Type=\"%1\" Atoms=\"%2,%3,%4\" basisList=\"%5\" phi=\"%6\" theta=\"%7\" psi=\"%8\"/>\n")
+            .arg(original->basis()->code())
+            .arg(original->basisAtoms()[0]).arg(original->basisAtoms()[1]).arg(original->basisAtoms()[2]).arg(atomList(original->basisList()))
+            .arg(number(original->phi())).arg(number(original->theta())).arg(number(original->psi()));
+    for (size_t j = 0; j < original->size(); j++)
+        session += QString("  <Atom Ele=\"%1\" X=\"%2\" Y=\"%3\" Z=\"%4\"/>\n")
+                .arg(QString::fromStdString(original->atom(j)->element().symbol()))
+                .arg(number(original->internalPositions()(0, j))).arg(number(original->internalPositions()(1, j))).arg(number(original->internalPositions()(2, j)));
+    session += " </Molecule>\n</System>\n";
+
+    QTemporaryDir directory;
+    const QString fileName = directory.path() + "/legacy.mcv";
+    QFile file(fileName);
+    QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Text));
+    QTextStream(&file) << session;
+    file.close();
+
+    MolconvFile reader;
+    QVERIFY(reader.read(fileName));
+    QCOMPARE(reader.molecules().size(), size_t(1));
+    QVERIFY(sameMolecule(*reader.molecules().front(), *original));
+
+    // origins, bases and elements that can't be set up make the file invalid:
+    auto rejected = [&directory](const QString &damagedSession)
+    {
+        QFile damaged(directory.path() + "/damaged.mcv");
+        damaged.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text);
+        QTextStream(&damaged) << damagedSession;
+        damaged.close();
+
+        MolconvFile damagedReader;
+        return !damagedReader.read(damaged.fileName());
+    };
+
+    QVERIFY(session.contains("<Origin Type=\"1\"") && session.contains("Atoms=\"0,1,3\"") && session.contains("Ele=\"H\""));
+    QVERIFY(rejected(QString(session).replace("<Origin Type=\"1\"", "<Origin Type=\"2\"")));
+    QVERIFY(rejected(QString(session).replace("<Origin Type=\"1\"", "<Origin Type=\"99\"")));
+    QVERIFY(rejected(QString(session).replace("Atoms=\"0,1,3\"", "Atoms=\"0,1,5\"")));
+    QVERIFY(rejected(QString(session).replace("Atoms=\"0,1,3\"", "Atoms=\"0,-1,3\"")));
+    QVERIFY(rejected(QString(session).replace("Ele=\"H\"", "Ele=\"Xx\"")));
+
+    // lists of the wrong length are fitted to the atoms, but the center
+    // of geometry needs a list that selects at least one atom:
+    QVERIFY(session.contains("originList=\"F,T,T,F,F\""));
+    QVERIFY(rejected(QString(session).replace("originList=\"F,T,T,F,F\"", "originList=\"F,F,F,F,F\"")));
+    QVERIFY(rejected(QString(session).replace("originList=\"F,T,T,F,F\" ", "")));
+    QVERIFY(!rejected(QString(session).replace("originList=\"F,T,T,F,F\"", "originList=\"F,T,T,F,F,T,T\"")));
+    QVERIFY(!rejected(QString(session).replace("originList=\"F,T,T,F,F\"", "originList=\"F,T,T\"")));
+
+    MolconvFile shortened;
+    QVERIFY(shortened.read(directory.path() + "/damaged.mcv"));
+    QVERIFY(sameMolecule(*shortened.molecules().front(), *original));
+}
+
+void TestMolecule::test_writeSession()
+{
+    molconv::moleculePtr original = addSessionMolecule();
+
+    QTemporaryDir directory;
+    const QString fileName = directory.path() + "/session.mcv";
+    MolconvFile writer;
+    QVERIFY(writer.write(fileName));
+
+    MolconvFile reader;
+    QVERIFY(reader.read(fileName));
+    QCOMPARE(reader.molecules().size(), size_t(1));
+    QVERIFY(sameMolecule(*reader.molecules().front(), *original));
+
+    // the atom lists are written as packed masks:
+    QFile file(fileName);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    const QByteArray contents = file.readAll();
+    QVERIFY(contents.contains("originMask=") && !contents.contains("originList="));
+}
+
+void TestMolecule::test_binarySession()
+{
+    molconv::moleculePtr original = addSessionMolecule();
+
+    QTemporaryDir directory;
+    const QString fileName = directory.path() + "/session.mcb";
+    MolconvFile writer;
+    QVERIFY(writer.write(fileName));
+
+    MolconvFile reader;
+    QVERIFY(reader.read(fileName));
+    QCOMPARE(reader.molecules().size(), size_t(1));
+    QVERIFY(sameMolecule(*reader.molecules().front(), *original));
+
+    QFile file(fileName);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    const QByteArray contents = file.readAll();
+    file.close();
+
+    auto rejected = [&directory](const QByteArray &data)
+    {
+        QFile damaged(directory.path() + "/damaged.mcb");
+        damaged.open(QIODevice::WriteOnly | QIODevice::Truncate);
+        damaged.write(data);
+        damaged.close();
+
+        MolconvBinaryFile binary;
+        return !binary.open(damaged.fileName());
+    };
+
+    // the header is the magic, the version, the byte order mark and the
+    // number of molecules, followed by the records:
+    QByteArray wrongMagic = contents;
+    wrongMagic[0] = 'X';
+    QByteArray wrongVersion = contents;
+    wrongVersion[8] = char(MolconvBinaryFile::kVersion + 1);
+    QByteArray hugeAtomCount = contents;
+    const uint64_t nAtoms = std::numeric_limits<uint64_t>::max() / 8;
+    std::memcpy(hugeAtomCount.data() + 24 + 8, &nAtoms, sizeof(nAtoms));
+
+    QVERIFY(!rejected(contents));
+    QVERIFY(rejected(contents.left(contents.size() - 8)));
+    QVERIFY(rejected(wrongMagic));
+    QVERIFY(rejected(wrongVersion));
+    QVERIFY(rejected(hugeAtomCount));
+
+    // the record starts with its size, the number of atoms, the length of the
+    // name and the origin and basis parameters. The name "methane" is padded
+    // to 8 bytes and followed by the atomic numbers and the origin mask:
+    auto damaged = [&contents](const int offset, const int32_t value)
+    {
+        QByteArray data = contents;
+        std::memcpy(data.data() + offset, &value, sizeof(value));
+        return data;
+    };
+
+    QVERIFY(rejected(damaged(24 + 20, 99)));
+    QVERIFY(rejected(damaged(24 + 20, molconv::kCenterOfCharge)));
+    QVERIFY(rejected(damaged(24 + 32, molconv::kStandardOrientation)));
+    QVERIFY(rejected(damaged(24 + 44, 5)));
+    QVERIFY(rejected(damaged(24 + 44, -1)));
+    QVERIFY(rejected(damaged(24 + 112 + 8, 0)));
+    QVERIFY(rejected(damaged(24 + 112 + 8 + 8, 0)));
+}
+
+void TestMolecule::test_compressedSession()
+{
+    molconv::moleculePtr original = addSessionMolecule();
+
+    // the session files with their compression format's magic number:
+    std::vector<std::pair<QString,QByteArray>> sessions;
+    sessions.push_back(std::make_pair(QString("session.mcv.gz"), QByteArray("\x1f\x8b", 2)));
+#ifdef MOLCONV_HAVE_ZSTD
+    sessions.push_back(std::make_pair(QString("session.mcv.zst"), QByteArray("\x28\xb5\x2f\xfd", 4)));
+#endif
+
+    QTemporaryDir directory;
+    for (auto const& session : sessions)
+    {
+        const QString fileName = directory.path() + "/" + session.first;
+        MolconvFile writer;
+        QVERIFY(writer.write(fileName));
+
+        QFile file(fileName);
+        QVERIFY(file.open(QIODevice::ReadOnly));
+        QVERIFY(file.readAll().startsWith(session.second));
+        file.close();
+
+        MolconvFile reader;
+        QVERIFY(reader.read(fileName));
+        QCOMPARE(reader.molecules().size(), size_t(1));
+        QVERIFY(sameMolecule(*reader.molecules().front(), *original));
+    }
+
+    // the remaining compressed data is only written when the device is
+    // finished, so that is where running out of space has to show up:
+    QFile full("/dev/full");
+    if (full.open(QIODevice::WriteOnly | QIODevice::Unbuffered))
+    {
+        CompressedDevice device(&full, CompressedDevice::kGzip);
+        QVERIFY(device.open(QIODevice::WriteOnly));
+        device.write(QByteArray(1000, 'x'));
+        QVERIFY(!device.finish());
+        QVERIFY(!device.errorString().isEmpty());
+    }
+}
+
+void TestMolecule::test_moleculeImporter()
+{
+    // a file with a hydrogen atom, a hydrogen molecule and a linear H3:
+    boost::shared_ptr<chemkit::MoleculeFile> file = boost::make_shared<chemkit::MoleculeFile>();
+    for (int n = 1; n <= 3; n++)
+    {
+        boost::shared_ptr<chemkit::Molecule> chain = boost::make_shared<chemkit::Molecule>();
+        for (int i = 0; i < n; i++)
+            chain->addAtom("H")->setPosition(0.74 * i, 1.0, 0.0);
+        file->addMolecule(chain);
+    }
+
+    std::mutex mutex;
+    std::vector<molconv::moleculePtr> imported;
+    auto collect = [&](molconv::moleculePtr molecule)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        imported.push_back(molecule);
+    };
+
+    // the selected molecules are converted and handed out in the order of the file:
+    MoleculeImporter importer;
+    QObject::connect(&importer, &MoleculeImporter::moleculeImported, collect);
+
+    MoleculeImporter::Job job;
+    job.fileName = "/tmp/chains.sdf";
+    job.file = file;
+    job.selection = {true, false, true};
+    importer.addJob(job);
+    importer.setOrigin(molconv::kCenterOnAtom, 0);
+    importer.start();
+    QVERIFY(importer.wait(10000));
+
+    QCOMPARE(importer.importedCount(), 2);
+    QCOMPARE(imported.size(), size_t(2));
+    QCOMPARE(int(imported[0]->size()), 1);
+    QCOMPARE(int(imported[1]->size()), 3);
+    QCOMPARE(imported[0]->name(), std::string("chains_1"));
+    QCOMPARE(imported[1]->name(), std::string("chains_2"));
+    QCOMPARE(imported[1]->origin()->code(), molconv::kCenterOnAtom);
+    QVERIFY(imported[1]->originPosition().isApprox(Eigen::Vector3d(0.0, 1.0, 0.0)));
+    QCOMPARE(imported[1]->basis()->code(), molconv::kCovarianceVectors);
+
+    // a file that can't be read is reported instead:
+    QStringList failed;
+    MoleculeImporter missing;
+    QObject::connect(&missing, &MoleculeImporter::fileFailed, [&](const QString &fileName, const QString &)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        failed << fileName;
+    });
+    missing.addFile("/nonexistent/molecule.xyz");
+    missing.start();
+    QVERIFY(missing.wait(10000));
+    QCOMPARE(failed, QStringList() << "/nonexistent/molecule.xyz");
+    QCOMPARE(missing.importedCount(), 0);
+
+    // as is every molecule that doesn't have the atoms of the origin:
+    imported.clear();
+    failed.clear();
+    QStringList errors;
+    MoleculeImporter between;
+    QObject::connect(&between, &MoleculeImporter::moleculeImported, collect);
+    QObject::connect(&between, &MoleculeImporter::fileFailed, [&](const QString &fileName, const QString &error)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        failed << fileName;
+        errors << error;
+    });
+    job.selection.clear();
+    between.addJob(job);
+    between.setOrigin(molconv::kCenterBetweenAtoms, 0, 2, 0.5);
+    between.start();
+    QVERIFY(between.wait(10000));
+
+    QCOMPARE(failed, QStringList() << job.fileName << job.fileName);
+    QVERIFY(errors[0].endsWith("molecule 1") && errors[1].endsWith("molecule 2"));
+    QCOMPARE(between.importedCount(), 1);
+    QCOMPARE(int(imported.front()->size()), 3);
+    QVERIFY(imported.front()->originPosition().isApprox(Eigen::Vector3d(0.74, 1.0, 0.0)));
+
+    // cancelling stops the import after the files that are being processed:
+    imported.clear();
+    MoleculeImporter cancelled;
+    QObject::connect(&cancelled, &MoleculeImporter::moleculeImported, collect);
+    QObject::connect(&cancelled, &MoleculeImporter::moleculeImported, &cancelled, &MoleculeImporter::cancel, Qt::DirectConnection);
+
+    const int nJobs = int(molconv::ThreadPool::global().size()) + 16;
+    job.selection.clear();
+    job.file = boost::make_shared<chemkit::MoleculeFile>();
+    job.file->addMolecule(file->molecule(1));
+    for (int j = 0; j < nJobs; j++)
+        cancelled.addJob(job);
+    cancelled.start();
+    QVERIFY(cancelled.wait(10000));
+
+    QVERIFY(cancelled.isCancelled());
+    QVERIFY(cancelled.importedCount() >= 1);
+    QVERIFY(cancelled.importedCount() < nJobs);
+    QCOMPARE(int(imported.size()), cancelled.importedCount());
+}
+
+void TestMolecule::test_moleculeFileProbe()
+{
+    QTemporaryDir directory;
+    auto writeFile = [&directory](const QString &name, const QByteArray &contents)
+    {
+        QFile file(directory.path() + "/" + name);
+        file.open(QIODevice::WriteOnly | QIODevice::Truncate);
+        file.write(contents);
+        return file.fileName();
+    };
+
+    const QString xyzFile = writeFile("molecules.xyz",
+            "2\nhydrogen\nH 0.0 0.0 0.0\nH 0.74 0.0 0.0\n"
+            "1\nhelium\nHe 0.0 0.0 0.0\n"
+            "3\nwater\nO 0.0 0.0 0.0\nH 0.96 0.0 0.0\nH -0.24 0.93 0.0\n");
+
+    MoleculeFileProbe probe;
+    QVERIFY(probe.probe(xyzFile));
+    QVERIFY(probe.isValid());
+    QVERIFY(probe.isComplete());
+    QCOMPARE(probe.moleculeCount(), size_t(3));
+    QCOMPARE(probe.atomCount(0), size_t(2));
+    QCOMPARE(probe.atomCount(1), size_t(1));
+    QCOMPARE(probe.atomCount(2), size_t(3));
+    QCOMPARE(probe.names(), std::vector<std::string>({"hydrogen", "helium", "water"}));
+
+    // only scanning the first molecules leaves the probe incomplete:
+    QVERIFY(probe.probe(xyzFile, 2));
+    QCOMPARE(probe.moleculeCount(), size_t(2));
+    QVERIFY(!probe.isComplete());
+    QVERIFY(probe.probe(xyzFile, 3));
+    QVERIFY(probe.isComplete());
+
+    // a V2000 and a V3000 record:
+    const QString sdfFile = writeFile("molecules.sdf",
+            "hydrogen\n  molconv\n\n"
+            "  2  1  0  0  0  0  0  0  0  0999 V2000\n"
+            "    0.0000    0.0000    0.0000 H   0  0  0  0  0  0  0  0  0  0  0  0\n"
+            "    0.7400    0.0000    0.0000 H   0  0  0  0  0  0  0  0  0  0  0  0\n"
+            "  1  2  1  0\n"
+            "M  END\n$$$$\n"
+            "water\n  molconv\n\n"
+            "  0  0  0     0  0            999 V3000\n"
+            "M  V30 BEGIN CTAB\n"
+            "M  V30 COUNTS 3 2 0 0 0\n"
+            "M  V30 BEGIN ATOM\n"
+            "M  V30 1 O 0.0 0.0 0.0 0\n"
+            "M  V30 2 H 0.96 0.0 0.0 0\n"
+            "M  V30 3 H -0.24 0.93 0.0 0\n"
+            "M  V30 END ATOM\n"
+            "M  V30 END CTAB\n"
+            "M  END\n$$$$\n");
+
+    QVERIFY(probe.probe(sdfFile));
+    QVERIFY(probe.isComplete());
+    QCOMPARE(probe.moleculeCount(), size_t(2));
+    QCOMPARE(probe.atomCount(0), size_t(2));
+    QCOMPARE(probe.atomCount(1), size_t(3));
+    QCOMPARE(probe.names(), std::vector<std::string>({"hydrogen", "water"}));
+
+    const QString mol2File = writeFile("molecules.mol2",
+            "@<TRIPOS>MOLECULE\nhydrogen\n 2 1 0 0 0\nSMALL\nNO_CHARGES\n\n"
+            "@<TRIPOS>ATOM\n"
+            "      1 H1    0.0000    0.0000    0.0000 H     1 MOL  0.0000\n"
+            "      2 H2    0.7400    0.0000    0.0000 H     1 MOL  0.0000\n"
+            "@<TRIPOS>MOLECULE\nhelium\n 1 0 0 0 0\nSMALL\nNO_CHARGES\n\n"
+            "@<TRIPOS>ATOM\n"
+            "      1 He1   0.0000    0.0000    0.0000 He    1 MOL  0.0000\n");
+
+    QVERIFY(probe.probe(mol2File));
+    QCOMPARE(probe.moleculeCount(), size_t(2));
+    QCOMPARE(probe.atomCount(0), size_t(2));
+    QCOMPARE(probe.atomCount(1), size_t(1));
+    QCOMPARE(probe.names(), std::vector<std::string>({"hydrogen", "helium"}));
+
+    // every model of a pdb file is a molecule:
+    const QString pdbFile = writeFile("models.pdb",
+            "COMPND    WATER\n"
+            "MODEL        1\n"
+            "HETATM    1  O   HOH A   1       0.000   0.000   0.000  1.00  0.00           O\n"
+            "HETATM    2  H1  HOH A   1       0.960   0.000   0.000  1.00  0.00           H\n"
+            "HETATM    3  H2  HOH A   1      -0.240   0.930   0.000  1.00  0.00           H\n"
+            "ENDMDL\n"
+            "MODEL        2\n"
+            "HETATM    1  O   HOH A   1       0.000   0.000   0.100  1.00  0.00           O\n"
+            "HETATM    2  H1  HOH A   1       0.960   0.000   0.100  1.00  0.00           H\n"
+            "HETATM    3  H2  HOH A   1      -0.240   0.930   0.100  1.00  0.00           H\n"
+            "ENDMDL\n"
+            "END\n");
+
+    QVERIFY(probe.probe(pdbFile));
+    QVERIFY(probe.isComplete());
+    QCOMPARE(probe.moleculeCount(), size_t(2));
+    QCOMPARE(probe.atomCount(0), size_t(3));
+    QCOMPARE(probe.atomCount(1), size_t(3));
+    QCOMPARE(probe.names(), std::vector<std::string>({"WATER", "WATER"}));
+
+    // the cached probe is used until the size or the modification time of
+    // the file changes. Both versions of the file have the same size:
+    const std::time_t modified = std::time(0) - 3600;
+    const QString cachedFile = writeFile("cached.xyz", "1\nfirst\nH 0.0 0.0 0.0\n");
+    boost::filesystem::last_write_time(cachedFile.toStdString(), modified);
+    QCOMPARE(MoleculeFileProbe::probeFile(cachedFile).name(0), std::string("first"));
+
+    writeFile("cached.xyz", "1\nfresh\nH 0.0 0.0 0.0\n");
+    boost::filesystem::last_write_time(cachedFile.toStdString(), modified);
+    QCOMPARE(MoleculeFileProbe::probeFile(cachedFile).name(0), std::string("first"));
+
+    boost::filesystem::last_write_time(cachedFile.toStdString(), modified + 60);
+    QCOMPARE(MoleculeFileProbe::probeFile(cachedFile).name(0), std::string("fresh"));
+
+    // an incomplete cached probe is only used if it covers enough molecules:
+    QCOMPARE(MoleculeFileProbe::probeFile(xyzFile, 1).moleculeCount(), size_t(1));
+    QVERIFY(!MoleculeFileProbe::probeFile(xyzFile, 1).isComplete());
+    QCOMPARE(MoleculeFileProbe::probeFile(xyzFile).moleculeCount(), size_t(3));
+    QVERIFY(MoleculeFileProbe::probeFile(xyzFile).isComplete());
+}
+
+void TestMolecule::test_xyzTrajectory()
+{
+    QTemporaryDir directory;
+    const QString fileName = directory.path() + "/water.xyz";
+
+    // three frames of an OH radical, every x coordinate is unique:
+    QFile file(fileName);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write("2\nframe 1\nO 0.100 0.200 0.300\n1 0.500 0.200 0.300\n"
+               "2\nframe 2\r\nO 1.100 0.200 0.300\n1 1.500 0.200 0.300\n"
+               "2\nframe 3\nO 2.100 0.200 0.300\n1 2.500 0.200 0.300\n\n");
+    file.close();
+
+    XyzTrajectory trajectory(2);
+    QVERIFY(trajectory.open(fileName));
+    QCOMPARE(trajectory.frameCount(), size_t(3));
+    QCOMPARE(trajectory.atomCount(), size_t(2));
+    QCOMPARE(trajectory.comment(0), std::string("frame 1"));
+    QCOMPARE(trajectory.comment(1), std::string("frame 2"));
+    QVERIFY_EXCEPTION_THROWN(trajectory.frame(3), std::out_of_range);
+
+    // the coordinates don't depend on the locale:
+    const bool commaLocale = useCommaLocale();
+    const Eigen::Matrix3Xd &first = trajectory.frame(0);
+    QCOMPARE(first(0, 0), 0.1);
+    QCOMPARE(first(0, 1), 0.5);
+    QCOMPARE(first(2, 1), 0.3);
+    if (commaLocale)
+        std::setlocale(LC_NUMERIC, "C");
+
+    // a cached frame is returned by reference, until it is evicted from the
+    // cache. To tell which frames are parsed again, the file is changed:
+    QCOMPARE(trajectory.frame(1)(0, 0), 1.1);
+    QCOMPARE(&trajectory.frame(0), &first);
+
+    QByteArray contents;
+    QVERIFY(file.open(QIODevice::ReadWrite));
+    contents = file.readAll();
+    contents.replace("0.100", "0.900");
+    contents.replace("1.100", "1.900");
+    file.seek(0);
+    file.write(contents);
+    file.close();
+
+    // frame 1 was used least recently, so it is evicted by frame 3:
+    QCOMPARE(trajectory.frame(2)(0, 0), 2.1);
+    QCOMPARE(trajectory.frame(0)(0, 0), 0.1);
+    QCOMPARE(trajectory.frame(1)(0, 0), 1.9);
+
+    // a new molecule from a single frame:
+    molconv::moleculePtr molecule = trajectory.createMolecule(2);
+    QCOMPARE(int(molecule->size()), 2);
+    QCOMPARE(int(molecule->atom(0)->atomicNumber()), 8);
+    QCOMPARE(int(molecule->atom(1)->atomicNumber()), 1);
+    QCOMPARE(molecule->name(), std::string("water"));
+    QVERIFY(molecule->positions().isApprox(trajectory.frame(2)));
+    QCOMPARE(molecule->origin()->code(), molconv::kCenterOfGeometry);
+
+    trajectory.close();
+
+    // all frames need the same number of atoms:
+    QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    file.write("2\nframe 1\nO 0.0 0.0 0.0\nH 1.0 0.0 0.0\n"
+               "1\nframe 2\nO 0.0 0.0 0.0\n");
+    file.close();
+
+    XyzTrajectory mismatched;
+    QVERIFY(!mismatched.open(fileName));
+    QVERIFY(mismatched.errorString().contains("frame 2"));
+    QCOMPARE(mismatched.frameCount(), size_t(0));
+
+    // invalid coordinates are only found when the frame is parsed:
+    QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    file.write("1\nframe 1\nO 0.0 0.0 0.0\n"
+               "1\nframe 2\nO 0,5 0.0 0.0\n");
+    file.close();
+
+    XyzTrajectory invalid;
+    QVERIFY(invalid.open(fileName));
+    QVERIFY_EXCEPTION_THROWN(invalid.frame(1), std::runtime_error);
+    QVERIFY_EXCEPTION_THROWN(invalid.frame(1), std::runtime_error);
+    QCOMPARE(invalid.frame(0)(0, 0), 0.0);
+
+    // as are unknown elements, which can't be turned into atoms:
+    QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    file.write("2\nframe 1\nO 0.0 0.0 0.0\nXx 1.0 0.0 0.0\n");
+    file.close();
+
+    XyzTrajectory unknown;
+    QVERIFY(unknown.open(fileName));
+    QVERIFY_EXCEPTION_THROWN(unknown.createMolecule(0), std::runtime_error);
+    QVERIFY_EXCEPTION_THROWN(unknown.molecule(), std::runtime_error);
+}
+
 QTEST_APPLESS_MAIN(TestMolecule)
@@ -32,11 +32,42 @@ class TestMolecule : public QObject
 
 private slots:
     void initTestCase();
+    void cleanup();
 
     void test_size();
     void test_center();
+    void test_positions();
+    void test_covarianceMatrix();
+    void test_propertyCache();
+    void test_concurrentReaders();
+    void test_moveMolecules();
+    void test_threadPool();
+    void test_orientation();
+    void test_rmsdMatrix();
+    void test_alignMoleculesTo();
+    void test_atomMask();
+    void test_bondPerceiver();
+    void test_setPositions();
+    void test_moleculeExporter();
+    void test_moleculeIndex();
+    void test_moleculeIds();
+    void test_systemSnapshot();
+    void test_spatialIndex();
+    void test_contactMonitor();
+    void test_readLegacySession();
+    void test_writeSession();
+    void test_binarySession();
+    void test_compressedSession();
+    void test_moleculeImporter();
+    void test_moleculeFileProbe();
+    void test_xyzTrajectory();
 
 private:
+    molconv::moleculePtr addMolecule();
+    molconv::moleculePtr addSessionMolecule();
+    static bool sameMolecule(const molconv::Molecule &first, const molconv::Molecule &second);
+    static bool useCommaLocale();
+
     molconv::Molecule mol;
 };
 